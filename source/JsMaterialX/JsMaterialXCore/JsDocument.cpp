@@ -28,6 +28,10 @@ EMSCRIPTEN_BINDINGS(document)
             mx::StringSet set = self.getReferencedSourceUris();
             return ems::val::array(set.begin(), set.end());
         }))
+        .function("addReferencedLibrary", &mx::Document::addReferencedLibrary)
+        .function("getReferencedLibraries", &mx::Document::getReferencedLibraries)
+        .function("clearReferencedLibraries", &mx::Document::clearReferencedLibraries)
+        .function("getReferencedLibraryChild", &mx::Document::getReferencedLibraryChild)
         BIND_MEMBER_FUNC("addNodeGraph", mx::Document, addNodeGraph, 0, 1, stRef)
         .function("getNodeGraph", &mx::Document::getNodeGraph)
         .function("getNodeGraphs", &mx::Document::getNodeGraphs)
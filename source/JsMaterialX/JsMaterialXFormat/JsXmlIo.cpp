@@ -29,11 +29,14 @@ EMSCRIPTEN_BINDINGS(xmlio)
                 }
             })
         .property("readComments", &mx::XmlReadOptions::readComments)
-        .property("parentXIncludes", &mx::XmlReadOptions::parentXIncludes);
+        .property("parentXIncludes", &mx::XmlReadOptions::parentXIncludes)
+        .property("shareXIncludes", &mx::XmlReadOptions::shareXIncludes)
+        .property("streaming", &mx::XmlReadOptions::streaming);
 
     ems::class_<mx::XmlWriteOptions>("XmlWriteOptions")
         .constructor<>()
-        .property("writeXIncludeEnable", &mx::XmlWriteOptions::writeXIncludeEnable);
+        .property("writeXIncludeEnable", &mx::XmlWriteOptions::writeXIncludeEnable)
+        .property("streaming", &mx::XmlWriteOptions::streaming);
 
     BIND_FUNC_RAW_PTR("_readFromXmlFile", mx::readFromXmlFile, 2, 4, mx::DocumentPtr, mx::FilePath,
         mx::FileSearchPath, const mx::XmlReadOptions*);
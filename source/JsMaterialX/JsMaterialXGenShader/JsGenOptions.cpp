@@ -33,6 +33,9 @@ EMSCRIPTEN_BINDINGS(GenOptions)
         .property("shaderInterfaceType", &mx::GenOptions::shaderInterfaceType)
         .property("fileTextureVerticalFlip", &mx::GenOptions::fileTextureVerticalFlip)
         .property("addUpstreamDependencies", &mx::GenOptions::addUpstreamDependencies)
+        .property("foldConstants", &mx::GenOptions::foldConstants)
+        .property("eliminateCommonSubexpressions", &mx::GenOptions::eliminateCommonSubexpressions)
+        .property("scopeConditionalBranches", &mx::GenOptions::scopeConditionalBranches)
         .property("hwTransparency", &mx::GenOptions::hwTransparency)
         .property("hwSpecularEnvironmentMethod", &mx::GenOptions::hwSpecularEnvironmentMethod)
         .property("hwDirectionalAlbedoMethod", &mx::GenOptions::hwDirectionalAlbedoMethod)
@@ -7,7 +7,12 @@
 
 #include <MaterialXCore/Util.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
 #include <mutex>
+#include <thread>
+#include <unordered_map>
 
 namespace MaterialX
 {
@@ -46,6 +51,89 @@ NodeDefPtr getShaderNodeDef(ElementPtr shaderRef)
     return NodeDefPtr();
 }
 
+// Append the given matches from a referenced library, skipping any that are
+// shadowed by elements of the same name in the document or in an earlier
+// library.
+template<class T> void appendLibraryMatches(const Document& doc,
+                                            const vector<shared_ptr<T>>& libraryMatches,
+                                            vector<shared_ptr<T>>& matches)
+{
+    for (const shared_ptr<T>& elem : libraryMatches)
+    {
+        const string qualifiedName = elem->getQualifiedName(elem->getName());
+        if (!doc.getChild(qualifiedName) &&
+            doc.getReferencedLibraryChild(qualifiedName) == elem &&
+            std::find(matches.begin(), matches.end(), elem) == matches.end())
+        {
+            matches.push_back(elem);
+        }
+    }
+}
+
+// Return the number of elements in the subtree rooted at the given element.
+size_t getSubtreeSize(const ElementPtr& elem)
+{
+    size_t size = 1;
+    for (const ElementPtr& child : elem->getChildren())
+    {
+        size += getSubtreeSize(child);
+    }
+    return size;
+}
+
+// Partition the descendants of the given element into subtrees of at most
+// the given size, where possible, appending their roots to the given vector.
+void partitionSubtrees(const ElementPtr& elem, size_t maxSize, vector<ElementPtr>& subtrees)
+{
+    for (const ElementPtr& child : elem->getChildren())
+    {
+        if (!child->getChildren().empty() && getSubtreeSize(child) > maxSize)
+        {
+            partitionSubtrees(child, maxSize, subtrees);
+        }
+        else
+        {
+            subtrees.push_back(child);
+        }
+    }
+}
+
+// The result of validating an element subtree in advance, on a worker
+// thread of a parallel validation.
+struct ValidationResult
+{
+    bool valid = true;
+    string message;
+    std::exception_ptr error;
+};
+using ValidationResultMap = std::unordered_map<const Element*, ValidationResult>;
+
+// The number of parallel validations that are combining subtree results,
+// allowing other validations to skip the per-thread lookup below.
+std::atomic<unsigned int> combiningValidationCount(0);
+
+// The subtree results being combined by a parallel validation on the
+// calling thread.
+thread_local const ValidationResultMap* threadValidationResults = nullptr;
+
+// Return true if the given document is the given library, or is reachable
+// through its referenced libraries.
+bool referencesDocument(const DocumentPtr& library, const Document* doc)
+{
+    if (library.get() == doc)
+    {
+        return true;
+    }
+    for (const DocumentPtr& nested : library->getReferencedLibraries())
+    {
+        if (referencesDocument(nested, doc))
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
 } // anonymous namespace
 
 //
@@ -72,79 +160,166 @@ class Document::Cache
 
     void refresh()
     {
+        // Lock-free fast path for the common case of a valid cache, which
+        // allows concurrent readers of a single document to proceed in parallel.
+        if (valid.load(std::memory_order_acquire))
+        {
+            return;
+        }
+
         // Thread synchronization for multiple concurrent readers of a single document.
         std::lock_guard<std::mutex> guard(mutex);
 
-        if (!valid)
+        if (!valid.load(std::memory_order_relaxed))
         {
             // Clear the existing cache.
+            clearNodeDefIndex();
             portElementMap.clear();
             nodeDefMap.clear();
             implementationMap.clear();
+            nodeGraphImplMap.clear();
 
             // Traverse the document to build a new cache.
             for (ElementPtr elem : doc.lock()->traverseTree())
             {
-                const string& nodeName = elem->getAttribute(PortElement::NODE_NAME_ATTRIBUTE);
-                const string& nodeString = elem->getAttribute(NodeDef::NODE_ATTRIBUTE);
-                const string& nodeDefString = elem->getAttribute(InterfaceElement::NODE_DEF_ATTRIBUTE);
+                updateElement(elem, true);
+            }
+
+            valid.store(true, std::memory_order_release);
+        }
+    }
 
-                if (!nodeName.empty())
+    // Add or remove the cache entries for the given element and its descendants.
+    // If the cache is not currently valid, then no action is taken, as the
+    // next refresh will rebuild it from scratch.
+    void updateTree(ElementPtr root, bool add)
+    {
+        std::lock_guard<std::mutex> guard(mutex);
+
+        clearNodeDefIndex();
+        if (valid.load(std::memory_order_relaxed))
+        {
+            for (ElementPtr elem : root->traverseTree())
+            {
+                updateElement(elem, add);
+            }
+
+            // Implementations may reference top-level node graphs by name.
+            NodeGraphPtr nodeGraph = root->asA<NodeGraph>();
+            if (nodeGraph && nodeGraph->getParent() && nodeGraph->getParent()->isA<Document>())
+            {
+                updateNodeGraphReferences(nodeGraph, add);
+            }
+        }
+    }
+
+    // Add or remove the cache entries for the given element alone.
+    void updateElement(ElementPtr elem, bool add)
+    {
+        const string& nodeName = elem->getAttribute(PortElement::NODE_NAME_ATTRIBUTE);
+        const string& nodeString = elem->getAttribute(NodeDef::NODE_ATTRIBUTE);
+        const string& nodeDefString = elem->getAttribute(InterfaceElement::NODE_DEF_ATTRIBUTE);
+
+        if (!nodeName.empty())
+        {
+            PortElementPtr portElem = elem->asA<PortElement>();
+            if (portElem)
+            {
+                updateEntry(portElementMap, portElem->getQualifiedName(nodeName), portElem, add);
+            }
+        }
+        if (!nodeString.empty())
+        {
+            NodeDefPtr nodeDef = elem->asA<NodeDef>();
+            if (nodeDef)
+            {
+                updateEntry(nodeDefMap, nodeDef->getQualifiedName(nodeString), nodeDef, add);
+            }
+        }
+        if (!nodeDefString.empty())
+        {
+            InterfaceElementPtr interface = elem->asA<InterfaceElement>();
+            if (interface)
+            {
+                if (interface->isA<NodeGraph>())
                 {
-                    PortElementPtr portElem = elem->asA<PortElement>();
-                    if (portElem)
-                    {
-                        portElementMap.emplace(portElem->getQualifiedName(nodeName), portElem);
-                    }
+                    updateEntry(implementationMap, interface->getQualifiedName(nodeDefString), interface, add);
                 }
-                if (!nodeString.empty())
+                ImplementationPtr impl = interface->asA<Implementation>();
+                if (impl)
                 {
-                    NodeDefPtr nodeDef = elem->asA<NodeDef>();
-                    if (nodeDef)
+                    // Check for implementation which specifies a nodegraph as the implementation
+                    const string& nodeGraphString = impl->getNodeGraph();
+                    if (!nodeGraphString.empty())
                     {
-                        nodeDefMap.emplace(nodeDef->getQualifiedName(nodeString), nodeDef);
+                        updateEntry(nodeGraphImplMap, nodeGraphString, impl, add);
+                        NodeGraphPtr nodeGraph = impl->getDocument()->getNodeGraph(nodeGraphString);
+                        if (nodeGraph)
+                            updateEntry(implementationMap, interface->getQualifiedName(nodeDefString), InterfaceElementPtr(nodeGraph), add);
                     }
-                }
-                if (!nodeDefString.empty())
-                {
-                    InterfaceElementPtr interface = elem->asA<InterfaceElement>();
-                    if (interface)
+                    else
                     {
-                        if (interface->isA<NodeGraph>())
-                        {
-                            implementationMap.emplace(interface->getQualifiedName(nodeDefString), interface);
-                        }
-                        ImplementationPtr impl = interface->asA<Implementation>();
-                        if (impl)
-                        {
-                            // Check for implementation which specifies a nodegraph as the implementation
-                            const string& nodeGraphString = impl->getNodeGraph();
-                            if (!nodeGraphString.empty())
-                            {
-                                NodeGraphPtr nodeGraph = impl->getDocument()->getNodeGraph(nodeGraphString);
-                                if (nodeGraph)
-                                    implementationMap.emplace(interface->getQualifiedName(nodeDefString), nodeGraph);
-                            }
-                            else
-                            {
-                                implementationMap.emplace(interface->getQualifiedName(nodeDefString), interface);
-                            }
-                        }
+                        updateEntry(implementationMap, interface->getQualifiedName(nodeDefString), interface, add);
                     }
                 }
             }
+        }
+    }
+
+    // Add or remove the implementation entries that resolve to the given
+    // top-level node graph through a nodegraph reference.
+    void updateNodeGraphReferences(NodeGraphPtr nodeGraph, bool add)
+    {
+        auto keyRange = nodeGraphImplMap.equal_range(nodeGraph->getName());
+        for (auto it = keyRange.first; it != keyRange.second; ++it)
+        {
+            ImplementationPtr impl = it->second;
+            updateEntry(implementationMap, impl->getQualifiedName(impl->getNodeDefString()), InterfaceElementPtr(nodeGraph), add);
+        }
+    }
 
-            valid = true;
+    // Clear all memoized nodedef resolutions.
+    void clearNodeDefIndex()
+    {
+        std::lock_guard<std::mutex> guard(nodeDefIndexMutex);
+        if (!nodeDefIndex.empty())
+        {
+            nodeDefIndex.clear();
+        }
+    }
+
+    template <class T> static void updateEntry(std::unordered_multimap<string, T>& map, const string& key, const T& value, bool add)
+    {
+        if (add)
+        {
+            map.emplace(key, value);
+            return;
+        }
+        auto keyRange = map.equal_range(key);
+        for (auto it = keyRange.first; it != keyRange.second; ++it)
+        {
+            if (it->second == value)
+            {
+                map.erase(it);
+                return;
+            }
         }
     }
 
   public:
     weak_ptr<Document> doc;
     std::mutex mutex;
-    bool valid;
+    std::atomic<bool> valid;
     std::unordered_multimap<string, PortElementPtr> portElementMap;
     std::unordered_multimap<string, NodeDefPtr> nodeDefMap;
     std::unordered_multimap<string, InterfaceElementPtr> implementationMap;
+    std::unordered_multimap<string, ImplementationPtr> nodeGraphImplMap;
+
+    // Memoized results of Node::getNodeDef, keyed by node signature.  This
+    // index is guarded by its own mutex, and is never locked while holding
+    // it, so that resolution misses may refresh the cache above.
+    std::mutex nodeDefIndexMutex;
+    std::unordered_map<string, NodeDefPtr> nodeDefIndex;
 };
 
 //
@@ -165,6 +340,7 @@ void Document::initialize()
 {
     _root = getSelf();
     _cache->doc = getDocument();
+    _libraries.clear();
 
     clearContent();
     setVersionIntegers(MATERIALX_MAJOR_VERSION, MATERIALX_MINOR_VERSION);
@@ -330,6 +506,11 @@ void Document::importLibrary(const ConstDocumentPtr& library)
             childCopy->setSourceUri(library->getSourceUri());
         }
     }
+
+    for (const DocumentPtr& nested : library->getReferencedLibraries())
+    {
+        addReferencedLibrary(nested);
+    }
 }
 
 StringSet Document::getReferencedSourceUris() const
@@ -342,9 +523,77 @@ StringSet Document::getReferencedSourceUris() const
             sourceUris.insert(elem->getSourceUri());
         }
     }
+    for (const DocumentPtr& library : _libraries)
+    {
+        if (library->hasSourceUri())
+        {
+            sourceUris.insert(library->getSourceUri());
+        }
+        StringSet librarySourceUris = library->getReferencedSourceUris();
+        sourceUris.insert(librarySourceUris.begin(), librarySourceUris.end());
+    }
     return sourceUris;
 }
 
+void Document::addReferencedLibrary(DocumentPtr library)
+{
+    if (!library)
+    {
+        return;
+    }
+    if (referencesDocument(library, this))
+    {
+        throw ExceptionFoundCycle("Cycle detected in referenced libraries of document: " + getSourceUri());
+    }
+    if (std::find(_libraries.begin(), _libraries.end(), library) == _libraries.end())
+    {
+        _libraries.push_back(library);
+        _cache->clearNodeDefIndex();
+    }
+}
+
+void Document::clearReferencedLibraries()
+{
+    _libraries.clear();
+    _cache->clearNodeDefIndex();
+}
+
+ElementPtr Document::getReferencedLibraryChild(const string& name) const
+{
+    for (const DocumentPtr& library : _libraries)
+    {
+        // Remove the library namespace from qualified names, matching the
+        // qualification applied by importLibrary.
+        ElementPtr child;
+        const string& space = library->getNamespace();
+        if (space.empty())
+        {
+            child = library->getChild(name);
+        }
+        else
+        {
+            const string prefix = space + NAME_PREFIX_SEPARATOR;
+            if (name.size() > prefix.size() && !name.compare(0, prefix.size(), prefix))
+            {
+                child = library->getChild(name.substr(prefix.size()));
+                if (!child)
+                {
+                    child = library->getChild(name);
+                }
+            }
+        }
+        if (!child)
+        {
+            child = library->getReferencedLibraryChild(name);
+        }
+        if (child)
+        {
+            return child;
+        }
+    }
+    return ElementPtr();
+}
+
 std::pair<int, int> Document::getVersionIntegers() const
 {
     if (!hasVersionString())
@@ -402,6 +651,12 @@ vector<NodeDefPtr> Document::getMatchingNodeDefs(const string& nodeName) const
         nodeDefs.push_back(it->second);
     }
 
+    // Append matches from referenced libraries.
+    for (const DocumentPtr& library : _libraries)
+    {
+        appendLibraryMatches(*this, library->getMatchingNodeDefs(nodeName), nodeDefs);
+    }
+
     // Return the matches.
     return nodeDefs;
 }
@@ -419,6 +674,12 @@ vector<InterfaceElementPtr> Document::getMatchingImplementations(const string& n
         implementations.push_back(it->second);
     }
 
+    // Append matches from referenced libraries.
+    for (const DocumentPtr& library : _libraries)
+    {
+        appendLibraryMatches(*this, library->getMatchingImplementations(nodeDef), implementations);
+    }
+
     // Return the matches.
     return implementations;
 }
@@ -430,6 +691,98 @@ bool Document::validate(string* message) const
     return GraphElement::validate(message) && res;
 }
 
+bool Element::applySubtreeValidation(const Element* subtree, bool& res, string* message)
+{
+    if (!combiningValidationCount.load(std::memory_order_relaxed) || !threadValidationResults)
+    {
+        return false;
+    }
+    auto it = threadValidationResults->find(subtree);
+    if (it == threadValidationResults->end())
+    {
+        return false;
+    }
+    const ValidationResult& result = it->second;
+    if (message)
+    {
+        *message += result.message;
+    }
+    if (result.error)
+    {
+        std::rethrow_exception(result.error);
+    }
+    res = result.valid && res;
+    return true;
+}
+
+bool Document::validateParallel(string* message, unsigned int threadCount) const
+{
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    // Partition the tree into subtrees, splitting any subtree that is larger
+    // than a fraction of each thread's share, so that work remains balanced
+    // when a few elements dominate the document.
+    vector<ElementPtr> subtrees;
+    ElementPtr root = getSelfNonConst();
+    const size_t SUBTREES_PER_THREAD = 8;
+    size_t maxSize = std::max(getSubtreeSize(root) / (threadCount * SUBTREES_PER_THREAD), (size_t) 1);
+    partitionSubtrees(root, maxSize, subtrees);
+    threadCount = (unsigned int) std::min((size_t) threadCount, subtrees.size());
+
+    if (threadCount <= 1)
+    {
+        return validate(message);
+    }
+
+    // Validate each subtree on a pool of threads.
+    ValidationResultMap results;
+    vector<ValidationResult*> subtreeResults;
+    for (const ElementPtr& subtree : subtrees)
+    {
+        subtreeResults.push_back(&results[subtree.get()]);
+    }
+    std::atomic<size_t> nextIndex(0);
+    auto validateSubtrees = [&]()
+    {
+        for (size_t i = nextIndex++; i < subtrees.size(); i = nextIndex++)
+        {
+            ValidationResult& result = *subtreeResults[i];
+            try
+            {
+                result.valid = subtrees[i]->validate(message ? &result.message : nullptr);
+            }
+            catch (...)
+            {
+                result.error = std::current_exception();
+            }
+        }
+    };
+    runWorkerThreads(threadCount, validateSubtrees);
+
+    // Validate the remaining elements in document order, combining the
+    // subtree results as they are reached.
+    const ValidationResultMap* previous = threadValidationResults;
+    threadValidationResults = &results;
+    combiningValidationCount++;
+    bool res = false;
+    try
+    {
+        res = validate(message);
+    }
+    catch (...)
+    {
+        combiningValidationCount--;
+        threadValidationResults = previous;
+        throw;
+    }
+    combiningValidationCount--;
+    threadValidationResults = previous;
+    return res;
+}
+
 void Document::upgradeVersion()
 {
     std::pair<int, int> versions = getVersionIntegers();
@@ -1456,7 +1809,93 @@ void Document::upgradeVersion()
 
 void Document::invalidateCache()
 {
-    _cache->valid = false;
+    _cache->valid.store(false, std::memory_order_release);
+    _cache->clearNodeDefIndex();
+}
+
+bool Document::isCacheAttribute(const string& attrib)
+{
+    return attrib == PortElement::NODE_NAME_ATTRIBUTE ||
+           attrib == NodeDef::NODE_ATTRIBUTE ||
+           attrib == InterfaceElement::NODE_DEF_ATTRIBUTE ||
+           attrib == Implementation::NODE_GRAPH_ATTRIBUTE ||
+           attrib == Element::NAMESPACE_ATTRIBUTE;
+}
+
+void Document::updateCache(ElementPtr elem, bool add)
+{
+    if (elem->isA<Document>())
+    {
+        invalidateCache();
+        return;
+    }
+    _cache->updateTree(elem, add);
+}
+
+void Document::updateCache(ElementPtr elem, const string& attrib, bool add)
+{
+    if (attrib == Element::NAMESPACE_ATTRIBUTE)
+    {
+        // Namespaces qualify the cache keys of all descendants.
+        updateCache(elem, add);
+        return;
+    }
+
+    std::lock_guard<std::mutex> guard(_cache->mutex);
+    _cache->clearNodeDefIndex();
+    if (_cache->valid.load(std::memory_order_relaxed))
+    {
+        _cache->updateElement(elem, add);
+    }
+}
+
+bool Document::isNodeDefIndexAttribute(const Element& elem, const string& attrib)
+{
+    if (attrib != TypedElement::TYPE_ATTRIBUTE &&
+        attrib != InterfaceElement::TARGET_ATTRIBUTE &&
+        attrib != InterfaceElement::VERSION_ATTRIBUTE &&
+        attrib != InterfaceElement::DEFAULT_VERSION_ATTRIBUTE &&
+        attrib != Element::INHERIT_ATTRIBUTE)
+    {
+        return false;
+    }
+
+    // Only the attributes of nodedefs and their ports affect resolution,
+    // as node attributes are part of each index key.
+    return isNodeDefIndexElement(elem);
+}
+
+bool Document::isNodeDefIndexElement(const Element& elem)
+{
+    if (elem.getCategory() == NodeDef::CATEGORY)
+    {
+        return true;
+    }
+    ConstElementPtr parent = elem.getParent();
+    return parent && parent->getCategory() == NodeDef::CATEGORY;
+}
+
+void Document::clearNodeDefIndex()
+{
+    _cache->clearNodeDefIndex();
+}
+
+bool Document::findNodeDefResolution(const string& key, NodeDefPtr& nodeDef) const
+{
+    std::lock_guard<std::mutex> guard(_cache->nodeDefIndexMutex);
+    auto it = _cache->nodeDefIndex.find(key);
+    if (it == _cache->nodeDefIndex.end())
+    {
+        return false;
+    }
+    nodeDef = it->second;
+    return true;
+}
+
+void Document::addNodeDefResolution(const string& key, NodeDefPtr nodeDef) const
+{
+    std::lock_guard<std::mutex> guard(_cache->nodeDefIndexMutex);
+    _cache->nodeDefIndex[key] = nodeDef;
 }
 
 } // namespace MaterialX
@@ -51,18 +51,59 @@ class MX_CORE_API Document : public GraphElement
     {
         DocumentPtr doc = createDocument<Document>();
         doc->copyContentFrom(getSelf());
+        doc->_libraries = _libraries;
         return doc;
     }
 
     /// Import the given document as a library within this document.
     /// The contents of the library document are copied into this one, and
-    /// are assigned the source URI of the library.
+    /// are assigned the source URI of the library.  Any libraries referenced
+    /// by the imported document are referenced by this document as well.
     /// @param library The library document to be imported.
     void importLibrary(const ConstDocumentPtr& library);
 
-    /// Get a list of source URI's referenced by the document
+    /// Get a list of source URI's referenced by the document, including
+    /// those of its referenced libraries.
     StringSet getReferencedSourceUris() const;
 
+    /// @name Referenced Libraries
+    /// @{
+
+    /// Add a reference to the given library document.  Rather than being
+    /// copied into this document, the elements of a referenced library remain
+    /// owned by the library, which may be shared between documents and should
+    /// not be modified while referenced.
+    ///
+    /// Definition lookups through getNodeDef, getTypeDef, getImplementation,
+    /// getMatchingNodeDefs and getMatchingImplementations, along with name
+    /// references resolved at the root scope of the document, fall through to
+    /// referenced libraries in the order they were added, for names that are
+    /// not found in this document.  Lookups made from library elements, such
+    /// as NodeDef::getImplementation, are resolved within their own library,
+    /// so each library should be self-contained.  Methods that return all
+    /// children of a given type, such as getNodeDefs, return only elements
+    /// owned by this document.
+    /// @param library The library document to be referenced.
+    /// @throws ExceptionFoundCycle if the library is this document, or
+    ///    references this document through its own referenced libraries.
+    void addReferencedLibrary(DocumentPtr library);
+
+    /// Return the vector of library documents referenced by this document.
+    const vector<DocumentPtr>& getReferencedLibraries() const
+    {
+        return _libraries;
+    }
+
+    /// Remove all library references from this document.
+    void clearReferencedLibraries();
+
+    /// Return the element, if any, with the given name at the root scope of
+    /// the libraries referenced by this document, searching nested library
+    /// references in order.  The name is qualified by the namespace of each
+    /// library, as it would be if the library were imported.
+    ElementPtr getReferencedLibraryChild(const string& name) const;
+
+    /// @}
     /// @name NodeGraph Elements
     /// @{
 
@@ -286,7 +327,8 @@ class MX_CORE_API Document : public GraphElement
     /// Return the TypeDef, if any, with the given name.
     TypeDefPtr getTypeDef(const string& name) const
     {
-        return getChildOfType<TypeDef>(name);
+        TypeDefPtr typeDef = getChildOfType<TypeDef>(name);
+        return typeDef ? typeDef : getReferencedLibraryChildOfType<TypeDef>(name);
     }
 
     /// Return a vector of all TypeDef elements in the document.
@@ -348,7 +390,8 @@ class MX_CORE_API Document : public GraphElement
     /// Return the NodeDef, if any, with the given name.
     NodeDefPtr getNodeDef(const string& name) const
     {
-        return getChildOfType<NodeDef>(name);
+        NodeDefPtr nodeDef = getChildOfType<NodeDef>(name);
+        return nodeDef ? nodeDef : getReferencedLibraryChildOfType<NodeDef>(name);
     }
 
     /// Return a vector of all NodeDef elements in the document.
@@ -511,7 +554,8 @@ class MX_CORE_API Document : public GraphElement
     /// Return the Implementation, if any, with the given name.
     ImplementationPtr getImplementation(const string& name) const
     {
-        return getChildOfType<Implementation>(name);
+        ImplementationPtr impl = getChildOfType<Implementation>(name);
+        return impl ? impl : getReferencedLibraryChildOfType<Implementation>(name);
     }
 
     /// Return a vector of all Implementation elements in the document.
@@ -659,6 +703,20 @@ class MX_CORE_API Document : public GraphElement
     /// @return True if the document passes all tests, false otherwise.
     bool validate(string* message = nullptr) const override;
 
+    /// Validate that the given document is consistent with the MaterialX
+    /// specification, distributing the work across a pool of threads.
+    /// The document tree is partitioned into independent subtrees, which are
+    /// validated concurrently, and their results are then combined in
+    /// document order.  Return values, messages and exceptions are identical
+    /// to those of validate.  The document must not be modified during
+    /// validation.
+    /// @param message An optional output string, to which a description of
+    ///    each error will be appended.
+    /// @param threadCount The number of threads to use.  If zero, then the
+    ///    hardware concurrency of the system is used.
+    /// @return True if the document passes all tests, false otherwise.
+    bool validateParallel(string* message = nullptr, unsigned int threadCount = 0) const;
+
     /// @}
     /// @name Utility
     /// @{
@@ -673,9 +731,55 @@ class MX_CORE_API Document : public GraphElement
     static const string CMS_ATTRIBUTE;
     static const string CMS_CONFIG_ATTRIBUTE;
 
+  private:
+    friend class Element;
+    friend class Node;
+
+    // Return the child of the given type, if any, with the given name at the
+    // root scope of the referenced libraries.
+    template<class T> shared_ptr<T> getReferencedLibraryChildOfType(const string& name) const
+    {
+        if (_libraries.empty())
+        {
+            return shared_ptr<T>();
+        }
+        ElementPtr child = getReferencedLibraryChild(name);
+        return child ? child->asA<T>() : shared_ptr<T>();
+    }
+
+    // Return true if the given attribute contributes to cached lookup data.
+    static bool isCacheAttribute(const string& attrib);
+
+    // Incrementally update cached lookup data as the given element and its
+    // descendants are added to or removed from the document.
+    void updateCache(ElementPtr elem, bool add);
+
+    // Incrementally update cached lookup data as the given cache attribute
+    // is added to or removed from the given element.
+    void updateCache(ElementPtr elem, const string& attrib, bool add);
+
+    // Return true if setting the given attribute on the given element may
+    // change the result of nodedef resolution within the document.
+    static bool isNodeDefIndexAttribute(const Element& elem, const string& attrib);
+
+    // Return true if the given element is a nodedef or a port of a nodedef,
+    // whose edits may change the result of nodedef resolution.
+    static bool isNodeDefIndexElement(const Element& elem);
+
+    // Clear all memoized nodedef resolutions.
+    void clearNodeDefIndex();
+
+    // Return true if a nodedef resolution has been memoized for the given
+    // node signature key, assigning it to the given nodedef.
+    bool findNodeDefResolution(const string& key, NodeDefPtr& nodeDef) const;
+
+    // Memoize the nodedef resolution for the given node signature key.
+    void addNodeDefResolution(const string& key, NodeDefPtr nodeDef) const;
+
   private:
     class Cache;
     std::unique_ptr<Cache> _cache;
+    vector<DocumentPtr> _libraries;
 };
 
 /// Create a new Document.
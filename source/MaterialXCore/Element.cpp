@@ -11,6 +11,11 @@
 
 #include <iterator>
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+#include <mutex>
+#include <unordered_set>
+#endif
+
 namespace MaterialX
 {
 
@@ -42,6 +47,22 @@ const string ValueElement::UNIFORM_ATTRIBUTE = "uniform";
 
 Element::CreatorMap Element::_creatorMap;
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+namespace {
+
+// Return the shared, interned copy of the given attribute name.
+const string* internAttributeName(const string& attrib)
+{
+    static std::mutex mutex;
+    static std::unordered_set<string> names;
+
+    std::lock_guard<std::mutex> guard(mutex);
+    return &*names.insert(attrib).first;
+}
+
+} // anonymous namespace
+#endif
+
 //
 // Element methods
 //
@@ -89,7 +110,12 @@ void Element::setName(const string& name)
         throw Exception("Element name is not unique at the given scope: " + name);
     }
 
-    getDocument()->invalidateCache();
+    // Node graphs may be referenced by name from implementations.
+    bool nodeGraph = isA<NodeGraph>();
+    if (nodeGraph)
+    {
+        getDocument()->updateCache(getSelf(), false);
+    }
 
     if (parent)
     {
@@ -97,6 +123,15 @@ void Element::setName(const string& name)
         parent->_childMap[name] = getSelf();
     }
     _name = name;
+
+    if (nodeGraph)
+    {
+        getDocument()->updateCache(getSelf(), true);
+    }
+    else if (Document::isNodeDefIndexElement(*this))
+    {
+        getDocument()->clearNodeDefIndex();
+    }
 }
 
 string Element::getNamePath(ConstElementPtr relativeTo) const
@@ -135,15 +170,15 @@ ElementPtr Element::getDescendant(const string& namePath) const
 
 void Element::registerChildElement(ElementPtr child)
 {
-    getDocument()->invalidateCache();
-
     _childMap[child->getName()] = child;
     _childOrder.push_back(child);
+
+    getDocument()->updateCache(child, true);
 }
 
 void Element::unregisterChildElement(ElementPtr child)
 {
-    getDocument()->invalidateCache();
+    getDocument()->updateCache(child, false);
 
     _childMap.erase(child->getName());
     _childOrder.erase(
@@ -192,36 +227,77 @@ void Element::removeChild(const string& name)
 
 void Element::setAttribute(const string& attrib, const string& value)
 {
-    getDocument()->invalidateCache();
+    bool cacheAttrib = Document::isCacheAttribute(attrib);
+    if (cacheAttrib)
+    {
+        getDocument()->updateCache(getSelf(), attrib, false);
+    }
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    AttributeVec::iterator it = findAttribute(attrib);
+    if (it != _attributes.end())
+    {
+        it->second = value;
+    }
+    else
+    {
+        _attributes.emplace_back(internAttributeName(attrib), value);
+    }
+#else
     if (!_attributeMap.count(attrib))
     {
         _attributeOrder.push_back(attrib);
     }
     _attributeMap[attrib] = value;
+#endif
+
+    if (cacheAttrib)
+    {
+        getDocument()->updateCache(getSelf(), attrib, true);
+    }
+    else if (Document::isNodeDefIndexAttribute(*this, attrib))
+    {
+        getDocument()->clearNodeDefIndex();
+    }
 }
 
 void Element::removeAttribute(const string& attrib)
 {
-    StringMap::iterator it = _attributeMap.find(attrib);
-    if (it != _attributeMap.end())
+    if (hasAttribute(attrib))
     {
-        getDocument()->invalidateCache();
+        bool cacheAttrib = Document::isCacheAttribute(attrib);
+        if (cacheAttrib)
+        {
+            getDocument()->updateCache(getSelf(), attrib, false);
+        }
 
-        _attributeMap.erase(it);
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+        _attributes.erase(findAttribute(attrib));
+#else
+        _attributeMap.erase(attrib);
         _attributeOrder.erase(
             std::find(_attributeOrder.begin(), _attributeOrder.end(), attrib));
+#endif
+
+        if (cacheAttrib)
+        {
+            getDocument()->updateCache(getSelf(), attrib, true);
+        }
+        else if (Document::isNodeDefIndexAttribute(*this, attrib))
+        {
+            getDocument()->clearNodeDefIndex();
+        }
     }
 }
 
 template<class T> shared_ptr<T> Element::asA()
 {
-    return std::dynamic_pointer_cast<T>(getSelf());
+    return isInstanceOf<T>() ? std::static_pointer_cast<T>(getSelf()) : shared_ptr<T>();
 }
 
 template<class T> shared_ptr<const T> Element::asA() const
 {
-    return std::dynamic_pointer_cast<const T>(getSelf());
+    return isInstanceOf<T>() ? std::static_pointer_cast<const T>(getSelf()) : shared_ptr<const T>();
 }
 
 ElementPtr Element::addChildOfCategory(const string& category, string name)
@@ -309,6 +385,17 @@ ConstDocumentPtr Element::getDocument() const
     return getRoot()->asA<Document>();
 }
 
+ElementPtr Element::resolveLibraryNameReference(const string& name) const
+{
+    ConstDocumentPtr doc = getDocument();
+    if (!doc || doc->getReferencedLibraries().empty())
+    {
+        return ElementPtr();
+    }
+    ElementPtr child = doc->getReferencedLibraryChild(getQualifiedName(name));
+    return child ? child : doc->getReferencedLibraryChild(name);
+}
+
 bool Element::hasInheritedBase(ConstElementPtr base) const
 {
     for (ConstElementPtr elem : traverseInheritance())
@@ -361,11 +448,18 @@ InheritanceIterator Element::traverseInheritance() const
 
 void Element::copyContentFrom(const ConstElementPtr& source)
 {
-    getDocument()->invalidateCache();
+    DocumentPtr doc = getDocument();
+    doc->updateCache(getSelf(), false);
 
     _sourceUri = source->_sourceUri;
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    _attributes = source->_attributes;
+#else
     _attributeMap = source->_attributeMap;
     _attributeOrder = source->_attributeOrder;
+#endif
+
+    doc->updateCache(getSelf(), true);
 
     for (auto child : source->getChildren())
     {
@@ -386,11 +480,15 @@ void Element::copyContentFrom(const ConstElementPtr& source)
 
 void Element::clearContent()
 {
-    getDocument()->invalidateCache();
+    getDocument()->updateCache(getSelf(), false);
 
     _sourceUri.clear();
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    _attributes.clear();
+#else
     _attributeMap.clear();
     _attributeOrder.clear();
+#endif
     _childMap.clear();
     _childOrder.clear();
 }
@@ -404,9 +502,12 @@ bool Element::validate(string* message) const
         bool validInherit = getInheritsFrom() && getInheritsFrom()->getCategory() == getCategory();
         validateRequire(validInherit, res, message, "Invalid element inheritance");
     }
-    for (auto child : getChildren())
+    for (const ElementPtr& child : getChildren())
     {
-        res = child->validate(message) && res;
+        if (!applySubtreeValidation(child.get(), res, message))
+        {
+            res = child->validate(message) && res;
+        }
     }
     validateRequire(!hasInheritanceCycle(), res, message, "Cycle in element inheritance chain");
     return res;
@@ -660,6 +761,62 @@ string prettyPrint(ConstElementPtr elem)
     return text;
 }
 
+uint64_t Element::computeClassMask(const Element* elem)
+{
+    uint64_t mask = 0;
+
+#define ADD_CLASS_BIT(T)                            \
+    if (dynamic_cast<const T*>(elem))               \
+    {                                               \
+        mask |= ElementClassBit<T>::value;          \
+    }
+
+    ADD_CLASS_BIT(Element)
+    ADD_CLASS_BIT(TypedElement)
+    ADD_CLASS_BIT(ValueElement)
+    ADD_CLASS_BIT(PortElement)
+    ADD_CLASS_BIT(InterfaceElement)
+    ADD_CLASS_BIT(GraphElement)
+    ADD_CLASS_BIT(GeomElement)
+    ADD_CLASS_BIT(AttributeDef)
+    ADD_CLASS_BIT(Backdrop)
+    ADD_CLASS_BIT(Collection)
+    ADD_CLASS_BIT(CommentElement)
+    ADD_CLASS_BIT(Document)
+    ADD_CLASS_BIT(GenericElement)
+    ADD_CLASS_BIT(GeomInfo)
+    ADD_CLASS_BIT(GeomProp)
+    ADD_CLASS_BIT(GeomPropDef)
+    ADD_CLASS_BIT(Implementation)
+    ADD_CLASS_BIT(Input)
+    ADD_CLASS_BIT(Look)
+    ADD_CLASS_BIT(LookGroup)
+    ADD_CLASS_BIT(MaterialAssign)
+    ADD_CLASS_BIT(Member)
+    ADD_CLASS_BIT(Node)
+    ADD_CLASS_BIT(NodeDef)
+    ADD_CLASS_BIT(NodeGraph)
+    ADD_CLASS_BIT(Output)
+    ADD_CLASS_BIT(Property)
+    ADD_CLASS_BIT(PropertyAssign)
+    ADD_CLASS_BIT(PropertySet)
+    ADD_CLASS_BIT(PropertySetAssign)
+    ADD_CLASS_BIT(TargetDef)
+    ADD_CLASS_BIT(Token)
+    ADD_CLASS_BIT(TypeDef)
+    ADD_CLASS_BIT(Unit)
+    ADD_CLASS_BIT(UnitDef)
+    ADD_CLASS_BIT(UnitTypeDef)
+    ADD_CLASS_BIT(Variant)
+    ADD_CLASS_BIT(VariantAssign)
+    ADD_CLASS_BIT(VariantSet)
+    ADD_CLASS_BIT(Visibility)
+
+#undef ADD_CLASS_BIT
+
+    return mask;
+}
+
 //
 // Element registry class
 //
@@ -15,6 +15,8 @@
 #include <MaterialXCore/Util.h>
 #include <MaterialXCore/Value.h>
 
+#include <type_traits>
+
 namespace MaterialX
 {
 
@@ -66,6 +68,68 @@ using ElementMap = std::unordered_map<string, ElementPtr>;
 /// A standard function taking an ElementPtr and returning a boolean.
 using ElementPredicate = std::function<bool(ConstElementPtr)>;
 
+template <class T> class ChildRange;
+
+/// @cond internal
+// The bit that identifies each built-in element class in the class mask of an
+// element, allowing subclass checks without a dynamic cast.  Classes without
+// a bit, such as client subclasses, are checked with a dynamic cast.
+template <class T> struct ElementClassBit
+{
+    static const uint64_t value = 0;
+};
+
+#define MATERIALX_ELEMENT_CLASS_BIT(T, index)          \
+class T;                                               \
+template <> struct ElementClassBit<T>                  \
+{                                                      \
+    static const uint64_t value = uint64_t(1) << index; \
+};
+
+MATERIALX_ELEMENT_CLASS_BIT(Element, 0)
+MATERIALX_ELEMENT_CLASS_BIT(TypedElement, 1)
+MATERIALX_ELEMENT_CLASS_BIT(ValueElement, 2)
+MATERIALX_ELEMENT_CLASS_BIT(PortElement, 3)
+MATERIALX_ELEMENT_CLASS_BIT(InterfaceElement, 4)
+MATERIALX_ELEMENT_CLASS_BIT(GraphElement, 5)
+MATERIALX_ELEMENT_CLASS_BIT(GeomElement, 6)
+MATERIALX_ELEMENT_CLASS_BIT(AttributeDef, 7)
+MATERIALX_ELEMENT_CLASS_BIT(Backdrop, 8)
+MATERIALX_ELEMENT_CLASS_BIT(Collection, 9)
+MATERIALX_ELEMENT_CLASS_BIT(CommentElement, 10)
+MATERIALX_ELEMENT_CLASS_BIT(Document, 11)
+MATERIALX_ELEMENT_CLASS_BIT(GenericElement, 12)
+MATERIALX_ELEMENT_CLASS_BIT(GeomInfo, 13)
+MATERIALX_ELEMENT_CLASS_BIT(GeomProp, 14)
+MATERIALX_ELEMENT_CLASS_BIT(GeomPropDef, 15)
+MATERIALX_ELEMENT_CLASS_BIT(Implementation, 16)
+MATERIALX_ELEMENT_CLASS_BIT(Input, 17)
+MATERIALX_ELEMENT_CLASS_BIT(Look, 18)
+MATERIALX_ELEMENT_CLASS_BIT(LookGroup, 19)
+MATERIALX_ELEMENT_CLASS_BIT(MaterialAssign, 20)
+MATERIALX_ELEMENT_CLASS_BIT(Member, 21)
+MATERIALX_ELEMENT_CLASS_BIT(Node, 22)
+MATERIALX_ELEMENT_CLASS_BIT(NodeDef, 23)
+MATERIALX_ELEMENT_CLASS_BIT(NodeGraph, 24)
+MATERIALX_ELEMENT_CLASS_BIT(Output, 25)
+MATERIALX_ELEMENT_CLASS_BIT(Property, 26)
+MATERIALX_ELEMENT_CLASS_BIT(PropertyAssign, 27)
+MATERIALX_ELEMENT_CLASS_BIT(PropertySet, 28)
+MATERIALX_ELEMENT_CLASS_BIT(PropertySetAssign, 29)
+MATERIALX_ELEMENT_CLASS_BIT(TargetDef, 30)
+MATERIALX_ELEMENT_CLASS_BIT(Token, 31)
+MATERIALX_ELEMENT_CLASS_BIT(TypeDef, 32)
+MATERIALX_ELEMENT_CLASS_BIT(Unit, 33)
+MATERIALX_ELEMENT_CLASS_BIT(UnitDef, 34)
+MATERIALX_ELEMENT_CLASS_BIT(UnitTypeDef, 35)
+MATERIALX_ELEMENT_CLASS_BIT(Variant, 36)
+MATERIALX_ELEMENT_CLASS_BIT(VariantAssign, 37)
+MATERIALX_ELEMENT_CLASS_BIT(VariantSet, 38)
+MATERIALX_ELEMENT_CLASS_BIT(Visibility, 39)
+
+#undef MATERIALX_ELEMENT_CLASS_BIT
+/// @endcond
+
 /// @class Element
 /// The base class for MaterialX elements.
 ///
@@ -78,7 +142,8 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
         _category(category),
         _name(name),
         _parent(parent),
-        _root(parent ? parent->getRoot() : nullptr)
+        _root(parent ? parent->getRoot() : nullptr),
+        _classMask(0)
     {
     }
   public:
@@ -374,7 +439,7 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     /// matches are required.
     template<class T> bool isA(const string& category = EMPTY_STRING) const
     {
-        if (!asA<T>())
+        if (!isInstanceOf<T>())
             return false;
         if (!category.empty() && getCategory() != category)
             return false;
@@ -448,18 +513,30 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     template<class T> vector< shared_ptr<T> > getChildrenOfType(const string& category = EMPTY_STRING) const
     {
         vector< shared_ptr<T> > children;
-        for (ElementPtr child : _childOrder)
+        for (const ElementPtr& child : _childOrder)
         {
-            shared_ptr<T> instance = child->asA<T>();
-            if (!instance)
-                continue;
-            if (!category.empty() && child->getCategory() != category)
-                continue;
-            children.push_back(instance);
+            if (child->isA<T>(category))
+            {
+                children.push_back(std::static_pointer_cast<T>(child));
+            }
         }
         return children;
     }
 
+    /// Return a lightweight range over all child elements that are instances
+    /// of the given subclass, optionally filtered by the given category string.
+    /// Unlike getChildrenOfType, no vector is allocated, and children are
+    /// filtered lazily as the range is iterated.  The range is invalidated if
+    /// children are added to or removed from this element.
+    /// @details Example usage:
+    /// @code
+    /// for (InputPtr input : node->traverseChildrenOfType<Input>())
+    /// {
+    ///     cout << input->asString() << endl;
+    /// }
+    /// @endcode
+    template<class T> ChildRange<T> traverseChildrenOfType(const string& category = EMPTY_STRING) const;
+
     /// Set the index of the child, if any, with the given name.
     /// If the given index is out of bounds, then an exception is thrown.
     void setChildIndex(const string& name, int index);
@@ -487,6 +564,33 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     /// Set the value string of the given attribute.
     void setAttribute(const string& attrib, const string& value);
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    /// Return true if the given attribute is present.
+    bool hasAttribute(const string& attrib) const
+    {
+        return findAttribute(attrib) != _attributes.end();
+    }
+
+    /// Return the value string of the given attribute.  If the given attribute
+    /// is not present, then an empty string is returned.
+    const string& getAttribute(const string& attrib) const
+    {
+        AttributeVec::const_iterator it = findAttribute(attrib);
+        return (it != _attributes.end()) ? it->second : EMPTY_STRING;
+    }
+
+    /// Return a vector of stored attribute names, in the order they were set.
+    StringVec getAttributeNames() const
+    {
+        StringVec names;
+        names.reserve(_attributes.size());
+        for (const Attribute& attr : _attributes)
+        {
+            names.push_back(*attr.first);
+        }
+        return names;
+    }
+#else
     /// Return true if the given attribute is present.
     bool hasAttribute(const string& attrib) const
     {
@@ -506,6 +610,7 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     {
         return _attributeOrder;
     }
+#endif
 
     /// Set the value of an implicitly typed attribute.  Since an attribute
     /// stores no explicit type, the same type argument must be used in
@@ -779,12 +884,23 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     string asString() const;
 
     /// Resolve a reference to a named element at the root scope of this document,
-    /// taking the namespace at the scope of this element into account.
+    /// taking the namespace at the scope of this element into account.  If no
+    /// such element is found, then the libraries referenced by the document
+    /// are searched.
     template<class T> shared_ptr<T> resolveRootNameReference(const string& name) const
     {
         ConstElementPtr root = getRoot();
         shared_ptr<T> child = root->getChildOfType<T>(getQualifiedName(name));
-        return child ? child : root->getChildOfType<T>(name);
+        if (!child)
+        {
+            child = root->getChildOfType<T>(name);
+        }
+        if (!child)
+        {
+            ElementPtr libraryChild = resolveLibraryNameReference(name);
+            child = libraryChild ? libraryChild->asA<T>() : shared_ptr<T>();
+        }
+        return child;
     }
 
     /// @}
@@ -794,6 +910,16 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     // state and optional output text if the requirement is not met.
     void validateRequire(bool expression, bool& res, string* message, string errorDesc) const;
 
+    // Resolve a reference to a named element at the root scope of the
+    // libraries referenced by this document.
+    ElementPtr resolveLibraryNameReference(const string& name) const;
+
+  private:
+    // If the given subtree was validated in advance by a parallel validation
+    // on the calling thread, combine its result with the validation state
+    // and optional output text, and return true.  Defined in Document.cpp.
+    static bool applySubtreeValidation(const Element* subtree, bool& res, string* message);
+
   public:
     static const string NAME_ATTRIBUTE;
     static const string FILE_PREFIX_ATTRIBUTE;
@@ -814,6 +940,24 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
         return std::const_pointer_cast<Element>(shared_from_this());
     }
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    // Compact attribute storage, pairing an interned attribute name with
+    // its value, in the order that attributes were set.
+    using Attribute = std::pair<const string*, string>;
+    using AttributeVec = vector<Attribute>;
+
+    AttributeVec::const_iterator findAttribute(const string& attrib) const
+    {
+        return std::find_if(_attributes.begin(), _attributes.end(),
+            [&attrib](const Attribute& attr) { return *attr.first == attrib; });
+    }
+    AttributeVec::iterator findAttribute(const string& attrib)
+    {
+        return std::find_if(_attributes.begin(), _attributes.end(),
+            [&attrib](const Attribute& attr) { return *attr.first == attrib; });
+    }
+#endif
+
   protected:
     string _category;
     string _name;
@@ -822,16 +966,56 @@ class MX_CORE_API Element : public std::enable_shared_from_this<Element>
     ElementMap _childMap;
     vector<ElementPtr> _childOrder;
 
+#ifdef MATERIALX_COMPACT_ATTRIBUTES
+    AttributeVec _attributes;
+#else
     StringMap _attributeMap;
     StringVec _attributeOrder;
+#endif
 
     weak_ptr<Element> _parent;
     weak_ptr<Element> _root;
 
   private:
+    uint64_t _classMask;
+
+  private:
+    template <class T> static shared_ptr<T> makeElement(ElementPtr parent, const string& name);
+
+    // Return true if this element is an instance of the given subclass,
+    // using the class mask assigned at creation when available.
+    template <class T> bool isInstanceOf() const
+    {
+        const uint64_t bit = ElementClassBit<T>::value;
+        if (bit && _classMask)
+        {
+            return (_classMask & bit) != 0;
+        }
+        return isDerivedInstanceOf<T>(std::is_base_of<T, Element>());
+    }
+
+    // Every element is an instance of Element and its base classes.
+    template <class T> bool isDerivedInstanceOf(std::true_type) const
+    {
+        return true;
+    }
+    template <class T> bool isDerivedInstanceOf(std::false_type) const
+    {
+        return dynamic_cast<const T*>(this) != nullptr;
+    }
+
+    // Return the mask of built-in classes of which the given element is an
+    // instance, computing it once for each concrete class.
+    template <class T> static uint64_t getClassMask(const T* elem)
+    {
+        static const uint64_t mask = computeClassMask(elem);
+        return mask;
+    }
+    static uint64_t computeClassMask(const Element* elem);
+
     template <class T> static ElementPtr createElement(ElementPtr parent, const string& name)
     {
-        return std::make_shared<T>(parent, name);
+        return makeElement<T>(parent, name);
     }
 
   private:
@@ -1323,12 +1507,130 @@ template<class T> shared_ptr<T> Element::addChild(const string& name)
     if (_childMap.count(childName))
         throw Exception("Child name is not unique: " + childName);
 
-    shared_ptr<T> child = std::make_shared<T>(getSelf(), childName);
+    shared_ptr<T> child = makeElement<T>(getSelf(), childName);
     registerChildElement(child);
 
     return child;
 }
 
+template <class T> shared_ptr<T> Element::makeElement(ElementPtr parent, const string& name)
+{
+    shared_ptr<T> elem = std::make_shared<T>(parent, name);
+    elem->_classMask = getClassMask<T>(elem.get());
+    return elem;
+}
+
+/// @class ChildIterator
+/// An iterator over the children of an element that are instances of a
+/// given subclass, optionally filtered by category.
+template <class T> class ChildIterator
+{
+  public:
+    using BaseIterator = vector<ElementPtr>::const_iterator;
+
+    ChildIterator(BaseIterator it, BaseIterator end, const string& category) :
+        _it(it),
+        _end(end),
+        _category(category)
+    {
+        skipUnmatched();
+    }
+    ~ChildIterator() { }
+
+    bool operator==(const ChildIterator& rhs) const
+    {
+        return _it == rhs._it;
+    }
+    bool operator!=(const ChildIterator& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+    /// Dereference this iterator, returning the current child.
+    shared_ptr<T> operator*() const
+    {
+        return std::static_pointer_cast<T>(*_it);
+    }
+
+    /// Iterate to the next matching child.
+    ChildIterator& operator++()
+    {
+        ++_it;
+        skipUnmatched();
+        return *this;
+    }
+
+  private:
+    void skipUnmatched()
+    {
+        while (_it != _end && !(*_it)->template isA<T>(_category))
+        {
+            ++_it;
+        }
+    }
+
+  private:
+    BaseIterator _it;
+    BaseIterator _end;
+    string _category;
+};
+
+/// @class ChildRange
+/// A range over the children of an element that are instances of a given
+/// subclass, optionally filtered by category.  The range holds a reference
+/// to its parent element, so it may be safely constructed from a temporary
+/// shared pointer.
+template <class T> class ChildRange
+{
+  public:
+    ChildRange(ConstElementPtr parent, const string& category) :
+        _parent(parent),
+        _category(category)
+    {
+    }
+    ~ChildRange() { }
+
+    /// Return an iterator to the first matching child.
+    ChildIterator<T> begin() const
+    {
+        const vector<ElementPtr>& children = _parent->getChildren();
+        return ChildIterator<T>(children.begin(), children.end(), _category);
+    }
+
+    /// Return the end iterator of the range.
+    ChildIterator<T> end() const
+    {
+        const vector<ElementPtr>& children = _parent->getChildren();
+        return ChildIterator<T>(children.end(), children.end(), _category);
+    }
+
+    /// Return true if the range contains no children.
+    bool empty() const
+    {
+        return begin() == end();
+    }
+
+    /// Return the number of children in the range.
+    size_t size() const
+    {
+        size_t count = 0;
+        for (ChildIterator<T> it = begin(); it != end(); ++it)
+        {
+            count++;
+        }
+        return count;
+    }
+
+  private:
+    ConstElementPtr _parent;
+    string _category;
+};
+
+template<class T> ChildRange<T> Element::traverseChildrenOfType(const string& category) const
+{
+    return ChildRange<T>(getSelf(), category);
+}
+
 /// Given two target strings, each containing a string array of target names,
 /// return true if they have any targets in common.  An empty target string
 /// matches all targets.
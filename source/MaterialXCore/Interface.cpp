@@ -428,12 +428,17 @@ InputPtr InterfaceElement::getActiveInput(const string& name) const
 
 vector<InputPtr> InterfaceElement::getActiveInputs() const
 {
+    // Child names are unique, so without inheritance no filtering is needed.
+    if (!hasInheritString())
+    {
+        return getInputs();
+    }
+
     vector<InputPtr> activeInputs;
     StringSet activeInputNamesSet;
     for (ConstElementPtr elem : traverseInheritance())
     {
-        vector<InputPtr> inputs = elem->asA<InterfaceElement>()->getInputs();
-        for (const InputPtr& input : inputs)
+        for (InputPtr input : elem->asA<InterfaceElement>()->traverseInputs())
         {
             if (input && activeInputNamesSet.insert(input->getName()).second)
             {
@@ -460,12 +465,16 @@ OutputPtr InterfaceElement::getActiveOutput(const string& name) const
 
 vector<OutputPtr> InterfaceElement::getActiveOutputs() const
 {
+    if (!hasInheritString())
+    {
+        return getOutputs();
+    }
+
     vector<OutputPtr> activeOutputs;
     StringSet activeOutputNamesSet;
     for (ConstElementPtr elem : traverseInheritance())
     {
-        vector<OutputPtr> outputs = elem->asA<InterfaceElement>()->getOutputs();
-        for (const OutputPtr& output : outputs)
+        for (OutputPtr output : elem->asA<InterfaceElement>()->traverseOutputs())
         {
             if (output && activeOutputNamesSet.insert(output->getName()).second)
             {
@@ -550,12 +559,16 @@ ValueElementPtr InterfaceElement::getActiveValueElement(const string& name) cons
 
 vector<ValueElementPtr> InterfaceElement::getActiveValueElements() const
 {
+    if (!hasInheritString())
+    {
+        return getChildrenOfType<ValueElement>();
+    }
+
     vector<ValueElementPtr> activeValueElems;
     StringSet activeValueElemNamesSet;
     for (ConstElementPtr interface : traverseInheritance())
     {
-        vector<ValueElementPtr> valueElems = interface->getChildrenOfType<ValueElement>();
-        for (const ValueElementPtr& valueElem : valueElems)
+        for (ValueElementPtr valueElem : interface->traverseChildrenOfType<ValueElement>())
         {
             if (valueElem && activeValueElemNamesSet.insert(valueElem->getName()).second)
             {
@@ -388,6 +388,13 @@ class MX_CORE_API InterfaceElement : public TypedElement
         return getChildrenOfType<Input>();
     }
 
+    /// Return a lightweight range over all Input elements, as an
+    /// allocation-free alternative to getInputs.
+    ChildRange<Input> traverseInputs() const
+    {
+        return traverseChildrenOfType<Input>();
+    }
+
     /// Return the number of Input elements.
     size_t getInputCount() const
     {
@@ -438,6 +445,13 @@ class MX_CORE_API InterfaceElement : public TypedElement
         return getChildrenOfType<Output>();
     }
 
+    /// Return a lightweight range over all Output elements, as an
+    /// allocation-free alternative to getOutputs.
+    ChildRange<Output> traverseOutputs() const
+    {
+        return traverseChildrenOfType<Output>();
+    }
+
     /// Return the number of Output elements.
     size_t getOutputCount() const
     {
@@ -7,6 +7,10 @@
 
 #include <MaterialXCore/Document.h>
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 namespace MaterialX
 {
 
@@ -47,6 +51,30 @@ vector<MaterialAssignPtr> getGeometryBindings(const NodePtr& materialNode, const
     return matAssigns;
 }
 
+vector<GeomAssigns> resolveGeomAssigns(LookPtr look, const StringVec& geoms, unsigned int threadCount)
+{
+    return GeomAssignIndex(LookVec(1, look)).resolve(geoms, threadCount);
+}
+
+vector<GeomAssigns> resolveGeomAssigns(LookGroupPtr lookGroup, const StringVec& geoms, unsigned int threadCount)
+{
+    string lookName = lookGroup->getActiveLook();
+    if (lookName.empty())
+    {
+        StringVec lookNames = splitString(lookGroup->getLooks(), ARRAY_VALID_SEPARATORS);
+        if (!lookNames.empty())
+        {
+            lookName = lookNames[0];
+        }
+    }
+    LookPtr look = lookGroup->getDocument()->getLook(lookName);
+    if (!look)
+    {
+        throw Exception("Look group does not reference a valid look: " + lookGroup->getName());
+    }
+    return resolveGeomAssigns(look, geoms, threadCount);
+}
+
 //
 // Look methods
 //
@@ -158,4 +186,281 @@ vector<VariantAssignPtr> MaterialAssign::getActiveVariantAssigns() const
     return activeAssigns;
 }
 
+//
+// GeomAssignIndex methods
+//
+
+GeomAssignIndex::GeomAssignIndex(const LookVec& looks) :
+    _nodes(1)
+{
+    for (LookPtr look : looks)
+    {
+        for (MaterialAssignPtr assign : look->getActiveMaterialAssigns())
+        {
+            addAssign(assign, MATERIAL_ASSIGN, assign->getActiveGeom(), assign->getCollection());
+        }
+        for (PropertyAssignPtr assign : look->getActivePropertyAssigns())
+        {
+            string geom = assign->hasGeom() ?
+                          assign->createStringResolver()->resolve(assign->getGeom(), GEOMNAME_TYPE_STRING) :
+                          EMPTY_STRING;
+            addAssign(assign, PROPERTY_ASSIGN, geom, assign->getCollection());
+        }
+        for (PropertySetAssignPtr assign : look->getActivePropertySetAssigns())
+        {
+            addAssign(assign, PROPERTY_SET_ASSIGN, assign->getActiveGeom(), assign->getCollection());
+        }
+        for (VisibilityPtr visibility : look->getActiveVisibilities())
+        {
+            addAssign(visibility, VISIBILITY, visibility->getActiveGeom(), visibility->getCollection());
+        }
+    }
+
+    // Gather the includes below each node.  Children are always stored after
+    // their parents, so a reverse sweep visits each node after its children.
+    for (size_t i = _nodes.size(); i-- > 0;)
+    {
+        vector<size_t>& descendants = _nodes[i].descendantIncludes;
+        std::sort(descendants.begin(), descendants.end());
+        descendants.erase(std::unique(descendants.begin(), descendants.end()), descendants.end());
+        if (i > 0)
+        {
+            vector<size_t>& parentDescendants = _nodes[_nodes[i].parent].descendantIncludes;
+            parentDescendants.insert(parentDescendants.end(), _nodes[i].includes.begin(), _nodes[i].includes.end());
+            parentDescendants.insert(parentDescendants.end(), descendants.begin(), descendants.end());
+        }
+    }
+}
+
+GeomAssigns GeomAssignIndex::resolve(const string& geom) const
+{
+    GeomAssigns result;
+    if (geom.empty())
+    {
+        return result;
+    }
+
+    vector<size_t> nodes(1, 0);
+    bool complete = true;
+    for (const string& segment : splitString(geom, GEOM_PATH_SEPARATOR))
+    {
+        size_t child = findChild(nodes.back(), segment);
+        if (!child)
+        {
+            complete = false;
+            break;
+        }
+        nodes.push_back(child);
+    }
+    resolveNodes(nodes, complete, result);
+    return result;
+}
+
+vector<GeomAssigns> GeomAssignIndex::resolve(const StringVec& geoms, unsigned int threadCount) const
+{
+    vector<GeomAssigns> results(geoms.size());
+    if (!threadCount)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = (unsigned int) std::min((size_t) threadCount, geoms.size());
+    if (threadCount <= 1)
+    {
+        resolveRange(geoms, 0, geoms.size(), results);
+        return results;
+    }
+
+    // Split the paths into more ranges than threads, balancing the load
+    // between subtrees of differing complexity.
+    const size_t rangeCount = std::min((size_t) threadCount * 4, geoms.size());
+    std::atomic<size_t> nextRange(0);
+    runWorkerThreads(threadCount, [&]()
+    {
+        for (size_t i = nextRange++; i < rangeCount; i = nextRange++)
+        {
+            resolveRange(geoms, geoms.size() * i / rangeCount, geoms.size() * (i + 1) / rangeCount, results);
+        }
+    });
+    return results;
+}
+
+void GeomAssignIndex::resolveRange(const StringVec& geoms, size_t begin, size_t end, vector<GeomAssigns>& results) const
+{
+    vector<size_t> nodes(1, 0);
+    StringVec prevSegments;
+    for (size_t i = begin; i < end; i++)
+    {
+        if (geoms[i].empty())
+        {
+            continue;
+        }
+
+        // Reuse the nodes found for the prefix shared with the previous path.
+        StringVec segments = splitString(geoms[i], GEOM_PATH_SEPARATOR);
+        size_t common = 0;
+        while (common + 1 < nodes.size() &&
+               common < segments.size() &&
+               segments[common] == prevSegments[common])
+        {
+            common++;
+        }
+        nodes.resize(common + 1);
+
+        bool complete = true;
+        for (size_t j = common; j < segments.size(); j++)
+        {
+            size_t child = findChild(nodes.back(), segments[j]);
+            if (!child)
+            {
+                complete = false;
+                break;
+            }
+            nodes.push_back(child);
+        }
+        resolveNodes(nodes, complete, results[i]);
+        prevSegments.swap(segments);
+    }
+}
+
+void GeomAssignIndex::addAssign(ElementPtr assign, AssignKind kind, const string& geom, ConstCollectionPtr collection)
+{
+    size_t index = _assigns.size();
+    _assigns.emplace_back(assign, kind);
+
+    if (!geom.empty())
+    {
+        addMarkers(geom, addTerm(index), true);
+    }
+    if (!collection)
+    {
+        return;
+    }
+
+    // Flatten the collection into one term for itself and for each collection
+    // in its include chain, following Collection::matchesGeomString: each
+    // term is excluded by the geometry excluded from the assigned collection
+    // and from the collection that includes its geometry.
+    vector<CollectionPtr> includedVec = collection->getIncludeCollections();
+    std::set<CollectionPtr> includedSet;
+    for (size_t i = 0; i < includedVec.size(); i++)
+    {
+        CollectionPtr included = includedVec[i];
+        if (includedSet.count(included))
+        {
+            throw ExceptionFoundCycle("Encountered a cycle in collection: " + collection->getName());
+        }
+        includedSet.insert(included);
+        vector<CollectionPtr> appendVec = included->getIncludeCollections();
+        includedVec.insert(includedVec.end(), appendVec.begin(), appendVec.end());
+    }
+
+    const string excludeGeom = collection->getActiveExcludeGeom();
+    size_t term = addTerm(index);
+    addMarkers(collection->getActiveIncludeGeom(), term, true);
+    addMarkers(excludeGeom, term, false);
+    for (ConstCollectionPtr included : includedVec)
+    {
+        term = addTerm(index);
+        addMarkers(included->getActiveIncludeGeom(), term, true);
+        addMarkers(excludeGeom, term, false);
+        addMarkers(included->getActiveExcludeGeom(), term, false);
+    }
+}
+
+size_t GeomAssignIndex::addTerm(size_t assign)
+{
+    _termAssigns.push_back(assign);
+    return _termAssigns.size() - 1;
+}
+
+void GeomAssignIndex::addMarkers(const string& geom, size_t term, bool include)
+{
+    for (const string& path : splitString(geom, ARRAY_VALID_SEPARATORS))
+    {
+        size_t node = 0;
+        for (const string& segment : splitString(path, GEOM_PATH_SEPARATOR))
+        {
+            size_t child = findChild(node, segment);
+            if (!child)
+            {
+                child = _nodes.size();
+                _nodes[node].children[segment] = child;
+                _nodes.emplace_back();
+                _nodes.back().parent = node;
+            }
+            node = child;
+        }
+        if (include)
+        {
+            _nodes[node].includes.push_back(term);
+        }
+        else
+        {
+            _nodes[node].excludes.push_back(term);
+        }
+    }
+}
+
+size_t GeomAssignIndex::findChild(size_t node, const string& segment) const
+{
+    // The root node is never a child, so zero denotes a missing child.
+    auto it = _nodes[node].children.find(segment);
+    return it != _nodes[node].children.end() ? it->second : 0;
+}
+
+void GeomAssignIndex::resolveNodes(const vector<size_t>& nodes, bool complete, GeomAssigns& result) const
+{
+    // Terms are excluded by exclude paths that contain the given path, and
+    // bound by include paths that share geometry with it, either as its
+    // ancestors or, if the full path is present in the trie, its descendants.
+    vector<size_t> excluded;
+    for (size_t node : nodes)
+    {
+        excluded.insert(excluded.end(), _nodes[node].excludes.begin(), _nodes[node].excludes.end());
+    }
+    std::sort(excluded.begin(), excluded.end());
+
+    vector<size_t> matched;
+    auto addIncludes = [this, &excluded, &matched](const vector<size_t>& terms)
+    {
+        for (size_t term : terms)
+        {
+            if (!std::binary_search(excluded.begin(), excluded.end(), term))
+            {
+                matched.push_back(_termAssigns[term]);
+            }
+        }
+    };
+    for (size_t node : nodes)
+    {
+        addIncludes(_nodes[node].includes);
+    }
+    if (complete)
+    {
+        addIncludes(_nodes[nodes.back()].descendantIncludes);
+    }
+    std::sort(matched.begin(), matched.end());
+    matched.erase(std::unique(matched.begin(), matched.end()), matched.end());
+
+    for (size_t index : matched)
+    {
+        const ElementPtr& assign = _assigns[index].first;
+        switch (_assigns[index].second)
+        {
+            case MATERIAL_ASSIGN:
+                result.materialAssigns.push_back(std::static_pointer_cast<MaterialAssign>(assign));
+                break;
+            case PROPERTY_ASSIGN:
+                result.propertyAssigns.push_back(std::static_pointer_cast<PropertyAssign>(assign));
+                break;
+            case PROPERTY_SET_ASSIGN:
+                result.propertySetAssigns.push_back(std::static_pointer_cast<PropertySetAssign>(assign));
+                break;
+            case VISIBILITY:
+                result.visibilities.push_back(std::static_pointer_cast<Visibility>(assign));
+                break;
+        }
+    }
+}
+
 } // namespace MaterialX
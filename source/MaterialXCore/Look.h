@@ -23,6 +23,7 @@ class LookGroup;
 class LookInherit;
 class MaterialAssign;
 class Visibility;
+class GeomAssignIndex;
 
 /// A shared pointer to a Look
 using LookPtr = shared_ptr<Look>;
@@ -48,6 +49,9 @@ using VisibilityPtr = shared_ptr<Visibility>;
 /// A shared pointer to a const Visibility
 using ConstVisibilityPtr = shared_ptr<const Visibility>;
 
+/// A shared pointer to a GeomAssignIndex
+using GeomAssignIndexPtr = shared_ptr<GeomAssignIndex>;
+
 /// @class Look
 /// A look element within a Document.
 class MX_CORE_API Look : public Element
@@ -494,6 +498,115 @@ class MX_CORE_API Visibility : public GeomElement
     static const string VISIBLE_ATTRIBUTE;
 };
 
+/// @struct GeomAssigns
+/// The look assignments that apply to a geometry path, as resolved by a
+/// GeomAssignIndex.  Within each vector, assignments are returned in the
+/// order of their looks and of their elements within each look.
+struct GeomAssigns
+{
+    vector<MaterialAssignPtr> materialAssigns;
+    vector<PropertyAssignPtr> propertyAssigns;
+    vector<PropertySetAssignPtr> propertySetAssigns;
+    vector<VisibilityPtr> visibilities;
+};
+
+/// @class GeomAssignIndex
+/// A precompiled index of the geometry bindings of a set of looks.
+///
+/// The geometry strings and collections of all active material assignments,
+/// property assignments, property set assignments, and visibilities in the
+/// given looks are compiled into a trie over geometry path segments, with
+/// collection includes and excludes flattened into markers on its nodes.
+/// Resolving a geometry path then takes time proportional to the depth of
+/// the path and the number of matching assignments, independent of the
+/// number of assignments in the looks.
+///
+/// A geometry path is bound to an assignment if it shares geometry with
+/// the geometry string of the assignment, as in geomStringsMatch, or if it
+/// matches its collection, as in Collection::matchesGeomString.
+///
+/// The index is a snapshot of the looks at the time of its creation, and
+/// should be recreated if assignments or collections are edited.  Once
+/// created, all methods are thread-safe.
+class MX_CORE_API GeomAssignIndex
+{
+  public:
+    /// Create an index of the assignments in the given looks.
+    /// @throws ExceptionFoundCycle if a cycle is encountered in the
+    ///    include chain of a referenced collection.
+    GeomAssignIndex(const LookVec& looks);
+    ~GeomAssignIndex() { }
+
+    /// Create an index of the assignments in the given looks.
+    static GeomAssignIndexPtr create(const LookVec& looks)
+    {
+        return std::make_shared<GeomAssignIndex>(looks);
+    }
+
+    /// Return the assignments that apply to the given geometry path.
+    GeomAssigns resolve(const string& geom) const;
+
+    /// Return the assignments that apply to each of the given geometry paths.
+    /// Lookups of path prefixes are shared between consecutive paths, so
+    /// hierarchies are resolved most efficiently when each path follows its
+    /// parent or a sibling, as in a sorted list or a depth-first traversal of
+    /// a scene.
+    /// @param geoms The geometry paths to resolve.
+    /// @param threadCount The number of threads across which contiguous ranges
+    ///    of paths are resolved.  If zero, then the hardware concurrency of
+    ///    the system is used.  Defaults to one.
+    vector<GeomAssigns> resolve(const StringVec& geoms, unsigned int threadCount = 1) const;
+
+  private:
+    enum AssignKind
+    {
+        MATERIAL_ASSIGN,
+        PROPERTY_ASSIGN,
+        PROPERTY_SET_ASSIGN,
+        VISIBILITY
+    };
+
+    struct TrieNode
+    {
+        size_t parent = 0;
+        std::unordered_map<string, size_t> children;
+        vector<size_t> includes;
+        vector<size_t> excludes;
+        vector<size_t> descendantIncludes;
+    };
+
+    void addAssign(ElementPtr assign, AssignKind kind, const string& geom, ConstCollectionPtr collection);
+    size_t addTerm(size_t assign);
+    void addMarkers(const string& geom, size_t term, bool include);
+    size_t findChild(size_t node, const string& segment) const;
+    void resolveRange(const StringVec& geoms, size_t begin, size_t end, vector<GeomAssigns>& results) const;
+    void resolveNodes(const vector<size_t>& nodes, bool complete, GeomAssigns& result) const;
+
+  private:
+    vector<std::pair<ElementPtr, AssignKind>> _assigns;
+    vector<size_t> _termAssigns;
+    vector<TrieNode> _nodes;
+};
+
+/// Resolve the assignments of a look for each of the given geometry paths,
+/// taking look inheritance into account.
+/// @param look The look whose assignments are resolved.
+/// @param geoms The geometry paths to resolve, which are most efficiently
+///    resolved when sorted.
+/// @param threadCount The number of threads across which paths are resolved.
+///    If zero, then the hardware concurrency of the system is used.
+/// @return The resolved assignments for each path, in the order of the given
+///    geometry paths.
+/// @throws ExceptionFoundCycle if a cycle is encountered in the include
+///    chain of a referenced collection.
+MX_CORE_API vector<GeomAssigns> resolveGeomAssigns(LookPtr look, const StringVec& geoms, unsigned int threadCount = 1);
+
+/// Resolve the assignments of the active look of a look group for each of
+/// the given geometry paths.  If the look group has no active look, then the
+/// first look in its list is used.
+/// @throws Exception if the look group does not reference a valid look.
+MX_CORE_API vector<GeomAssigns> resolveGeomAssigns(LookGroupPtr lookGroup, const StringVec& geoms, unsigned int threadCount = 1);
+
 /// Return a vector of all MaterialAssign elements that bind this material node
 /// to the given geometry string
 /// @param materialNode Node to examine
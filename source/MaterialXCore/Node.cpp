@@ -95,8 +95,52 @@ NodeDefPtr Node::getNodeDef(const string& target) const
     {
         return resolveRootNameReference<NodeDef>(getNodeDefString());
     }
-    vector<NodeDefPtr> nodeDefs = getDocument()->getMatchingNodeDefs(getQualifiedName(getCategory()));
-    vector<NodeDefPtr> secondary = getDocument()->getMatchingNodeDefs(getCategory());
+
+    // Nodes with inherited value elements are resolved without memoization,
+    // as their signatures depend on other elements.
+    ConstDocumentPtr doc = getDocument();
+    const string qualifiedCategory = getQualifiedName(getCategory());
+    const bool memoize = !hasInheritString();
+
+    // Build a key from all properties of the node that are considered in
+    // matching it to a nodedef.
+    string key;
+    if (memoize)
+    {
+        const char SEPARATOR = '\n';
+        key.reserve(128);
+        key += qualifiedCategory;
+        key += SEPARATOR;
+        key += getCategory();
+        key += SEPARATOR;
+        key += getType();
+        key += SEPARATOR;
+        key += target;
+        key += SEPARATOR;
+        key += getVersionString();
+        for (const ElementPtr& child : getChildren())
+        {
+            if (dynamic_cast<const ValueElement*>(child.get()))
+            {
+                key += SEPARATOR;
+                key += child->getName();
+                key += SEPARATOR;
+                key += child->getCategory();
+                key += SEPARATOR;
+                key += child->getAttribute(TypedElement::TYPE_ATTRIBUTE);
+            }
+        }
+
+        NodeDefPtr nodeDef;
+        if (doc->findNodeDefResolution(key, nodeDef))
+        {
+            return nodeDef;
+        }
+    }
+
+    NodeDefPtr match;
+    vector<NodeDefPtr> nodeDefs = doc->getMatchingNodeDefs(qualifiedCategory);
+    vector<NodeDefPtr> secondary = doc->getMatchingNodeDefs(getCategory());
     nodeDefs.insert(nodeDefs.end(), secondary.begin(), secondary.end());
     for (NodeDefPtr nodeDef : nodeDefs)
     {
@@ -104,17 +148,40 @@ NodeDefPtr Node::getNodeDef(const string& target) const
             nodeDef->isVersionCompatible(getVersionString()) &&
             isTypeCompatible(nodeDef))
         {
-            return nodeDef;
+            match = nodeDef;
+            break;
         }
     }
-    return NodeDefPtr();
+
+    if (memoize)
+    {
+        doc->addNodeDefResolution(key, match);
+    }
+    return match;
 }
 
 Edge Node::getUpstreamEdge(size_t index) const
 {
     if (index < getUpstreamEdgeCount())
     {
-        InputPtr input = getInputs()[index];
+        // Nodes usually hold only inputs, whose child indices then match
+        // their input indices, so iterating over all upstream edges doesn't
+        // walk the preceding inputs for each edge.
+        InputPtr input;
+        const vector<ElementPtr>& children = getChildren();
+        if (children.size() == getInputCount())
+        {
+            input = std::static_pointer_cast<Input>(children[index]);
+        }
+        else
+        {
+            ChildIterator<Input> it = traverseInputs().begin();
+            for (size_t i = 0; i < index; i++)
+            {
+                ++it;
+            }
+            input = *it;
+        }
         ElementPtr upstreamNode = input->getConnectedNode();
         if (upstreamNode)
         {
@@ -224,11 +224,19 @@ class MX_CORE_API GraphElement : public InterfaceElement
         return getChildrenOfType<Node>(category);
     }
 
+    /// Return a lightweight range over all Nodes in the graph, optionally
+    /// filtered by the given category string, as an allocation-free
+    /// alternative to getNodes.
+    ChildRange<Node> traverseNodes(const string& category = EMPTY_STRING) const
+    {
+        return traverseChildrenOfType<Node>(category);
+    }
+
     /// Return a vector of nodes in the graph which have a given type
     vector<NodePtr> getNodesOfType(const string& nodeType) const
     {
         vector<NodePtr> nodes;
-        for (auto node : getNodes())
+        for (NodePtr node : traverseNodes())
         {
             if (node->getType() == nodeType)
             {
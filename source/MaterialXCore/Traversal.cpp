@@ -85,14 +85,20 @@ TreeIterator& TreeIterator::operator++()
 
 size_t GraphIterator::getNodeDepth() const
 {
+    // The current path consists of the downstream element of each stack
+    // frame, followed by the current upstream element.
     size_t nodeDepth = 0;
-    for (ElementPtr elem : _pathElems)
+    for (const StackFrame& frame : _stack)
     {
-        if (elem->isA<Node>())
+        if (frame.first->isA<Node>())
         {
             nodeDepth++;
         }
     }
+    if (_upstreamElem && _upstreamElem->isA<Node>())
+    {
+        nodeDepth++;
+    }
     return nodeDepth;
 }
 
@@ -111,9 +117,11 @@ GraphIterator& GraphIterator::operator++()
 
     if (!_prune && _upstreamElem && _upstreamElem->getUpstreamEdgeCount())
     {
-        // Traverse to the first upstream edge of this element.
-        _stack.emplace_back(_upstreamElem, 0);
-        Edge nextEdge = _upstreamElem->getUpstreamEdge(0);
+        // Traverse to the first upstream edge of this element, which remains
+        // on the current path as the downstream element of the new frame.
+        _stack.emplace_back(std::move(_upstreamElem), 0);
+        _connectingElem = nullptr;
+        Edge nextEdge = _stack.back().first->getUpstreamEdge(0);
         if (nextEdge && nextEdge.getUpstreamElement())
         {
             extendPathUpstream(nextEdge.getUpstreamElement(), nextEdge.getConnectingElement());
@@ -126,13 +134,14 @@ GraphIterator& GraphIterator::operator++()
     {
         if (_upstreamElem)
         {
-            returnPathDownstream(_upstreamElem);
+            returnPathDownstream(_upstreamElem.get());
         }
 
         if (_stack.empty())
         {
-            // Traversal is complete.
-            *this = GraphIterator::end();
+            // Traversal is complete.  Storage is retained, as the cleared
+            // iterator compares equal to the end iterator.
+            _pathElems.clear();
             return *this;
         }
 
@@ -150,7 +159,7 @@ GraphIterator& GraphIterator::operator++()
         }
 
         // Traverse to our parent's siblings.
-        returnPathDownstream(parentFrame.first);
+        returnPathDownstream(parentFrame.first.get());
         _stack.pop_back();
     }
 
@@ -160,22 +169,21 @@ GraphIterator& GraphIterator::operator++()
 void GraphIterator::extendPathUpstream(ElementPtr upstreamElem, ElementPtr connectingElem)
 {
     // Check for cycles.
-    if (_pathElems.count(upstreamElem))
+    if (!_pathElems.insert(upstreamElem.get()))
     {
         throw ExceptionFoundCycle("Encountered cycle at element: " + upstreamElem->asString());
     }
 
     // Extend the current path to the new element.
-    _pathElems.insert(upstreamElem);
-    _upstreamElem = upstreamElem;
-    _connectingElem = connectingElem;
+    _upstreamElem = std::move(upstreamElem);
+    _connectingElem = std::move(connectingElem);
 }
 
-void GraphIterator::returnPathDownstream(ElementPtr upstreamElem)
+void GraphIterator::returnPathDownstream(const Element* upstreamElem)
 {
     _pathElems.erase(upstreamElem);
-    _upstreamElem = ElementPtr();
-    _connectingElem = ElementPtr();
+    _upstreamElem = nullptr;
+    _connectingElem = nullptr;
 }
 
 //
@@ -11,6 +11,8 @@
 
 #include <MaterialXCore/Exception.h>
 
+#include <cstdint>
+
 namespace MaterialX
 {
 
@@ -19,6 +21,149 @@ class Element;
 using ElementPtr = shared_ptr<Element>;
 using ConstElementPtr = shared_ptr<const Element>;
 
+/// @class PointerSet
+/// A set of raw pointers, stored in a flat open-addressing hash table.
+///
+/// PointerSet is used to track the current path of graph traversals, where
+/// membership tests, insertions and removals are made at every step.  Unlike
+/// std::set, no memory is allocated for individual insertions, and removed
+/// entries are reclaimed in place without tombstones.  Null pointers may not
+/// be stored in the set.
+template <class T> class PointerSet
+{
+  public:
+    PointerSet() :
+        _size(0)
+    {
+    }
+    ~PointerSet() { }
+
+    /// Insert the given pointer, returning true if it was not already present.
+    bool insert(const T* ptr)
+    {
+        if ((_size + 1) * 2 > _slots.size())
+        {
+            grow();
+        }
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = hash(ptr) & mask; ; i = (i + 1) & mask)
+        {
+            if (_slots[i] == ptr)
+            {
+                return false;
+            }
+            if (!_slots[i])
+            {
+                _slots[i] = ptr;
+                _size++;
+                return true;
+            }
+        }
+    }
+
+    /// Return the number of instances of the given pointer in the set,
+    /// which is either zero or one.
+    size_t count(const T* ptr) const
+    {
+        return findSlot(ptr) != _slots.size() ? 1 : 0;
+    }
+
+    /// Remove the given pointer, returning true if it was present.
+    bool erase(const T* ptr)
+    {
+        size_t i = findSlot(ptr);
+        if (i == _slots.size())
+        {
+            return false;
+        }
+
+        // Shift later entries of the probe sequence back into the open slot.
+        const size_t mask = _slots.size() - 1;
+        for (size_t j = (i + 1) & mask; _slots[j]; j = (j + 1) & mask)
+        {
+            size_t home = hash(_slots[j]) & mask;
+            bool inRange = (i <= j) ? (i < home && home <= j) : (i < home || home <= j);
+            if (!inRange)
+            {
+                _slots[i] = _slots[j];
+                i = j;
+            }
+        }
+        _slots[i] = nullptr;
+        _size--;
+        return true;
+    }
+
+    /// Remove all pointers from the set, retaining its storage.
+    void clear()
+    {
+        if (_size)
+        {
+            std::fill(_slots.begin(), _slots.end(), nullptr);
+            _size = 0;
+        }
+    }
+
+    /// Return the number of pointers in the set.
+    size_t size() const
+    {
+        return _size;
+    }
+
+    /// Return true if the set is empty.
+    bool empty() const
+    {
+        return _size == 0;
+    }
+
+  private:
+    static size_t hash(const T* ptr)
+    {
+        uint64_t h = (uint64_t) (uintptr_t) ptr;
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return (size_t) h;
+    }
+
+    // Return the slot containing the given pointer, or the slot count if the
+    // pointer is not present.
+    size_t findSlot(const T* ptr) const
+    {
+        if (!_size)
+        {
+            return _slots.size();
+        }
+        const size_t mask = _slots.size() - 1;
+        for (size_t i = hash(ptr) & mask; _slots[i]; i = (i + 1) & mask)
+        {
+            if (_slots[i] == ptr)
+            {
+                return i;
+            }
+        }
+        return _slots.size();
+    }
+
+    void grow()
+    {
+        vector<const T*> previous(_slots.empty() ? 16 : _slots.size() * 2, nullptr);
+        previous.swap(_slots);
+        _size = 0;
+        for (const T* ptr : previous)
+        {
+            if (ptr)
+            {
+                insert(ptr);
+            }
+        }
+    }
+
+  private:
+    vector<const T*> _slots;
+    size_t _size;
+};
+
 /// @class Edge
 /// An edge between two connected Elements, returned during graph traversal.
 ///
@@ -197,12 +342,14 @@ class MX_CORE_API GraphIterator
         _prune(false),
         _holdCount(0)
     {
-        _pathElems.insert(elem);
+        if (elem)
+        {
+            _pathElems.insert(elem.get());
+        }
     }
     ~GraphIterator() { }
 
   private:
-    using ElementSet = std::set<ElementPtr>;
     using StackFrame = std::pair<ElementPtr, size_t>;
 
   public:
@@ -316,12 +463,12 @@ class MX_CORE_API GraphIterator
 
   private:
     void extendPathUpstream(ElementPtr upstreamElem, ElementPtr connectingElem);
-    void returnPathDownstream(ElementPtr upstreamElem);
+    void returnPathDownstream(const Element* upstreamElem);
 
   private:
     ElementPtr _upstreamElem;
     ElementPtr _connectingElem;
-    ElementSet _pathElems;
+    PointerSet<Element> _pathElems;
     vector<StackFrame> _stack;
     bool _prune;
     size_t _holdCount;
@@ -6,8 +6,10 @@
 #include <MaterialXCore/Types.h>
 
 #include <cctype>
+#include <exception>
 #include <sstream>
 #include <iomanip> 
+#include <thread>
 
 namespace MaterialX
 {
@@ -154,6 +156,50 @@ string trimSpaces(const string& str)
     return result;
 }
 
+void runWorkerThreads(unsigned int threadCount, const std::function<void()>& worker)
+{
+    threadCount = std::max(threadCount, 1u);
+    vector<std::exception_ptr> errors(threadCount);
+    auto runWorker = [&worker, &errors](unsigned int threadIndex)
+    {
+        try
+        {
+            worker();
+        }
+        catch (...)
+        {
+            errors[threadIndex] = std::current_exception();
+        }
+    };
+
+    // Start as many threads as possible, leaving any tasks of threads that
+    // could not be started to the running workers.
+    vector<std::thread> threads;
+    try
+    {
+        threads.reserve(threadCount - 1);
+        for (unsigned int i = 1; i < threadCount; i++)
+        {
+            threads.emplace_back(runWorker, i);
+        }
+    }
+    catch (...)
+    {
+    }
+    runWorker(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
 StringVec splitNamePath(const string& namePath)
 {
     StringVec nameVec = splitString(namePath, NAME_PATH_SEPARATOR);
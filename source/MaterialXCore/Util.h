@@ -61,6 +61,14 @@ template<typename T> void hashCombine(size_t& seed, const T& value)
     seed ^= std::hash<T>()(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
 } 
 
+/// Run the given worker function on the given number of threads, including
+/// the calling thread, and wait for all of them to finish.  Each call of the
+/// worker is expected to pull tasks from shared state until none remain, so
+/// if a thread cannot be started, its work is taken up by the others.
+/// @throws The first exception thrown by a call of the worker, once all
+///    threads have been joined.
+MX_CORE_API void runWorkerThreads(unsigned int threadCount, const std::function<void()>& worker);
+
 /// Split a name path into string vector
 MX_CORE_API StringVec splitNamePath(const string& namePath);
 
@@ -5,7 +5,11 @@
 
 #include <MaterialXCore/Value.h>
 
+#include <clocale>
+#include <cstdio>
+#include <cstring>
 #include <iomanip>
+#include <limits>
 #include <sstream>
 #include <type_traits>
 
@@ -13,11 +17,12 @@ namespace MaterialX
 {
 
 Value::CreatorMap Value::_creatorMap;
-Value::FloatFormat Value::_floatFormat = Value::FloatFormatDefault;
-int Value::_floatPrecision = 6;
 
 namespace {
 
+thread_local Value::FloatFormat floatFormat = Value::FloatFormatDefault;
+thread_local int floatPrecision = 6;
+
 template <class T> using enable_if_mx_vector_t =
     typename std::enable_if<std::is_base_of<VectorBase, T>::value, T>::type;
 template <class T> using enable_if_mx_matrix_t =
@@ -28,7 +33,7 @@ template <class T> class is_std_vector< vector<T> > : public std::true_type { };
 template <class T> using enable_if_std_vector_t =
     typename std::enable_if<is_std_vector<T>::value, T>::type;
 
-template <class T> void stringToData(const string& str, T& data)
+template <class T> void streamToData(const string& str, T& data)
 {
     std::stringstream ss(str);
     ss.imbue(std::locale::classic());
@@ -38,93 +43,387 @@ template <class T> void stringToData(const string& str, T& data)
     }
 }
 
-template <> void stringToData(const string& str, bool& data)
+template <class T> string streamFromData(const T& data)
+{
+    std::stringstream ss;
+    ss.imbue(std::locale::classic());
+    // Set float format and precision for the stream
+    const Value::FloatFormat fmt = Value::getFloatFormat();
+    ss.setf(std::ios_base::fmtflags(
+            (fmt == Value::FloatFormatFixed ? std::ios_base::fixed :
+            (fmt == Value::FloatFormatScientific ? std::ios_base::scientific : 0))),
+        std::ios_base::floatfield);
+    ss.precision(Value::getFloatPrecision());
+
+    ss << data;
+    return ss.str();
+}
+
+bool isArraySeparator(char c)
+{
+    return ARRAY_VALID_SEPARATORS.find(c) != string::npos;
+}
+
+// Invoke the given callback on each token of an array value string, with
+// tokens delimited as in splitString, and return the number of tokens.
+template <class F> size_t forEachToken(const string& str, F callback)
+{
+    size_t count = 0;
+    const char* it = str.data();
+    const char* end = it + str.size();
+    while (true)
+    {
+        while (it != end && isArraySeparator(*it))
+        {
+            ++it;
+        }
+        if (it == end)
+        {
+            break;
+        }
+        const char* tokenBegin = it;
+        while (it != end && !isArraySeparator(*it))
+        {
+            ++it;
+        }
+        callback(tokenBegin, it, count++);
+    }
+    return count;
+}
+
+// Parse a token consisting of an optional sign and decimal digits.  Returns
+// false for any other form, or for values out of range, leaving these to the
+// stream parser.
+template <class T> bool parseInteger(const char* begin, const char* end, T& data)
+{
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+'))
+    {
+        negative = (*begin == '-');
+        ++begin;
+    }
+    if (begin == end)
+    {
+        return false;
+    }
+
+    const unsigned long long limit = (unsigned long long) std::numeric_limits<T>::max() + (negative ? 1 : 0);
+    unsigned long long value = 0;
+    for (; begin != end; ++begin)
+    {
+        if (*begin < '0' || *begin > '9')
+        {
+            return false;
+        }
+        unsigned int digit = (unsigned int) (*begin - '0');
+        if (value > (limit - digit) / 10)
+        {
+            return false;
+        }
+        value = value * 10 + digit;
+    }
+
+    if (!negative)
+    {
+        data = (T) value;
+    }
+    else
+    {
+        data = value ? -(T) (value - 1) - 1 : 0;
+    }
+    return true;
+}
+
+// Parse a token in decimal or exponential notation, where the result can be
+// computed with a single exact floating-point operation and is therefore
+// correctly rounded.  Returns false for any other token, leaving these to the
+// stream parser.
+template <class T> bool parseFloat(const char* begin, const char* end, T& data)
+{
+    // The largest integer and power of ten that are exactly representable.
+    const unsigned long long MAX_MANTISSA = 1ull << std::numeric_limits<T>::digits;
+    const int MAX_EXPONENT = std::is_same<T, float>::value ? 10 : 22;
+    static const double POWERS_OF_TEN[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    bool negative = false;
+    if (begin != end && (*begin == '-' || *begin == '+'))
+    {
+        negative = (*begin == '-');
+        ++begin;
+    }
+
+    // Read integer and fractional digits into a single mantissa.
+    unsigned long long mantissa = 0;
+    int exponent = 0;
+    int digitCount = 0;
+    bool fraction = false;
+    for (; begin != end; ++begin)
+    {
+        if (*begin == '.' && !fraction)
+        {
+            fraction = true;
+            continue;
+        }
+        if (*begin < '0' || *begin > '9')
+        {
+            break;
+        }
+        mantissa = mantissa * 10 + (unsigned int) (*begin - '0');
+        if (mantissa > MAX_MANTISSA)
+        {
+            return false;
+        }
+        exponent -= fraction ? 1 : 0;
+        digitCount++;
+    }
+    if (!digitCount)
+    {
+        return false;
+    }
+
+    // Read an optional exponent.
+    if (begin != end && (*begin == 'e' || *begin == 'E'))
+    {
+        ++begin;
+        bool negativeExponent = false;
+        if (begin != end && (*begin == '-' || *begin == '+'))
+        {
+            negativeExponent = (*begin == '-');
+            ++begin;
+        }
+        if (begin == end)
+        {
+            return false;
+        }
+        int explicitExponent = 0;
+        for (; begin != end; ++begin)
+        {
+            if (*begin < '0' || *begin > '9' || explicitExponent > MAX_EXPONENT * 10)
+            {
+                return false;
+            }
+            explicitExponent = explicitExponent * 10 + (*begin - '0');
+        }
+        exponent += negativeExponent ? -explicitExponent : explicitExponent;
+    }
+    if (begin != end)
+    {
+        return false;
+    }
+
+    T value = (T) mantissa;
+    if (mantissa)
+    {
+        if (exponent < -MAX_EXPONENT || exponent > MAX_EXPONENT)
+        {
+            return false;
+        }
+        if (exponent < 0)
+        {
+            value /= (T) POWERS_OF_TEN[-exponent];
+        }
+        else
+        {
+            value *= (T) POWERS_OF_TEN[exponent];
+        }
+    }
+    data = negative ? -value : value;
+    return true;
+}
+
+template <class T> void tokenToData(const char* begin, const char* end, T& data)
 {
-    if (str == VALUE_STRING_TRUE)
+    streamToData(string(begin, end), data);
+}
+
+template <> void tokenToData(const char* begin, const char* end, int& data)
+{
+    if (!parseInteger(begin, end, data))
+    {
+        streamToData(string(begin, end), data);
+    }
+}
+
+template <> void tokenToData(const char* begin, const char* end, long& data)
+{
+    if (!parseInteger(begin, end, data))
+    {
+        streamToData(string(begin, end), data);
+    }
+}
+
+template <> void tokenToData(const char* begin, const char* end, float& data)
+{
+    if (!parseFloat(begin, end, data))
+    {
+        streamToData(string(begin, end), data);
+    }
+}
+
+template <> void tokenToData(const char* begin, const char* end, double& data)
+{
+    if (!parseFloat(begin, end, data))
+    {
+        streamToData(string(begin, end), data);
+    }
+}
+
+template <> void tokenToData(const char* begin, const char* end, bool& data)
+{
+    size_t length = (size_t) (end - begin);
+    if (VALUE_STRING_TRUE.compare(0, string::npos, begin, length) == 0)
         data = true;
-    else if (str == VALUE_STRING_FALSE)
+    else if (VALUE_STRING_FALSE.compare(0, string::npos, begin, length) == 0)
         data = false;
     else
-        throw ExceptionTypeError("Type mismatch in boolean stringToData: " + str);
+        throw ExceptionTypeError("Type mismatch in boolean stringToData: " + string(begin, end));
 }
 
-template <> void stringToData(const string& str, string& data)
+template <> void tokenToData(const char* begin, const char* end, string& data)
 {
-    data = str;
+    data.assign(begin, end);
+}
+
+template <class T> void stringToData(const string& str, T& data)
+{
+    tokenToData(str.data(), str.data() + str.size(), data);
 }
 
 template <class T> void stringToData(const string& str, enable_if_mx_vector_t<T>& data)
 {
-    StringVec tokens = splitString(str, ARRAY_VALID_SEPARATORS);
-    if (tokens.size() != data.numElements())
+    size_t count = forEachToken(str, [&data](const char* begin, const char* end, size_t index)
     {
-        throw ExceptionTypeError("Type mismatch in vector stringToData: " + str);
-    }
-    for (size_t i = 0; i < data.numElements(); i++)
+        if (index < data.numElements())
+        {
+            tokenToData(begin, end, data[index]);
+        }
+    });
+    if (count != data.numElements())
     {
-        stringToData(tokens[i], data[i]);
+        throw ExceptionTypeError("Type mismatch in vector stringToData: " + str);
     }
 }
 
 template <class T> void stringToData(const string& str, enable_if_mx_matrix_t<T>& data)
 {
-    StringVec tokens = splitString(str, ARRAY_VALID_SEPARATORS);
-    if (tokens.size() != data.numRows() * data.numColumns())
-    {
-        throw ExceptionTypeError("Type mismatch in matrix stringToData: " + str);
-    }
-    for (size_t i = 0; i < data.numRows(); i++)
+    size_t count = forEachToken(str, [&data](const char* begin, const char* end, size_t index)
     {
-        for (size_t j = 0; j < data.numColumns(); j++)
+        if (index < data.numRows() * data.numColumns())
         {
-            stringToData(tokens[i * data.numRows() + j], data[i][j]);
+            tokenToData(begin, end, data[index / data.numColumns()][index % data.numColumns()]);
         }
+    });
+    if (count != data.numRows() * data.numColumns())
+    {
+        throw ExceptionTypeError("Type mismatch in matrix stringToData: " + str);
     }
 }
 
 template <class T> void stringToData(const string& str, enable_if_std_vector_t<T>& data)
 {
-    for (const string& token : splitString(str, ARRAY_VALID_SEPARATORS))
+    forEachToken(str, [&data](const char* begin, const char* end, size_t)
     {
         typename T::value_type val;
-        stringToData(token, val);
+        tokenToData(begin, end, val);
         data.push_back(val);
+    });
+}
+
+void integerToString(long long data, string& str)
+{
+    char buffer[32];
+    char* end = buffer + sizeof(buffer);
+    char* it = end;
+    unsigned long long value = data < 0 ? 0ull - (unsigned long long) data : (unsigned long long) data;
+    do
+    {
+        *--it = (char) ('0' + value % 10);
+        value /= 10;
+    } while (value);
+    if (data < 0)
+    {
+        *--it = '-';
     }
+    str.append(it, end);
 }
 
-template <class T> void dataToString(const T& data, string& str)
+// Format a floating-point value with the current float format and precision,
+// matching the output of a stream in the classic locale.
+void floatToString(double data, string& str)
 {
-    std::stringstream ss;
-    ss.imbue(std::locale::classic());
-    // Set float format and precision for the stream
     const Value::FloatFormat fmt = Value::getFloatFormat();
-    ss.setf(std::ios_base::fmtflags(
-            (fmt == Value::FloatFormatFixed ? std::ios_base::fixed :
-            (fmt == Value::FloatFormatScientific ? std::ios_base::scientific : 0))),
-        std::ios_base::floatfield);
-    ss.precision(Value::getFloatPrecision());
+    const char* format = (fmt == Value::FloatFormatFixed) ? "%.*f" :
+                         (fmt == Value::FloatFormatScientific) ? "%.*e" : "%.*g";
+    char buffer[64];
+    int length = std::snprintf(buffer, sizeof(buffer), format, Value::getFloatPrecision(), data);
+    if (length < 0 || length >= (int) sizeof(buffer))
+    {
+        str += streamFromData(data);
+        return;
+    }
 
-    ss << data;
-    str = ss.str();
+    // Restore the classic decimal point if the C locale has been changed.
+    const char* point = std::localeconv()->decimal_point;
+    if (point[0] && (point[0] != '.' || point[1]))
+    {
+        const char* found = std::strstr(buffer, point);
+        if (found)
+        {
+            str.append(buffer, (size_t) (found - buffer));
+            str += '.';
+            str.append(found + std::strlen(point));
+            return;
+        }
+    }
+    str.append(buffer, (size_t) length);
+}
+
+// The dataToString functions append the string representation of the given
+// data to the given string.
+template <class T> void dataToString(const T& data, string& str)
+{
+    str += streamFromData(data);
+}
+
+template <> void dataToString(const int& data, string& str)
+{
+    integerToString(data, str);
+}
+
+template <> void dataToString(const long& data, string& str)
+{
+    integerToString(data, str);
+}
+
+template <> void dataToString(const float& data, string& str)
+{
+    floatToString(data, str);
+}
+
+template <> void dataToString(const double& data, string& str)
+{
+    floatToString(data, str);
 }
 
 template <> void dataToString(const bool& data, string& str)
 {
-    str = data ? VALUE_STRING_TRUE : VALUE_STRING_FALSE;
+    str += data ? VALUE_STRING_TRUE : VALUE_STRING_FALSE;
 }
 
 template <> void dataToString(const string& data, string& str)
 {
-    str = data;
+    str += data;
 }
 
 template <class T> void dataToString(const enable_if_mx_vector_t<T>& data, string& str)
 {
     for (size_t i = 0; i < data.numElements(); i++)
     {
-        string token;
-        dataToString(data[i], token);
-        str += token;
+        dataToString(data[i], str);
         if (i + 1 < data.numElements())
         {
             str += ARRAY_PREFERRED_SEPARATOR;
@@ -138,9 +437,7 @@ template <class T> void dataToString(const enable_if_mx_matrix_t<T>& data, strin
     {
         for (size_t j = 0; j < data.numColumns(); j++)
         {
-            string token;
-            dataToString(data[i][j], token);
-            str += token;
+            dataToString(data[i][j], str);
             if (i + 1 < data.numRows() ||
                 j + 1 < data.numColumns())
             {
@@ -154,9 +451,7 @@ template <class T> void dataToString(const enable_if_std_vector_t<T>& data, stri
 {
     for (size_t i = 0; i < data.size(); i++)
     {
-        string token;
-        dataToString<typename T::value_type>(data[i], token);
-        str += token;
+        dataToString<typename T::value_type>(data[i], str);
         if (i + 1 < data.size())
         {
             str += ARRAY_PREFERRED_SEPARATOR;
@@ -218,6 +513,26 @@ ValuePtr Value::createValueFromStrings(const string& value, const string& type)
     return TypedValue<string>::createFromString(value);
 }
 
+void Value::setFloatFormat(FloatFormat format)
+{
+    floatFormat = format;
+}
+
+void Value::setFloatPrecision(int precision)
+{
+    floatPrecision = precision;
+}
+
+Value::FloatFormat Value::getFloatFormat()
+{
+    return floatFormat;
+}
+
+int Value::getFloatPrecision()
+{
+    return floatPrecision;
+}
+
 template<class T> bool Value::isA() const
 {
     return dynamic_cast<const TypedValue<T>*>(this) != nullptr;
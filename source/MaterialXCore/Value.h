@@ -99,28 +99,23 @@ class MX_CORE_API Value
     /// Set float formatting for converting values to strings.
     /// Formats to use are FloatFormatFixed, FloatFormatScientific 
     /// or FloatFormatDefault to set default format.
-    static void setFloatFormat(FloatFormat format)
-    {
-        _floatFormat = format;
-    }
+    /// Float formatting is set per thread, so that threads converting
+    /// values concurrently do not affect one another.  Each new thread
+    /// starts with FloatFormatDefault, so code handing work to other
+    /// threads should apply the formatting of the calling thread on each
+    /// of them, e.g. with a ScopedFloatFormatting.
+    static void setFloatFormat(FloatFormat format);
 
     /// Set float precision for converting values to strings.
-    static void setFloatPrecision(int precision)
-    {
-        _floatPrecision = precision;
-    }
+    /// Float precision is set per thread, and each new thread starts
+    /// with a precision of 6.
+    static void setFloatPrecision(int precision);
 
-    /// Return the current float format.
-    static FloatFormat getFloatFormat()
-    {
-        return _floatFormat;
-    }
+    /// Return the current float format of the calling thread.
+    static FloatFormat getFloatFormat();
 
-    /// Return the current float precision.
-    static int getFloatPrecision()
-    {
-        return _floatPrecision;
-    }
+    /// Return the current float precision of the calling thread.
+    static int getFloatPrecision();
 
   protected:
     template <class T> friend class ValueRegistry;
@@ -130,8 +125,6 @@ class MX_CORE_API Value
 
   private:
     static CreatorMap _creatorMap;
-    static FloatFormat _floatFormat;
-    static int _floatPrecision;
 };
 
 /// The class template for typed subclasses of Value
@@ -195,7 +188,8 @@ template <class T> class MX_CORE_API TypedValue : public Value
 };
 
 /// @class ScopedFloatFormatting
-/// An RAII class for controlling the float formatting of values.
+/// An RAII class for controlling the float formatting of values on the
+/// calling thread.
 class MX_CORE_API ScopedFloatFormatting
 {
   public:
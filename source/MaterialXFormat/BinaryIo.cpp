@@ -0,0 +1,366 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <MaterialXFormat/BinaryIo.h>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <unordered_map>
+
+namespace MaterialX
+{
+
+const string MTLX_SNAPSHOT_EXTENSION = "mtlxsnap";
+
+namespace {
+
+const char SNAPSHOT_MAGIC[8] = { 'M', 'T', 'L', 'X', 'S', 'N', 'A', 'P' };
+const uint32_t SNAPSHOT_FORMAT_VERSION = 2;
+const size_t SNAPSHOT_HEADER_SIZE = sizeof(SNAPSHOT_MAGIC) + sizeof(uint32_t) + sizeof(uint64_t);
+
+// Return a path for a temporary file next to the given file, unique to
+// this write within and between processes.
+string getTemporaryFilename(const FilePath& filename)
+{
+    static std::atomic<unsigned int> writeCount(0);
+#if defined(_WIN32)
+    unsigned long processId = (unsigned long) GetCurrentProcessId();
+#else
+    unsigned long processId = (unsigned long) getpid();
+#endif
+    return filename.asString() + "." + std::to_string(processId) + "." + std::to_string(writeCount++) + ".tmp";
+}
+
+// Replace the target file with the source file in a single step, so that
+// readers observe either the previous or the new contents.
+bool replaceFile(const string& source, const string& target)
+{
+#if defined(_WIN32)
+    return MoveFileExA(source.c_str(), target.c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+    return std::rename(source.c_str(), target.c_str()) == 0;
+#endif
+}
+
+bool readBinaryFile(const FilePath& filename, string& contents)
+{
+    std::ifstream file(filename.asString(), std::ios::in | std::ios::binary);
+    if (!file)
+    {
+        return false;
+    }
+    contents.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return !file.bad();
+}
+
+// Return the 64-bit FNV-1a hash of the given file's contents, or zero if the
+// file cannot be read.
+uint64_t getFileHash(const FilePath& filename)
+{
+    string contents;
+    if (!readBinaryFile(filename, contents))
+    {
+        return 0;
+    }
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : contents)
+    {
+        hash ^= (uint64_t) (unsigned char) c;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+class SnapshotWriter
+{
+  public:
+    template<class T> void write(T value)
+    {
+        _buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    void writeString(const string& str)
+    {
+        write((uint32_t) str.size());
+        _buffer.append(str);
+    }
+
+    void writeStringIndex(const string& str)
+    {
+        auto it = _stringIndices.find(str);
+        if (it == _stringIndices.end())
+        {
+            it = _stringIndices.emplace(str, (uint32_t) _strings.size()).first;
+            _strings.push_back(&it->first);
+        }
+        write(it->second);
+    }
+
+    void writeElement(ConstElementPtr elem)
+    {
+        writeStringIndex(elem->getCategory());
+        writeStringIndex(elem->getName());
+        writeStringIndex(elem->getSourceUri());
+
+        const auto& attrNames = elem->getAttributeNames();
+        write((uint32_t) attrNames.size());
+        for (const string& attrName : attrNames)
+        {
+            writeStringIndex(attrName);
+            writeStringIndex(elem->getAttribute(attrName));
+        }
+
+        const vector<ElementPtr>& children = elem->getChildren();
+        write((uint32_t) children.size());
+        for (ConstElementPtr child : children)
+        {
+            writeElement(child);
+        }
+    }
+
+    void writeStringTable()
+    {
+        write((uint32_t) _strings.size());
+        for (const string* str : _strings)
+        {
+            writeString(*str);
+        }
+    }
+
+    string& getBuffer()
+    {
+        return _buffer;
+    }
+
+  private:
+    string _buffer;
+    std::unordered_map<string, uint32_t> _stringIndices;
+    vector<const string*> _strings;
+};
+
+class SnapshotReader
+{
+  public:
+    SnapshotReader(const string& buffer, size_t offset, const FilePath& filename) :
+        _buffer(buffer),
+        _offset(offset),
+        _filename(filename)
+    {
+    }
+
+    template<class T> T read()
+    {
+        T value;
+        require(sizeof(T));
+        std::memcpy(&value, _buffer.data() + _offset, sizeof(T));
+        _offset += sizeof(T);
+        return value;
+    }
+
+    string readString()
+    {
+        uint32_t size = read<uint32_t>();
+        require(size);
+        string str(_buffer.data() + _offset, size);
+        _offset += size;
+        return str;
+    }
+
+    const string& readStringIndex()
+    {
+        uint32_t index = read<uint32_t>();
+        if (index >= _strings.size())
+        {
+            throw ExceptionParseError("Invalid string index in binary snapshot: " + _filename.asString());
+        }
+        return _strings[index];
+    }
+
+    void readStringTable()
+    {
+        uint32_t count = read<uint32_t>();
+        _strings.clear();
+        _strings.reserve(count);
+        for (uint32_t i = 0; i < count; i++)
+        {
+            _strings.push_back(readString());
+        }
+    }
+
+    // Read the next element record into the given element, or skip over it
+    // if the element is null.
+    void readElement(ElementPtr elem)
+    {
+        uint32_t attrCount = read<uint32_t>();
+        for (uint32_t i = 0; i < attrCount; i++)
+        {
+            const string& attrName = readStringIndex();
+            const string& attrValue = readStringIndex();
+            if (elem)
+            {
+                elem->setAttribute(attrName, attrValue);
+            }
+        }
+
+        uint32_t childCount = read<uint32_t>();
+        for (uint32_t i = 0; i < childCount; i++)
+        {
+            const string& category = readStringIndex();
+            const string& name = readStringIndex();
+            const string& sourceUri = readStringIndex();
+
+            // Check for duplicate elements.
+            ElementPtr child;
+            if (elem && !elem->getChild(name))
+            {
+                child = elem->addChildOfCategory(category, name);
+                if (!sourceUri.empty())
+                {
+                    child->setSourceUri(sourceUri);
+                }
+            }
+            readElement(child);
+        }
+    }
+
+    bool atEnd() const
+    {
+        return _offset == _buffer.size();
+    }
+
+  private:
+    void require(size_t size) const
+    {
+        if (_buffer.size() - _offset < size)
+        {
+            throw ExceptionParseError("Unexpected end of binary snapshot: " + _filename.asString());
+        }
+    }
+
+  private:
+    const string& _buffer;
+    size_t _offset;
+    FilePath _filename;
+    StringVec _strings;
+};
+
+} // anonymous namespace
+
+//
+// Snapshot functions
+//
+
+void writeToBinaryFile(DocumentPtr doc, const FilePath& filename, const FilePathVec& dependencies, const string& key)
+{
+    // Serialize dependencies and the element tree, collecting the string
+    // table as a side effect.
+    SnapshotWriter treeWriter;
+    treeWriter.writeStringIndex(EMPTY_STRING);
+    treeWriter.getBuffer().clear();
+    treeWriter.writeElement(doc);
+    string tree;
+    tree.swap(treeWriter.getBuffer());
+    treeWriter.writeStringTable();
+
+    SnapshotWriter payloadWriter;
+    payloadWriter.writeString(key);
+    payloadWriter.write((uint32_t) dependencies.size());
+    for (const FilePath& dependency : dependencies)
+    {
+        payloadWriter.writeString(dependency.asString());
+        payloadWriter.write(getFileHash(dependency));
+    }
+    string& payload = payloadWriter.getBuffer();
+    payload.append(treeWriter.getBuffer());
+    payload.append(tree);
+
+    // Write to a temporary file in the same directory, then move it over the
+    // target, so that concurrent readers never observe a partial snapshot.
+    string tempFilename = getTemporaryFilename(filename);
+    std::ofstream file(tempFilename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        throw ExceptionFileMissing("Failed to open file for writing: " + filename.asString());
+    }
+    uint64_t payloadSize = (uint64_t) payload.size();
+    file.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    file.write(reinterpret_cast<const char*>(&SNAPSHOT_FORMAT_VERSION), sizeof(SNAPSHOT_FORMAT_VERSION));
+    file.write(reinterpret_cast<const char*>(&payloadSize), sizeof(payloadSize));
+    file.write(payload.data(), payload.size());
+    file.close();
+    if (!file || !replaceFile(tempFilename, filename.asString()))
+    {
+        std::remove(tempFilename.c_str());
+        throw ExceptionFileMissing("Failed to write file: " + filename.asString());
+    }
+}
+
+bool readFromBinaryFile(DocumentPtr doc, const FilePath& filename, const FilePathVec& dependencies, const string& key)
+{
+    string buffer;
+    if (!readBinaryFile(filename, buffer) || buffer.size() < SNAPSHOT_HEADER_SIZE)
+    {
+        return false;
+    }
+
+    // Validate the header, treating snapshots from other format versions or
+    // incomplete writes as stale rather than corrupt.
+    SnapshotReader reader(buffer, sizeof(SNAPSHOT_MAGIC), filename);
+    if (std::memcmp(buffer.data(), SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 ||
+        reader.read<uint32_t>() != SNAPSHOT_FORMAT_VERSION ||
+        reader.read<uint64_t>() != (uint64_t) (buffer.size() - SNAPSHOT_HEADER_SIZE))
+    {
+        return false;
+    }
+
+    // Validate the key and dependencies before modifying the document.
+    if (reader.readString() != key)
+    {
+        return false;
+    }
+    uint32_t dependencyCount = reader.read<uint32_t>();
+    if (!dependencies.empty() && dependencyCount != dependencies.size())
+    {
+        return false;
+    }
+    for (uint32_t i = 0; i < dependencyCount; i++)
+    {
+        FilePath dependency = reader.readString();
+        uint64_t hash = reader.read<uint64_t>();
+        if (!dependencies.empty() && dependency != dependencies[i])
+        {
+            return false;
+        }
+        if (getFileHash(dependency) != hash)
+        {
+            return false;
+        }
+    }
+
+    // Restore the element tree, skipping the root category, name and source URI.
+    reader.readStringTable();
+    reader.readStringIndex();
+    reader.readStringIndex();
+    reader.readStringIndex();
+    reader.readElement(doc);
+    if (!reader.atEnd())
+    {
+        throw ExceptionParseError("Unexpected data at end of binary snapshot: " + filename.asString());
+    }
+    return true;
+}
+
+} // namespace MaterialX
@@ -0,0 +1,66 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#ifndef MATERIALX_BINARYIO_H
+#define MATERIALX_BINARYIO_H
+
+/// @file
+/// Support for binary document snapshots
+
+#include <MaterialXCore/Document.h>
+
+#include <MaterialXFormat/Export.h>
+#include <MaterialXFormat/File.h>
+#include <MaterialXFormat/XmlIo.h>
+
+namespace MaterialX
+{
+
+extern MX_FORMAT_API const string MTLX_SNAPSHOT_EXTENSION;
+
+/// @name Binary Snapshots
+/// A binary snapshot stores the fully-resolved element tree of a document,
+/// with all strings deduplicated into a single table, allowing the document
+/// to be restored without XML parsing or XInclude processing.  Snapshots are
+/// intended as a local cache for documents that are expensive to load, such
+/// as the standard data libraries, and are not a portable interchange format.
+/// @{
+
+/// Write a binary snapshot of a Document to the given filename.  The snapshot
+/// is written to a temporary file in the same folder and then moved into
+/// place, so concurrent readers observe either the previous or the new file.
+/// @param doc The Document to be written.
+/// @param filename The filename to which data is written.
+/// @param dependencies An optional set of files from which the document was
+///    loaded.  Their content hashes are stored in the snapshot, and a later
+///    read of the snapshot is rejected if any of these files has changed.
+/// @param key An optional string identifying the settings with which the
+///    document was loaded.  A later read of the snapshot is rejected unless
+///    it provides the same key.
+/// @throws ExceptionFileMissing if the file cannot be written.
+MX_FORMAT_API void writeToBinaryFile(DocumentPtr doc, const FilePath& filename, const FilePathVec& dependencies = FilePathVec(),
+                                     const string& key = EMPTY_STRING);
+
+/// Read a binary snapshot from the given filename into a Document.
+/// @param doc The Document into which data is read.
+/// @param filename The filename from which data is read.
+/// @param dependencies An optional set of files that the snapshot is expected
+///    to depend upon.  If provided, then the snapshot is rejected unless it
+///    records exactly these dependencies, in the same order.
+/// @param key The key with which the snapshot is expected to have been
+///    written.
+/// @return True if the snapshot was read.  False if the file is missing, was
+///    written by an incompatible version or with a different key, is
+///    incomplete, or is stale with respect to its dependencies, in which case
+///    the document is unmodified.
+/// @throws ExceptionParseError if the snapshot contents are corrupt.
+MX_FORMAT_API bool readFromBinaryFile(DocumentPtr doc, const FilePath& filename, const FilePathVec& dependencies = FilePathVec(),
+                                      const string& key = EMPTY_STRING);
+
+/// @}
+
+} // namespace MaterialX
+
+#endif
@@ -153,6 +153,25 @@ bool FilePath::isDirectory() const
 #endif
 }
 
+uint64_t FilePath::getModificationTime() const
+{
+#if defined(_WIN32)
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if (!GetFileAttributesEx(asString().c_str(), GetFileExInfoStandard, &data))
+        return 0;
+    return ((uint64_t) data.ftLastWriteTime.dwHighDateTime << 32) | data.ftLastWriteTime.dwLowDateTime;
+#else
+    struct stat sb;
+    if (stat(asString().c_str(), &sb))
+        return 0;
+#if defined(__APPLE__)
+    return (uint64_t) sb.st_mtimespec.tv_sec * 1000000000ull + (uint64_t) sb.st_mtimespec.tv_nsec;
+#else
+    return (uint64_t) sb.st_mtim.tv_sec * 1000000000ull + (uint64_t) sb.st_mtim.tv_nsec;
+#endif
+#endif
+}
+
 FilePathVec FilePath::getFilesInDirectory(const string& extension) const
 {
     FilePathVec files;
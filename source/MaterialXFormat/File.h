@@ -13,6 +13,8 @@
 
 #include <MaterialXCore/Util.h>
 
+#include <cstdint>
+
 namespace MaterialX
 {
 
@@ -184,6 +186,10 @@ class MX_FORMAT_API FilePath
     /// Return true if the given path is a directory on the file system.
     bool isDirectory() const;
 
+    /// Return the time at which the file at the given path was last modified,
+    /// in platform-specific units, or zero if the file does not exist.
+    uint64_t getModificationTime() const;
+
     /// Return a vector of all files in the given directory with the given extension.
     FilePathVec getFilesInDirectory(const string& extension) const;
 
@@ -5,13 +5,70 @@
 
 #include <MaterialXFormat/Util.h>
 
+#include <MaterialXFormat/BinaryIo.h>
+
+#include <atomic>
+#include <exception>
 #include <fstream>
 #include <iostream>
 #include <sstream>
+#include <thread>
 
 namespace MaterialX
 {
 
+namespace {
+
+// Return the MaterialX files within the given library folders, in load order.
+FilePathVec getLibraryFiles(const FilePathVec& libraryFolders,
+                            const FileSearchPath& searchPath,
+                            const StringSet& excludeFiles)
+{
+    // Append environment path to the specified search path.
+    FileSearchPath librarySearchPath = searchPath;
+    librarySearchPath.append(getEnvironmentPath());
+
+    StringSet uniqueFiles;
+    FilePathVec libraryFiles;
+    auto addLibraryFiles = [&](const FilePath& libraryPath)
+    {
+        for (const FilePath& path : libraryPath.getSubDirectories())
+        {
+            for (const FilePath& filename : path.getFilesInDirectory(MTLX_EXTENSION))
+            {
+                if (!excludeFiles.count(filename))
+                {
+                    const FilePath& file = path / filename;
+                    if (uniqueFiles.count(file) == 0)
+                    {
+                        libraryFiles.push_back(file);
+                        uniqueFiles.insert(file.asString());
+                    }
+                }
+            }
+        }
+    };
+    if (libraryFolders.empty())
+    {
+        // No libraries specified so scan in all search paths
+        for (const FilePath& libraryPath : librarySearchPath)
+        {
+            addLibraryFiles(libraryPath);
+        }
+    }
+    else
+    {
+        // Look for specific library folders in the search paths
+        for (const FilePath& libraryName : libraryFolders)
+        {
+            addLibraryFiles(librarySearchPath.find(libraryName));
+        }
+    }
+    return libraryFiles;
+}
+
+} // anonymous namespace
+
 string readFile(const FilePath& filePath)
 {
     std::ifstream file(filePath.asString(), std::ios::in);
@@ -85,58 +142,146 @@ StringSet loadLibraries(const FilePathVec& libraryFolders,
                         const FileSearchPath& searchPath,
                         DocumentPtr doc,
                         const StringSet& excludeFiles,
-                        const XmlReadOptions* readOptions)
+                        const XmlReadOptions* readOptions,
+                        unsigned int threadCount)
 {
-    // Append environment path to the specified search path.
-    FileSearchPath librarySearchPath = searchPath;
-    librarySearchPath.append(getEnvironmentPath());
-
+    // Collect the library files to be loaded, in order.
+    FilePathVec libraryFiles = getLibraryFiles(libraryFolders, searchPath, excludeFiles);
     StringSet loadedLibraries;
-    if (libraryFolders.empty())
+    for (const FilePath& file : libraryFiles)
     {
-        // No libraries specified so scan in all search paths
-        for (const FilePath& libraryPath : librarySearchPath)
+        loadedLibraries.insert(file.asString());
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = (unsigned int) std::min((size_t) threadCount, libraryFiles.size());
+
+    if (threadCount <= 1)
+    {
+        for (const FilePath& file : libraryFiles)
         {
-            for (const FilePath& path : libraryPath.getSubDirectories())
-            {
-                for (const FilePath& filename : path.getFilesInDirectory(MTLX_EXTENSION))
-                {
-                    if (!excludeFiles.count(filename))
-                    {
-                        const FilePath& file = path / filename;
-                        if (loadedLibraries.count(file) == 0)
-                        {
-                            loadLibrary(file, doc, searchPath, readOptions);
-                            loadedLibraries.insert(file.asString());
-                        }
-                    }
-                }
-            }
+            loadLibrary(file, doc, searchPath, readOptions);
         }
+        return loadedLibraries;
     }
-    else
+
+    // Parse each library file into its own document on a pool of threads.
+    vector<DocumentPtr> libraryDocs(libraryFiles.size());
+    vector<std::exception_ptr> libraryErrors(libraryFiles.size());
+    std::atomic<size_t> nextIndex(0);
+    auto readLibraryFiles = [&]()
     {
-        // Look for specific library folders in the search paths
-        for (const FilePath& libraryName : libraryFolders)
+        for (size_t i = nextIndex++; i < libraryFiles.size(); i = nextIndex++)
         {
-            FilePath libraryPath = librarySearchPath.find(libraryName);
-            for (const FilePath& path : libraryPath.getSubDirectories())
+            try
             {
-                for (const FilePath& filename : path.getFilesInDirectory(MTLX_EXTENSION))
-                {
-                    if (!excludeFiles.count(filename))
-                    {
-                        const FilePath& file = path / filename;
-                        if (loadedLibraries.count(file) == 0)
-                        {
-                            loadLibrary(file, doc, searchPath, readOptions);
-                            loadedLibraries.insert(file.asString());
-                        }
-                    }
-                }
+                DocumentPtr libraryDoc = createDocument();
+                readFromXmlFile(libraryDoc, libraryFiles[i], searchPath, readOptions);
+                libraryDocs[i] = libraryDoc;
+            }
+            catch (...)
+            {
+                libraryErrors[i] = std::current_exception();
             }
         }
+    };
+    runWorkerThreads(threadCount, readLibraryFiles);
+
+    // Import the parsed libraries in their original order, so that the
+    // resulting document matches the serial path.
+    for (size_t i = 0; i < libraryDocs.size(); i++)
+    {
+        if (libraryErrors[i])
+        {
+            std::rethrow_exception(libraryErrors[i]);
+        }
+        doc->importLibrary(libraryDocs[i]);
+    }
+    return loadedLibraries;
+}
+
+StringSet loadLibrariesWithSnapshot(const FilePathVec& libraryFolders,
+                                    const FileSearchPath& searchPath,
+                                    DocumentPtr doc,
+                                    const FilePath& snapshotFile,
+                                    const StringSet& excludeFiles,
+                                    const XmlReadOptions* readOptions)
+{
+    // Shared XIncludes are held in referenced libraries rather than in the
+    // document, so are not restored from a snapshot.
+    if (readOptions && readOptions->shareXIncludes)
+    {
+        return loadLibraries(libraryFolders, searchPath, doc, excludeFiles, readOptions);
+    }
+
+    FilePathVec libraryFiles = getLibraryFiles(libraryFolders, searchPath, excludeFiles);
+    StringSet loadedLibraries;
+    for (const FilePath& file : libraryFiles)
+    {
+        loadedLibraries.insert(file.asString());
+    }
+
+    // Key the snapshot by the library files, the search path used to resolve
+    // their XIncludes, and the read options that affect their contents.
+    const char SEPARATOR = '\n';
+    XmlReadOptions trackedOptions = readOptions ? *readOptions : XmlReadOptions();
+    string key = searchPath.asString();
+    key += SEPARATOR;
+    key += trackedOptions.readXIncludeFunction ? "xinclude" : "noxinclude";
+    key += SEPARATOR;
+    key += trackedOptions.readComments ? "comments" : "nocomments";
+    for (const string& parent : trackedOptions.parentXIncludes)
+    {
+        key += SEPARATOR;
+        key += parent;
+    }
+    key += SEPARATOR;
+    for (const FilePath& file : libraryFiles)
+    {
+        key += SEPARATOR;
+        key += file.asString();
+    }
+
+    // Restore libraries from the snapshot if it matches the current files,
+    // importing them as when loading from XML so that the attributes of the
+    // given document are preserved.
+    try
+    {
+        DocumentPtr snapshotDoc = createDocument();
+        if (readFromBinaryFile(snapshotDoc, snapshotFile, FilePathVec(), key))
+        {
+            doc->importLibrary(snapshotDoc);
+            return loadedLibraries;
+        }
+    }
+    catch (ExceptionParseError&)
+    {
+        // Corrupt snapshots are rebuilt below.
+    }
+
+    // Otherwise load libraries from XML, tracking the files they include,
+    // and write a new snapshot that depends on all files read.
+    FilePathVec dependencies = libraryFiles;
+    if (trackedOptions.readXIncludeFunction)
+    {
+        XmlReadFunction readXInclude = trackedOptions.readXIncludeFunction;
+        trackedOptions.readXIncludeFunction = [&dependencies, readXInclude](DocumentPtr includeDoc, const FilePath& filename,
+                                                                            const FileSearchPath& includeSearchPath, const XmlReadOptions* options)
+        {
+            dependencies.push_back(includeSearchPath.find(filename));
+            readXInclude(includeDoc, filename, includeSearchPath, options);
+        };
+    }
+    DocumentPtr libraryDoc = createDocument();
+    for (const FilePath& file : libraryFiles)
+    {
+        loadLibrary(file, libraryDoc, searchPath, &trackedOptions);
     }
+    writeToBinaryFile(libraryDoc, snapshotFile, dependencies, key);
+    doc->importLibrary(libraryDoc);
     return loadedLibraries;
 }
 
@@ -46,11 +46,48 @@ MX_FORMAT_API void loadLibrary(const FilePath& file,
 
 /// Load all MaterialX files within the given library folders into a document,
 /// using the given search path to locate the folders on the file system.
+/// @param libraryFolders The library folders to load, or an empty vector to
+///    load all folders within the search path.
+/// @param searchPath The search path used to locate the library folders.
+/// @param doc The document into which libraries are imported.
+/// @param excludeFiles An optional set of file names to skip.
+/// @param readOptions Optional settings for reading each library file.
+/// @param threadCount The number of threads on which library files are parsed.
+///    Files are parsed into separate documents in parallel, and then imported
+///    in the same order as the serial path, giving an identical result.  A
+///    value of zero selects the hardware concurrency of the system, and the
+///    default value of one loads all files serially.  When parsing in parallel,
+///    any custom read function in the given options must be thread-safe.
+/// @return The set of library files that were loaded.
 MX_FORMAT_API StringSet loadLibraries(const FilePathVec& libraryFolders,
                         const FileSearchPath& searchPath,
                         DocumentPtr doc,
                         const StringSet& excludeFiles = StringSet(),
-                        const XmlReadOptions* readOptions = nullptr);
+                        const XmlReadOptions* readOptions = nullptr,
+                        unsigned int threadCount = 1);
+
+/// Load all MaterialX files within the given library folders into a document,
+/// restoring them from a binary snapshot file when possible.
+/// @param libraryFolders The library folders to load, or an empty vector to
+///    load all folders within the search path.
+/// @param searchPath The search path used to locate the library folders.
+/// @param doc The document into which libraries are imported.
+/// @param snapshotFile The binary snapshot file to read.  If the snapshot is
+///    missing, was written with different read options, or any library file
+///    or file included by a library has been added, removed or modified
+///    since it was written, then libraries are loaded from XML as in
+///    loadLibraries, and a new snapshot is written to this file.
+/// @param excludeFiles An optional set of file names to skip.
+/// @param readOptions Optional settings for reading each library file.  If
+///    shared XIncludes are requested, then libraries are always loaded from
+///    XML.
+/// @return The set of library files that were loaded.
+MX_FORMAT_API StringSet loadLibrariesWithSnapshot(const FilePathVec& libraryFolders,
+                                    const FileSearchPath& searchPath,
+                                    DocumentPtr doc,
+                                    const FilePath& snapshotFile,
+                                    const StringSet& excludeFiles = StringSet(),
+                                    const XmlReadOptions* readOptions = nullptr);
 
 /// Flatten all filenames in the given document, applying string resolvers at the
 /// scope of each element and removing all fileprefix attributes.
@@ -9,9 +9,15 @@
 
 #include <MaterialXCore/Types.h>
 
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
+#include <mutex>
 #include <sstream>
+#include <unordered_map>
 
 using namespace pugi;
 
@@ -26,6 +32,33 @@ const string XINCLUDE_TAG = "xi:include";
 const string XINCLUDE_NAMESPACE = "xmlns:xi";
 const string XINCLUDE_URL = "http://www.w3.org/2001/XInclude";
 
+// Shared library documents read with XmlReadOptions::shareXIncludes, keyed
+// by read options and by the resolved filenames and modification times of
+// their includes.
+std::mutex xincludeCacheMutex;
+std::unordered_map<string, DocumentPtr> xincludeCache;
+
+// Return the portion of a shared library key that identifies the given read
+// options and XInclude read function, or an empty string if the function has
+// no stable identity, in which case the library cannot be cached.
+string getXIncludeOptionsKey(const XmlReadOptions& readOptions, const XmlReadFunction& readFunction)
+{
+    using ReadFunctionPtr = void (*)(DocumentPtr, FilePath, FileSearchPath, const XmlReadOptions*);
+    const ReadFunctionPtr* target = readFunction.target<ReadFunctionPtr>();
+    if (!target)
+    {
+        return EMPTY_STRING;
+    }
+
+    string key = std::to_string(reinterpret_cast<uintptr_t>(*target));
+    key += readOptions.readComments ? "|comments|" : "|";
+    for (const string& parent : readOptions.parentXIncludes)
+    {
+        key += parent + PATH_LIST_SEPARATOR;
+    }
+    return key + "|";
+}
+
 void elementFromXml(const xml_node& xmlNode, ElementPtr elem, const XmlReadOptions* readOptions)
 {
     // Store attributes in element.
@@ -71,24 +104,50 @@ void elementFromXml(const xml_node& xmlNode, ElementPtr elem, const XmlReadOptio
     }
 }
 
-void elementToXml(ConstElementPtr elem, xml_node& xmlNode, const XmlWriteOptions* writeOptions)
+// An XInclude reference or child element to be written for an element.
+struct XmlWriteItem
+{
+    string xinclude;
+    ElementPtr child;
+};
+
+// Return the XInclude references and child elements to be written for the
+// given element, in order.
+vector<XmlWriteItem> getXmlWriteItems(ConstElementPtr elem, const XmlWriteOptions* writeOptions)
 {
     bool writeXIncludeEnable = writeOptions ? writeOptions->writeXIncludeEnable : true;
     ElementPredicate elementPredicate = writeOptions ? writeOptions->elementPredicate : nullptr;
 
-    // Store attributes in XML.
-    if (!elem->getName().empty())
+    vector<XmlWriteItem> items;
+    StringSet writtenSourceFiles;
+    auto addXInclude = [&items, &writtenSourceFiles](const string& sourceUri)
     {
-        xmlNode.append_attribute(Element::NAME_ATTRIBUTE.c_str()) = elem->getName().c_str();
-    }
-    for (const string& attrName : elem->getAttributeNames())
+        if (!sourceUri.empty() && !writtenSourceFiles.count(sourceUri))
+        {
+            // Write relative include paths in Posix format, and absolute
+            // include paths in native format.
+            FilePath includePath(sourceUri);
+            FilePath::Format includeFormat = includePath.isAbsolute() ?
+                FilePath::FormatNative : FilePath::FormatPosix;
+            items.push_back({ includePath.asString(includeFormat), nullptr });
+            writtenSourceFiles.insert(sourceUri);
+        }
+    };
+
+    // Write XInclude references for referenced libraries.
+    ConstDocumentPtr doc = elem->asA<Document>();
+    if (doc && writeXIncludeEnable)
     {
-        xml_attribute xmlAttr = xmlNode.append_attribute(attrName.c_str());
-        xmlAttr.set_value(elem->getAttribute(attrName).c_str());
+        for (DocumentPtr library : doc->getReferencedLibraries())
+        {
+            addXInclude(library->getSourceUri());
+            for (ElementPtr child : library->getChildren())
+            {
+                addXInclude(child->getSourceUri());
+            }
+        }
     }
 
-    // Create child nodes and recurse.
-    StringSet writtenSourceFiles;
     for (auto child : elem->getChildren())
     {
         if (elementPredicate && !elementPredicate(child))
@@ -99,101 +158,228 @@ void elementToXml(ConstElementPtr elem, xml_node& xmlNode, const XmlWriteOptions
         // Write XInclude references if requested.
         if (writeXIncludeEnable && child->hasSourceUri())
         {
-            string sourceUri = child->getSourceUri();
+            const string& sourceUri = child->getSourceUri();
             if (sourceUri != elem->getDocument()->getSourceUri())
             {
-                if (!writtenSourceFiles.count(sourceUri))
-                {
-                    if (!xmlNode.attribute(XINCLUDE_NAMESPACE.c_str()))
-                    {
-                        xmlNode.append_attribute(XINCLUDE_NAMESPACE.c_str()) = XINCLUDE_URL.c_str();
-                    }
-                    xml_node includeNode = xmlNode.append_child(XINCLUDE_TAG.c_str());
-                    xml_attribute includeAttr = includeNode.append_attribute("href");
-                    FilePath includePath(sourceUri);
+                addXInclude(sourceUri);
+                continue;
+            }
+        }
 
-                    // Write relative include paths in Posix format, and absolute
-                    // include paths in native format.
-                    FilePath::Format includeFormat = includePath.isAbsolute() ?
-                        FilePath::FormatNative : FilePath::FormatPosix;
-                    includeAttr.set_value(includePath.asString(includeFormat).c_str());
+        items.push_back({ EMPTY_STRING, child });
+    }
+    return items;
+}
 
-                    writtenSourceFiles.insert(sourceUri);
-                }
-                continue;
+void elementToXml(ConstElementPtr elem, xml_node& xmlNode, const XmlWriteOptions* writeOptions)
+{
+    // Store attributes in XML.
+    if (!elem->getName().empty())
+    {
+        xmlNode.append_attribute(Element::NAME_ATTRIBUTE.c_str()) = elem->getName().c_str();
+    }
+    for (const string& attrName : elem->getAttributeNames())
+    {
+        xml_attribute xmlAttr = xmlNode.append_attribute(attrName.c_str());
+        xmlAttr.set_value(elem->getAttribute(attrName).c_str());
+    }
+
+    // Create child nodes and recurse.
+    for (const XmlWriteItem& item : getXmlWriteItems(elem, writeOptions))
+    {
+        // Write XInclude references.
+        if (!item.child)
+        {
+            if (!xmlNode.attribute(XINCLUDE_NAMESPACE.c_str()))
+            {
+                xmlNode.append_attribute(XINCLUDE_NAMESPACE.c_str()) = XINCLUDE_URL.c_str();
             }
+            xml_node includeNode = xmlNode.append_child(XINCLUDE_TAG.c_str());
+            includeNode.append_attribute("href") = item.xinclude.c_str();
+            continue;
         }
 
         // Write XML comments.
-        if (child->getCategory() == CommentElement::CATEGORY)
+        if (item.child->getCategory() == CommentElement::CATEGORY)
         {
             xml_node xmlChild = xmlNode.append_child(node_comment);
-            xmlChild.set_value(child->getAttribute(Element::DOC_ATTRIBUTE).c_str());
+            xmlChild.set_value(item.child->getAttribute(Element::DOC_ATTRIBUTE).c_str());
             continue;
         }
 
-        xml_node xmlChild = xmlNode.append_child(child->getCategory().c_str());
-        elementToXml(child, xmlChild, writeOptions);
+        xml_node xmlChild = xmlNode.append_child(item.child->getCategory().c_str());
+        elementToXml(item.child, xmlChild, writeOptions);
     }
 }
 
-void processXIncludes(DocumentPtr doc, xml_node& xmlNode, const FileSearchPath& searchPath, const XmlReadOptions* readOptions)
+// Reads the XInclude references of a document, in the order they are given.
+class XIncludeReader
 {
-    // Search path for includes. Set empty and then evaluated once in the iteration through xml includes.
-    FileSearchPath includeSearchPath;
+  public:
+    XIncludeReader(DocumentPtr doc, const FileSearchPath& searchPath, const XmlReadOptions* readOptions) :
+        _doc(doc),
+        _searchPath(searchPath),
+        _readOptions(readOptions),
+        _readXIncludeFunction(readOptions ? readOptions->readXIncludeFunction : readFromXmlFile)
+    {
+    }
 
-    XmlReadFunction readXIncludeFunction = readOptions ? readOptions->readXIncludeFunction : readFromXmlFile;
-    xml_node xmlChild = xmlNode.first_child();
-    while (xmlChild)
+    // Read the XInclude reference with the given filename, importing its
+    // contents into the document unless shared XIncludes are requested.
+    void readXInclude(const string& filename)
     {
-        if (xmlChild.name() == XINCLUDE_TAG)
+        DocumentPtr library = readXIncludeLibrary(filename);
+        if (library)
         {
-            // Read XInclude references if requested.
-            if (readXIncludeFunction)
+            _doc->importLibrary(library);
+        }
+    }
+
+    // Read the XInclude reference with the given filename into a library
+    // document to be imported, returning nullptr if XIncludes are not read
+    // or if the reference is deferred to a shared library.
+    DocumentPtr readXIncludeLibrary(const string& filename)
+    {
+        // Read XInclude references if requested.
+        if (!_readXIncludeFunction)
+        {
+            return nullptr;
+        }
+
+        // Check for XInclude cycles.
+        if (_readOptions)
+        {
+            const StringVec& parents = _readOptions->parentXIncludes;
+            if (std::find(parents.begin(), parents.end(), filename) != parents.end())
+            {
+                throw ExceptionParseError("XInclude cycle detected.");
+            }
+        }
+
+        if (_readOptions && _readOptions->shareXIncludes)
+        {
+            // Defer shared includes until all have been gathered.
+            _sharedIncludes.push_back(filename);
+            return nullptr;
+        }
+
+        // Read the included file into a library document.
+        DocumentPtr library = createDocument();
+        XmlReadOptions xiReadOptions = _readOptions ? *_readOptions : XmlReadOptions();
+        xiReadOptions.parentXIncludes.push_back(filename);
+        _readXIncludeFunction(library, filename, getIncludeSearchPath(), &xiReadOptions);
+        return library;
+    }
+
+    // Complete the reading of XInclude references, referencing a shared
+    // library document for any shared includes.
+    void finish()
+    {
+        if (_sharedIncludes.empty())
+        {
+            return;
+        }
+
+        // Gather the resolved filenames of shared includes, which in order
+        // and with their modification times identify a shared library
+        // document read with the given options.
+        const FileSearchPath& includeSearchPath = getIncludeSearchPath();
+        StringVec sharedFilenames;
+        string cacheKey = getXIncludeOptionsKey(*_readOptions, _readXIncludeFunction);
+        const bool cacheable = !cacheKey.empty();
+        for (const string& filename : _sharedIncludes)
+        {
+            FilePath resolvedFilename = includeSearchPath.find(filename);
+            sharedFilenames.push_back(resolvedFilename.asString());
+            cacheKey += sharedFilenames.back() + "@" +
+                        std::to_string(resolvedFilename.getModificationTime()) + PATH_LIST_SEPARATOR;
+        }
+
+        // Reference the shared library document, reading it on first use.
+        DocumentPtr library;
+        if (cacheable)
+        {
+            std::lock_guard<std::mutex> lock(xincludeCacheMutex);
+            auto it = xincludeCache.find(cacheKey);
+            if (it != xincludeCache.end())
             {
-                string filename = xmlChild.attribute("href").value();
+                library = it->second;
+            }
+        }
+        if (!library)
+        {
+            library = createDocument();
+            for (size_t i = 0; i < _sharedIncludes.size(); i++)
+            {
+                XmlReadOptions xiReadOptions = *_readOptions;
+                xiReadOptions.parentXIncludes.push_back(_sharedIncludes[i]);
+                xiReadOptions.shareXIncludes = false;
 
-                // Check for XInclude cycles.
-                if (readOptions)
+                DocumentPtr includeDoc = createDocument();
+                _readXIncludeFunction(includeDoc, _sharedIncludes[i], includeSearchPath, &xiReadOptions);
+                for (ElementPtr child : includeDoc->getChildren())
                 {
-                    const StringVec& parents = readOptions->parentXIncludes;
-                    if (std::find(parents.begin(), parents.end(), filename) != parents.end())
-                    {
-                        throw ExceptionParseError("XInclude cycle detected.");
-                    }
+                    child->setSourceUri(sharedFilenames[i]);
                 }
+                library->importLibrary(includeDoc);
+            }
 
-                // Read the included file into a library document.
-                DocumentPtr library = createDocument();
-                XmlReadOptions xiReadOptions = readOptions ? *readOptions : XmlReadOptions();
-                xiReadOptions.parentXIncludes.push_back(filename);
+            if (cacheable)
+            {
+                std::lock_guard<std::mutex> lock(xincludeCacheMutex);
+                library = xincludeCache.emplace(cacheKey, library).first->second;
+            }
+        }
+        _doc->addReferencedLibrary(library);
+        _sharedIncludes.clear();
+    }
 
-                // Prepend the directory of the parent to accommodate
-                // includes relative to the parent file location.
-                if (includeSearchPath.isEmpty())
+  private:
+    // Return the search path for includes, evaluated on first use.
+    const FileSearchPath& getIncludeSearchPath()
+    {
+        // Prepend the directory of the parent to accommodate
+        // includes relative to the parent file location.
+        if (_includeSearchPath.isEmpty())
+        {
+            string parentUri = _doc->getSourceUri();
+            if (!parentUri.empty())
+            {
+                FilePath filePath = _searchPath.find(parentUri);
+                if (!filePath.isEmpty())
                 {
-                    string parentUri = doc->getSourceUri();
-                    if (!parentUri.empty())
-                    {
-                        FilePath filePath = searchPath.find(parentUri);
-                        if (!filePath.isEmpty())
-                        {
-                            // Remove the file name from the path as we want the path to the containing folder.
-                            includeSearchPath = searchPath;
-                            includeSearchPath.prepend(filePath.getParentPath());
-                        }
-                    }
-                    // Set default search path if no parent path found
-                    if (includeSearchPath.isEmpty())
-                    {
-                        includeSearchPath = searchPath;
-                    }
+                    // Remove the file name from the path as we want the path to the containing folder.
+                    _includeSearchPath = _searchPath;
+                    _includeSearchPath.prepend(filePath.getParentPath());
                 }
-                readXIncludeFunction(library, filename, includeSearchPath, &xiReadOptions);
-
-                // Import the library document.
-                doc->importLibrary(library);
             }
+            // Set default search path if no parent path found
+            if (_includeSearchPath.isEmpty())
+            {
+                _includeSearchPath = _searchPath;
+            }
+        }
+        return _includeSearchPath;
+    }
+
+  private:
+    DocumentPtr _doc;
+    const FileSearchPath& _searchPath;
+    const XmlReadOptions* _readOptions;
+    XmlReadFunction _readXIncludeFunction;
+    FileSearchPath _includeSearchPath;
+    StringVec _sharedIncludes;
+};
+
+void processXIncludes(DocumentPtr doc, xml_node& xmlNode, const FileSearchPath& searchPath, const XmlReadOptions* readOptions)
+{
+    XIncludeReader xincludeReader(doc, searchPath, readOptions);
+    xml_node xmlChild = xmlNode.first_child();
+    while (xmlChild)
+    {
+        if (xmlChild.name() == XINCLUDE_TAG)
+        {
+            xincludeReader.readXInclude(xmlChild.attribute("href").value());
 
             // Remove include directive.
             xml_node includeNode = xmlChild;
@@ -205,6 +391,7 @@ void processXIncludes(DocumentPtr doc, xml_node& xmlNode, const FileSearchPath&
             xmlChild = xmlChild.next_sibling();
         }
     }
+    xincludeReader.finish();
 }
 
 void documentFromXml(DocumentPtr doc,
@@ -258,6 +445,842 @@ unsigned int getParseOptions(const XmlReadOptions* readOptions)
     return parseOptions;
 }
 
+// This must be done before parsing the XML as the source URI
+// is used for searching for include files.
+void setDocumentSourceUri(DocumentPtr doc, const FilePath& filename, const XmlReadOptions* readOptions)
+{
+    if (readOptions && !readOptions->parentXIncludes.empty())
+    {
+        doc->setSourceUri(readOptions->parentXIncludes[0]);
+    }
+    else
+    {
+        doc->setSourceUri(filename);
+    }
+}
+
+// A pull parser for the subset of XML used by MaterialX documents, which
+// reads from an input stream in fixed-size blocks and reports elements,
+// comments, and character data as they are encountered.
+class XmlStreamParser
+{
+  public:
+    enum Event
+    {
+        START_ELEMENT,
+        END_ELEMENT,
+        COMMENT,
+        TEXT,
+        END_DOCUMENT
+    };
+
+    using Attribute = std::pair<string, string>;
+
+    XmlStreamParser(std::istream& stream, const FilePath& filename) :
+        _stream(stream),
+        _filename(filename),
+        _buffer(BUFFER_SIZE),
+        _bufferPos(0),
+        _bufferSize(0),
+        _offset(0),
+        _pendingTag(false),
+        _pendingEnd(false)
+    {
+        readByteOrderMark();
+    }
+
+    // Advance to the next event in the stream.
+    Event next()
+    {
+        if (_pendingEnd)
+        {
+            _pendingEnd = false;
+            return endElement();
+        }
+
+        while (true)
+        {
+            if (!_pendingTag)
+            {
+                // Read character data up to the next tag.
+                if (!readText())
+                {
+                    if (!_openElements.empty())
+                    {
+                        error("Start-end tags mismatch");
+                    }
+                    return END_DOCUMENT;
+                }
+                if (!_text.empty())
+                {
+                    _pendingTag = true;
+                    return TEXT;
+                }
+            }
+            _pendingTag = false;
+
+            int c = get();
+            if (c == '?')
+            {
+                skipPast("?>");
+            }
+            else if (c == '!')
+            {
+                c = get();
+                if (c == '-')
+                {
+                    if (get() != '-')
+                    {
+                        error("Error parsing comment");
+                    }
+                    readUntil("-->");
+                    return COMMENT;
+                }
+                else if (c == '[')
+                {
+                    skipPast("CDATA[");
+                    readUntil("]]>");
+                    return TEXT;
+                }
+                else
+                {
+                    skipDeclaration();
+                }
+            }
+            else if (c == '/')
+            {
+                _name = readName(get());
+                if (skipWhitespace() != '>' || _openElements.empty() || _openElements.back() != _name)
+                {
+                    error("Start-end tags mismatch");
+                }
+                return endElement();
+            }
+            else
+            {
+                readStartTag(c);
+                return START_ELEMENT;
+            }
+        }
+    }
+
+    // Return the name of the current element.
+    const string& getName() const
+    {
+        return _name;
+    }
+
+    // Return the attributes of the current start element.
+    const vector<Attribute>& getAttributes() const
+    {
+        return _attributes;
+    }
+
+    // Return the value of the given attribute of the current start element.
+    const string& getAttribute(const string& name) const
+    {
+        for (const Attribute& attr : _attributes)
+        {
+            if (attr.first == name)
+            {
+                return attr.second;
+            }
+        }
+        return EMPTY_STRING;
+    }
+
+    // Return the text of the current comment or character data.
+    const string& getText() const
+    {
+        return _text;
+    }
+
+  private:
+    int get()
+    {
+        if (_bufferPos == _bufferSize && !fill())
+        {
+            return EOF;
+        }
+        return (unsigned char) _buffer[_bufferPos++];
+    }
+
+    int peek()
+    {
+        if (_bufferPos == _bufferSize && !fill())
+        {
+            return EOF;
+        }
+        return (unsigned char) _buffer[_bufferPos];
+    }
+
+    // Append characters to the given string, if any, up to the first character
+    // for which the given predicate returns true.  Returns that character
+    // without consuming it, or EOF at the end of the stream.
+    template <class Predicate> int readSpan(string* str, Predicate isTerminator)
+    {
+        while (_bufferPos < _bufferSize || fill())
+        {
+            const char* begin = _buffer.data() + _bufferPos;
+            const char* end = _buffer.data() + _bufferSize;
+            const char* it = begin;
+            while (it != end && !isTerminator((unsigned char) *it))
+            {
+                ++it;
+            }
+            if (str)
+            {
+                str->append(begin, it);
+            }
+            _bufferPos += it - begin;
+            if (it != end)
+            {
+                return (unsigned char) *it;
+            }
+        }
+        return EOF;
+    }
+
+    // Skip a UTF-8 byte order mark at the start of the stream, and reject
+    // UTF-16 and UTF-32 content, which this parser does not decode.
+    void readByteOrderMark()
+    {
+        if (!fill())
+        {
+            return;
+        }
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(_buffer.data());
+        if (_bufferSize >= 3 && data[0] == 0xEF && data[1] == 0xBB && data[2] == 0xBF)
+        {
+            _bufferPos = 3;
+        }
+        else if (_bufferSize >= 2 && (data[0] == 0 || data[1] == 0 ||
+                                      (data[0] == 0xFE && data[1] == 0xFF) ||
+                                      (data[0] == 0xFF && data[1] == 0xFE)))
+        {
+            error("Unsupported document encoding, expected UTF-8");
+        }
+    }
+
+    bool fill()
+    {
+        _offset += _bufferSize;
+        _stream.read(_buffer.data(), _buffer.size());
+        _bufferSize = (size_t) _stream.gcount();
+        _bufferPos = 0;
+        return _bufferSize > 0;
+    }
+
+    static bool isWhitespace(int c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    // Return the next character that is not whitespace.
+    int skipWhitespace()
+    {
+        int c = get();
+        while (isWhitespace(c))
+        {
+            c = get();
+        }
+        return c;
+    }
+
+    void skipPast(const string& terminator)
+    {
+        string tail;
+        for (int c = get(); c != EOF; c = get())
+        {
+            tail.push_back((char) c);
+            if (tail.size() > terminator.size())
+            {
+                tail.erase(0, 1);
+            }
+            if (tail == terminator)
+            {
+                return;
+            }
+        }
+        error("Unexpected end of file");
+    }
+
+    void skipDeclaration()
+    {
+        int depth = 0;
+        for (int c = get(); c != EOF; c = get())
+        {
+            if (c == '[')
+            {
+                depth++;
+            }
+            else if (c == ']')
+            {
+                depth--;
+            }
+            else if (c == '>' && depth <= 0)
+            {
+                return;
+            }
+        }
+        error("Unexpected end of file");
+    }
+
+    static bool isNameTerminator(int c)
+    {
+        return isWhitespace(c) || c == '/' || c == '>' || c == '=';
+    }
+
+    string readName(int first)
+    {
+        if (first == EOF || isNameTerminator(first))
+        {
+            error("Error parsing start element tag");
+        }
+        string name(1, (char) first);
+        readSpan(&name, isNameTerminator);
+        return name;
+    }
+
+    void readStartTag(int first)
+    {
+        _name = readName(first);
+        _attributes.clear();
+        while (true)
+        {
+            int c = skipWhitespace();
+            if (c == '>')
+            {
+                _openElements.push_back(_name);
+                return;
+            }
+            if (c == '/')
+            {
+                if (get() != '>')
+                {
+                    error("Error parsing start element tag");
+                }
+                _openElements.push_back(_name);
+                _pendingEnd = true;
+                return;
+            }
+            if (c == EOF)
+            {
+                error("Error parsing start element tag");
+            }
+
+            string attrName = readName(c);
+            if (skipWhitespace() != '=')
+            {
+                error("Error parsing element attribute");
+            }
+            int quote = skipWhitespace();
+            if (quote != '"' && quote != '\'')
+            {
+                error("Error parsing element attribute");
+            }
+            _attributes.emplace_back(attrName, readAttributeValue(quote));
+        }
+    }
+
+    // Read an attribute value, expanding character references and converting
+    // whitespace characters to spaces.
+    string readAttributeValue(int quote)
+    {
+        string value;
+        auto isTerminator = [quote](int c)
+        {
+            return c == quote || c == '&' || c == '\r' || c == '\n' || c == '\t';
+        };
+        while (true)
+        {
+            readSpan(&value, isTerminator);
+            int c = get();
+            if (c == quote)
+            {
+                return value;
+            }
+            else if (c == EOF)
+            {
+                error("Error parsing element attribute");
+            }
+            else if (c == '&')
+            {
+                value += readReference();
+            }
+            else if (c == '\r')
+            {
+                if (peek() == '\n')
+                {
+                    get();
+                }
+                value.push_back(' ');
+            }
+            else if (c == '\n' || c == '\t')
+            {
+                value.push_back(' ');
+            }
+            else
+            {
+                value.push_back((char) c);
+            }
+        }
+    }
+
+    // Read a character or entity reference following an ampersand, returning
+    // its expansion.  Unrecognized references are returned unchanged.
+    string readReference()
+    {
+        const size_t MAX_REFERENCE_LENGTH = 10;
+        string ref;
+        int c = peek();
+        while (c != EOF && (std::isalnum(c) || c == '#') && ref.size() < MAX_REFERENCE_LENGTH)
+        {
+            ref.push_back((char) get());
+            c = peek();
+        }
+        if (c != ';')
+        {
+            return "&" + ref;
+        }
+        get();
+
+        if (ref == "lt")
+            return "<";
+        if (ref == "gt")
+            return ">";
+        if (ref == "amp")
+            return "&";
+        if (ref == "quot")
+            return "\"";
+        if (ref == "apos")
+            return "'";
+        if (ref.size() > 1 && ref[0] == '#')
+        {
+            bool hex = ref[1] == 'x';
+            string digits = ref.substr(hex ? 2 : 1);
+            char* end = nullptr;
+            unsigned long code = std::strtoul(digits.c_str(), &end, hex ? 16 : 10);
+            if (!digits.empty() && *end == 0 && code > 0 && code <= 0x10FFFF)
+            {
+                return encodeUtf8((unsigned int) code);
+            }
+        }
+        return "&" + ref + ";";
+    }
+
+    static string encodeUtf8(unsigned int code)
+    {
+        string str;
+        if (code < 0x80)
+        {
+            str.push_back((char) code);
+        }
+        else if (code < 0x800)
+        {
+            str.push_back((char) (0xC0 | (code >> 6)));
+            str.push_back((char) (0x80 | (code & 0x3F)));
+        }
+        else if (code < 0x10000)
+        {
+            str.push_back((char) (0xE0 | (code >> 12)));
+            str.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+            str.push_back((char) (0x80 | (code & 0x3F)));
+        }
+        else
+        {
+            str.push_back((char) (0xF0 | (code >> 18)));
+            str.push_back((char) (0x80 | ((code >> 12) & 0x3F)));
+            str.push_back((char) (0x80 | ((code >> 6) & 0x3F)));
+            str.push_back((char) (0x80 | (code & 0x3F)));
+        }
+        return str;
+    }
+
+    // Read character data up to the next tag, expanding character references
+    // and normalizing line endings.  Character data outside of elements and
+    // data consisting only of whitespace are discarded.  Returns false if the
+    // end of the stream is reached.
+    bool readText()
+    {
+        bool hasEntities = false;
+        _text.clear();
+        string* text = _openElements.empty() ? nullptr : &_text;
+        auto isTerminator = [](int c)
+        {
+            return c == '<' || c == '&' || c == '\r';
+        };
+        for (int c = readSpan(text, isTerminator); c != EOF; c = readSpan(text, isTerminator))
+        {
+            c = get();
+            if (c == '<')
+            {
+                if (!hasEntities && _text.find_first_not_of(" \t\n\r") == string::npos)
+                {
+                    _text.clear();
+                }
+                return true;
+            }
+            if (!text)
+            {
+                continue;
+            }
+            if (c == '&')
+            {
+                _text += readReference();
+                hasEntities = true;
+                continue;
+            }
+            if (c == '\r')
+            {
+                if (peek() == '\n')
+                {
+                    get();
+                }
+                c = '\n';
+            }
+            _text.push_back((char) c);
+        }
+        return false;
+    }
+
+    // Read comment or CDATA text up to the given closing delimiter,
+    // normalizing line endings.
+    void readUntil(const string& terminator)
+    {
+        _text.clear();
+        for (int c = get(); c != EOF; c = get())
+        {
+            if (c == '\r')
+            {
+                if (peek() == '\n')
+                {
+                    get();
+                }
+                c = '\n';
+            }
+            _text.push_back((char) c);
+            if (_text.size() >= terminator.size() &&
+                !_text.compare(_text.size() - terminator.size(), terminator.size(), terminator))
+            {
+                _text.resize(_text.size() - terminator.size());
+                return;
+            }
+        }
+        error("Unexpected end of file");
+    }
+
+    Event endElement()
+    {
+        _name = _openElements.back();
+        _openElements.pop_back();
+        return END_ELEMENT;
+    }
+
+    void error(const string& desc)
+    {
+        string message = "XML parse error";
+        if (!_filename.isEmpty())
+        {
+            message += " in " + _filename.asString();
+        }
+        message += " (" + desc + " at character " + std::to_string(_offset + _bufferPos) + ")";
+        throw ExceptionParseError(message);
+    }
+
+  private:
+    static const size_t BUFFER_SIZE = 64 * 1024;
+
+    std::istream& _stream;
+    FilePath _filename;
+    vector<char> _buffer;
+    size_t _bufferPos;
+    size_t _bufferSize;
+    size_t _offset;
+
+    string _name;
+    vector<Attribute> _attributes;
+    string _text;
+    StringVec _openElements;
+    bool _pendingTag;
+    bool _pendingEnd;
+};
+
+// Import the given XInclude library into a document, inserting its elements
+// at the given child index, and return the number of elements inserted.
+// Document content at or after the index is replaced by included elements of
+// the same name, as the default reader reads XIncludes first.
+size_t insertXIncludeLibrary(DocumentPtr doc, ConstDocumentPtr library, size_t index)
+{
+    for (ConstElementPtr child : library->getChildren())
+    {
+        const string childName = child->getQualifiedName(child->getName());
+        if (doc->getChild(childName) && doc->getChildIndex(childName) >= (int) index)
+        {
+            doc->removeChild(childName);
+        }
+    }
+
+    size_t childCount = doc->getChildren().size();
+    doc->importLibrary(library);
+    const vector<ElementPtr>& children = doc->getChildren();
+    size_t insertedCount = children.size() - childCount;
+    if (childCount > index)
+    {
+        StringVec insertedNames;
+        for (size_t i = childCount; i < children.size(); i++)
+        {
+            insertedNames.push_back(children[i]->getName());
+        }
+        for (size_t i = 0; i < insertedCount; i++)
+        {
+            doc->setChildIndex(insertedNames[i], (int) (index + i));
+        }
+    }
+    return insertedCount;
+}
+
+// Build a document directly from a streaming XML parser.
+void documentFromXmlStream(DocumentPtr doc,
+                           std::istream& stream,
+                           const FilePath& filename,
+                           const FileSearchPath& searchPath,
+                           const XmlReadOptions* readOptions)
+{
+    XmlStreamParser parser(stream, filename);
+    XIncludeReader xincludeReader(doc, searchPath, readOptions);
+    bool readComments = readOptions && readOptions->readComments;
+    bool foundRoot = false;
+
+    // The default reader processes all XIncludes before the other elements of
+    // the document, so included elements are inserted after those of earlier
+    // XIncludes, ahead of any document content that has already been read.
+    size_t includedChildCount = 0;
+
+    // The stack of open elements, with null entries for skipped content.
+    vector<ElementPtr> elements;
+    for (XmlStreamParser::Event event = parser.next(); event != XmlStreamParser::END_DOCUMENT; event = parser.next())
+    {
+        if (event == XmlStreamParser::START_ELEMENT)
+        {
+            ElementPtr elem;
+            if (elements.empty())
+            {
+                // Read the first MaterialX root element.
+                if (!foundRoot && parser.getName() == Document::CATEGORY)
+                {
+                    elem = doc;
+                    foundRoot = true;
+                }
+            }
+            else if (elements.back() == doc && parser.getName() == XINCLUDE_TAG)
+            {
+                DocumentPtr library = xincludeReader.readXIncludeLibrary(parser.getAttribute("href"));
+                if (library)
+                {
+                    includedChildCount += insertXIncludeLibrary(doc, library, includedChildCount);
+                }
+            }
+            else if (elements.back())
+            {
+                // Check for duplicate elements.
+                const string& name = parser.getAttribute(Element::NAME_ATTRIBUTE);
+                if (!elements.back()->getChild(name))
+                {
+                    elem = elements.back()->addChildOfCategory(parser.getName(), name);
+                }
+            }
+
+            // Store attributes in element.
+            if (elem)
+            {
+                for (const XmlStreamParser::Attribute& attr : parser.getAttributes())
+                {
+                    if (attr.first != Element::NAME_ATTRIBUTE)
+                    {
+                        elem->setAttribute(attr.first, attr.second);
+                    }
+                }
+            }
+            elements.push_back(elem);
+        }
+        else if (event == XmlStreamParser::END_ELEMENT)
+        {
+            if (elements.size() == 1 && elements.back() == doc)
+            {
+                xincludeReader.finish();
+            }
+            elements.pop_back();
+        }
+        else if ((event == XmlStreamParser::TEXT || (event == XmlStreamParser::COMMENT && readComments)) &&
+                 !elements.empty() && elements.back())
+        {
+            // Character data and comments are read as unnamed elements, as
+            // in the default reader.
+            ElementPtr parent = elements.back();
+            if (!parent->getChild(EMPTY_STRING))
+            {
+                ElementPtr child = parent->addChildOfCategory(EMPTY_STRING, EMPTY_STRING);
+
+                // Handle the interpretation of XML comments.
+                if (readComments)
+                {
+                    child = parent->changeChildCategory(child, CommentElement::CATEGORY);
+                    child->setDocString(parser.getText());
+                }
+            }
+        }
+    }
+
+    doc->upgradeVersion();
+}
+
+// Writes MaterialX elements directly to an output stream as XML, in the same
+// format as the XML document writer.
+class XmlStreamWriter
+{
+  public:
+    XmlStreamWriter(std::ostream& stream, const XmlWriteOptions* writeOptions) :
+        _stream(stream),
+        _writeOptions(writeOptions)
+    {
+    }
+
+    void writeDocument(ConstDocumentPtr doc)
+    {
+        _buffer += "<?xml version=\"1.0\"?>\n";
+        writeElement(doc, Document::CATEGORY, 0);
+        flush();
+    }
+
+  private:
+    void writeElement(ConstElementPtr elem, const string& tag, size_t depth)
+    {
+        vector<XmlWriteItem> items = getXmlWriteItems(elem, _writeOptions);
+
+        // Write the start tag and attributes.
+        writeIndent(depth);
+        _buffer += '<';
+        _buffer += tag;
+        if (!elem->getName().empty())
+        {
+            writeAttribute(Element::NAME_ATTRIBUTE, elem->getName());
+        }
+        for (const string& attrName : elem->getAttributeNames())
+        {
+            writeAttribute(attrName, elem->getAttribute(attrName));
+        }
+        bool hasXInclude = std::any_of(items.begin(), items.end(),
+                                       [](const XmlWriteItem& item) { return !item.child; });
+        if (hasXInclude && !elem->hasAttribute(XINCLUDE_NAMESPACE))
+        {
+            writeAttribute(XINCLUDE_NAMESPACE, XINCLUDE_URL);
+        }
+        if (items.empty())
+        {
+            _buffer += " />\n";
+            return;
+        }
+        _buffer += ">\n";
+
+        // Write XInclude references, comments, and child elements.
+        for (const XmlWriteItem& item : items)
+        {
+            if (!item.child)
+            {
+                writeIndent(depth + 1);
+                _buffer += '<';
+                _buffer += XINCLUDE_TAG;
+                writeAttribute("href", item.xinclude);
+                _buffer += " />\n";
+            }
+            else if (item.child->getCategory() == CommentElement::CATEGORY)
+            {
+                writeIndent(depth + 1);
+                writeComment(item.child->getAttribute(Element::DOC_ATTRIBUTE));
+            }
+            else
+            {
+                writeElement(item.child, item.child->getCategory(), depth + 1);
+            }
+        }
+
+        // Write the end tag.
+        writeIndent(depth);
+        _buffer += "</";
+        _buffer += tag;
+        _buffer += ">\n";
+        if (_buffer.size() >= FLUSH_SIZE)
+        {
+            flush();
+        }
+    }
+
+    void writeIndent(size_t depth)
+    {
+        _buffer.append(depth * 2, ' ');
+    }
+
+    void writeAttribute(const string& name, const string& value)
+    {
+        _buffer += ' ';
+        _buffer += name;
+        _buffer += "=\"";
+        for (char c : value)
+        {
+            unsigned char uc = (unsigned char) c;
+            if (c == '&')
+            {
+                _buffer += "&amp;";
+            }
+            else if (c == '"')
+            {
+                _buffer += "&quot;";
+            }
+            else if (uc < 32 && c != '\t')
+            {
+                _buffer += "&#";
+                _buffer += (char) ('0' + uc / 10);
+                _buffer += (char) ('0' + uc % 10);
+                _buffer += ';';
+            }
+            else
+            {
+                _buffer += c;
+            }
+        }
+        _buffer += '"';
+    }
+
+    // Write a comment, separating any dashes that would end it early.
+    void writeComment(const string& text)
+    {
+        _buffer += "<!--";
+        for (size_t i = 0; i < text.size(); i++)
+        {
+            _buffer += text[i];
+            if (text[i] == '-' && (i + 1 == text.size() || text[i + 1] == '-'))
+            {
+                _buffer += ' ';
+            }
+        }
+        _buffer += "-->\n";
+    }
+
+    void flush()
+    {
+        _stream.write(_buffer.data(), _buffer.size());
+        _buffer.clear();
+    }
+
+  private:
+    static const size_t FLUSH_SIZE = 64 * 1024;
+
+    std::ostream& _stream;
+    const XmlWriteOptions* _writeOptions;
+    string _buffer;
+};
+
 } // anonymous namespace
 
 //
@@ -266,7 +1289,9 @@ unsigned int getParseOptions(const XmlReadOptions* readOptions)
 
 XmlReadOptions::XmlReadOptions() :
     readXIncludeFunction(readFromXmlFile),
-    readComments(false)
+    readComments(false),
+    shareXIncludes(false),
+    streaming(false)
 {
 }
 
@@ -275,7 +1300,8 @@ XmlReadOptions::XmlReadOptions() :
 //
 
 XmlWriteOptions::XmlWriteOptions() :
-    writeXIncludeEnable(true)
+    writeXIncludeEnable(true),
+    streaming(false)
 {
 }
 
@@ -287,6 +1313,13 @@ void readFromXmlBuffer(DocumentPtr doc, const char* buffer, FileSearchPath searc
 {
     searchPath.append(getEnvironmentPath());
 
+    if (readOptions && readOptions->streaming)
+    {
+        std::istringstream stream(buffer);
+        documentFromXmlStream(doc, stream, FilePath(), searchPath, readOptions);
+        return;
+    }
+
     xml_document xmlDoc;
     xml_parse_result result = xmlDoc.load_string(buffer, getParseOptions(readOptions));
     validateParseResult(result);
@@ -298,6 +1331,12 @@ void readFromXmlStream(DocumentPtr doc, std::istream& stream, FileSearchPath sea
 {
     searchPath.append(getEnvironmentPath());
 
+    if (readOptions && readOptions->streaming)
+    {
+        documentFromXmlStream(doc, stream, FilePath(), searchPath, readOptions);
+        return;
+    }
+
     xml_document xmlDoc;
     xml_parse_result result = xmlDoc.load(stream, getParseOptions(readOptions));
     validateParseResult(result);
@@ -310,20 +1349,23 @@ void readFromXmlFile(DocumentPtr doc, FilePath filename, FileSearchPath searchPa
     searchPath.append(getEnvironmentPath());
     filename = searchPath.find(filename);
 
+    if (readOptions && readOptions->streaming)
+    {
+        std::ifstream stream(filename.asString(), std::ios::in | std::ios::binary);
+        if (!stream)
+        {
+            throw ExceptionFileMissing("Failed to open file for reading: " + filename.asString());
+        }
+        setDocumentSourceUri(doc, filename, readOptions);
+        documentFromXmlStream(doc, stream, filename, searchPath, readOptions);
+        return;
+    }
+
     xml_document xmlDoc;
     xml_parse_result result = xmlDoc.load_file(filename.asString().c_str(), getParseOptions(readOptions));
     validateParseResult(result, filename);
 
-    // This must be done before parsing the XML as the source URI
-    // is used for searching for include files.
-    if (readOptions && !readOptions->parentXIncludes.empty())
-    {
-        doc->setSourceUri(readOptions->parentXIncludes[0]);
-    }
-    else
-    {
-        doc->setSourceUri(filename);
-    }
+    setDocumentSourceUri(doc, filename, readOptions);
     documentFromXml(doc, xmlDoc, searchPath, readOptions);
 }
 
@@ -333,12 +1375,25 @@ void readFromXmlString(DocumentPtr doc, const string& str, FileSearchPath search
     readFromXmlStream(doc, stream, searchPath, readOptions);
 }
 
+void clearXIncludeCache()
+{
+    std::lock_guard<std::mutex> lock(xincludeCacheMutex);
+    xincludeCache.clear();
+}
+
 //
 // Writing
 //
 
 void writeToXmlStream(DocumentPtr doc, std::ostream& stream, const XmlWriteOptions* writeOptions)
 {
+    if (writeOptions && writeOptions->streaming)
+    {
+        XmlStreamWriter writer(stream, writeOptions);
+        writer.writeDocument(doc);
+        return;
+    }
+
     xml_document xmlDoc;
     xml_node xmlRoot = xmlDoc.append_child("materialx");
     elementToXml(doc, xmlRoot, writeOptions);
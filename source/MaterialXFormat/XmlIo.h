@@ -46,6 +46,29 @@ class MX_FORMAT_API XmlReadOptions
     /// The vector of parent XIncludes at the scope of the current document.
     /// Defaults to an empty vector.
     StringVec parentXIncludes;
+
+    /// If true, then the XInclude references of a document are read once
+    /// into a shared library document, which is cached by the resolved
+    /// filenames and modification times of its includes, along with the
+    /// read options that affect its contents, and referenced by the including
+    /// document rather than copied into it.  Documents with identical XInclude
+    /// references share a single library.  Library elements are assigned the
+    /// resolved filenames of their includes as their source URIs, and shared
+    /// libraries remain cached until clearXIncludeCache is called.  Libraries
+    /// read with a readXIncludeFunction other than a plain function pointer
+    /// are not cached.  Defaults to false.
+    bool shareXIncludes;
+
+    /// If true, then documents will be read with a streaming parser, which
+    /// builds MaterialX elements directly as XML tags are encountered rather
+    /// than first constructing an XML document in memory.  This reduces the
+    /// peak memory footprint when reading very large documents.  XIncludes
+    /// are processed ahead of the other elements of the document, and XML
+    /// whitespace and line endings are normalized as in the default reader.
+    /// Streamed documents must be encoded as UTF-8, with an optional byte
+    /// order mark, and UTF-16 or UTF-32 content is reported as a parse error.
+    /// Defaults to false.
+    bool streaming;
 };
 
 /// @class XmlWriteOptions
@@ -57,12 +80,20 @@ class MX_FORMAT_API XmlWriteOptions
     ~XmlWriteOptions() { }
 
     /// If true, elements with source file markings will be written as
-    /// XIncludes rather than explicit data.  Defaults to true.
+    /// XIncludes rather than explicit data, and libraries referenced by the
+    /// document will be written as XIncludes of their source files.
+    /// Defaults to true.
     bool writeXIncludeEnable;
     
     /// If provided, this function will be used to exclude specific elements
     /// (those returning false) from the write operation.  Defaults to nullptr.
     ElementPredicate elementPredicate;
+
+    /// If true, then documents will be written directly to the output stream
+    /// as their elements are traversed, rather than first constructing an XML
+    /// document in memory.  The output is identical to that of the default
+    /// writer.  Defaults to false.
+    bool streaming;
 };
 
 /// @class ExceptionParseError
@@ -141,6 +172,12 @@ MX_FORMAT_API void readFromXmlFile(DocumentPtr doc,
 /// @throws ExceptionParseError if the document cannot be parsed.
 MX_FORMAT_API void readFromXmlString(DocumentPtr doc, const string& str, FileSearchPath searchPath = FileSearchPath(), const XmlReadOptions* readOptions = nullptr);
 
+/// Clear the cache of shared library documents that have been read through
+/// XInclude references with XmlReadOptions::shareXIncludes enabled, so that
+/// subsequent reads will load these libraries again.  Documents that already
+/// reference shared libraries are unaffected.
+MX_FORMAT_API void clearXIncludeCache();
+
 /// @}
 /// @name Write Functions
 /// @{
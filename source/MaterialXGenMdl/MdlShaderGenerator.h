@@ -38,6 +38,10 @@ class MX_GENMDL_API MdlShaderGenerator : public ShaderGenerator
     /// Return the result of an upstream connection or value for an input.
     string getUpstreamResult(const ShaderInput* input, GenContext& context) const override;
 
+    /// Implementations are not shared between contexts, since transmission
+    /// IOR inputs are disconnected within compound graphs during generation.
+    bool canShareImplementations() const override { return false; }
+
     /// Unique identifier for this generator target
     static const string TARGET;
 
@@ -101,9 +101,9 @@ ShaderPtr OgsFxShaderGenerator::generate(const string& name, ElementPtr element,
 
     // Emit code for vertex and pixel shader stages
     emitVertexStage(graph, context, vs);
-    replaceTokens(_tokenSubstitutions, vs);
+    replaceTokens(context.getTokenSubstitutions(), vs);
     emitPixelStage(graph, context, ps);
-    replaceTokens(_tokenSubstitutions, ps);
+    replaceTokens(context.getTokenSubstitutions(), ps);
 
     //
     // Assemble the final effects shader
@@ -241,7 +241,7 @@ ShaderPtr OgsFxShaderGenerator::generate(const string& name, ElementPtr element,
     emitScopeEnd(fx);
     emitLineBreak(fx);
 
-    replaceTokens(_tokenSubstitutions, fx);
+    replaceTokens(context.getTokenSubstitutions(), fx);
 
     return shader;
 }
@@ -305,11 +305,11 @@ void OgsFxShaderGenerator::emitPixelStage(const ShaderGraph& graph, GenContext&
     // depending on the vertical flip flag.
     if (context.getOptions().fileTextureVerticalFlip)
     {
-        _tokenSubstitutions[ShaderGenerator::T_FILE_TRANSFORM_UV] = "stdlib/genglsl/lib/mx_transform_uv_vflip.glsl";
+        context.setTokenSubstitution(ShaderGenerator::T_FILE_TRANSFORM_UV, "stdlib/genglsl/lib/mx_transform_uv_vflip.glsl");
     }
     else
     {
-        _tokenSubstitutions[ShaderGenerator::T_FILE_TRANSFORM_UV] = "stdlib/genglsl/lib/mx_transform_uv.glsl";
+        context.setTokenSubstitution(ShaderGenerator::T_FILE_TRANSFORM_UV, "stdlib/genglsl/lib/mx_transform_uv.glsl");
     }
 
     // Emit environment lighting functions
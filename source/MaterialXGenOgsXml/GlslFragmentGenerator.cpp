@@ -215,8 +215,8 @@ ShaderPtr GlslFragmentGenerator::generate(const string& fragmentName, ElementPtr
 
     // Set the include file to use for uv transformations,
     // depending on the vertical flip flag.
-    _tokenSubstitutions[ShaderGenerator::T_FILE_TRANSFORM_UV] = string("stdlib/genglsl") +
-        (context.getOptions().fileTextureVerticalFlip ? "/lib/mx_transform_uv_vflip.glsl": "/lib/mx_transform_uv.glsl");
+    context.setTokenSubstitution(ShaderGenerator::T_FILE_TRANSFORM_UV, string("stdlib/genglsl") +
+        (context.getOptions().fileTextureVerticalFlip ? "/lib/mx_transform_uv_vflip.glsl": "/lib/mx_transform_uv.glsl"));
 
     // Add all functions for node implementations
     emitFunctionDefinitions(graph, context, pixelStage);
@@ -405,7 +405,7 @@ ShaderPtr GlslFragmentGenerator::generate(const string& fragmentName, ElementPtr
     emitScopeEnd(pixelStage);
 
     // Replace all tokens with real identifier names
-    replaceTokens(_tokenSubstitutions, pixelStage);
+    replaceTokens(context.getTokenSubstitutions(), pixelStage);
 
     // Now emit uniform definitions to a special stage which is only
     // consumed by the HLSL cross-compiler.
@@ -462,7 +462,7 @@ ShaderPtr GlslFragmentGenerator::generate(const string& fragmentName, ElementPtr
     emitUniformBlock(pixelStage.getUniformBlock(HW::PRIVATE_UNIFORMS));
     emitUniformBlock(pixelStage.getUniformBlock(HW::PUBLIC_UNIFORMS));
 
-    replaceTokens(_tokenSubstitutions, uniformsStage);
+    replaceTokens(context.getTokenSubstitutions(), uniformsStage);
 
     return shader;
 }
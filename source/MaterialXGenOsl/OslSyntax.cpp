@@ -229,7 +229,8 @@ class OSLMatrix3TypeSyntax : public AggregateTypeSyntax
         }
 
         // Write the value using a stream to maintain any float formatting set
-        // using Value::setFloatFormat() and Value::setFloatPrecision()
+        // on the calling thread using Value::setFloatFormat() and
+        // Value::setFloatPrecision()
         StringStream ss;
         ss << getName() << "(";
         for (size_t i = 0; i<values.size(); i++)
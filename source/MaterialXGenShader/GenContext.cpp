@@ -27,8 +27,10 @@ GenContext::GenContext(ShaderGeneratorPtr sg) :
     // Add reserved words from the syntax
     reservedWords = _sg->getSyntax().getReservedWords();
 
-    // Add token substitution identifiers
-    for (const auto& it : _sg->getTokenSubstitutions())
+    // Add token substitution identifiers, and copy the substitutions
+    // so that generators can override them per context.
+    _tokenSubstitutions = _sg->getTokenSubstitutions();
+    for (const auto& it : _tokenSubstitutions)
     {
         if (!it.second.empty())
         {
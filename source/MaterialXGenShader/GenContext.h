@@ -65,6 +65,12 @@ class MX_GENSHADER_API GenContext
         return _sourceCodeSearchPath.find(filename);
     }
 
+    /// Return the search path used for finding source code.
+    const FileSearchPath& getSourceCodeSearchPath() const
+    {
+        return _sourceCodeSearchPath;
+    }
+
     /// Add reserved words that should not be used as
     /// identifiers during code generation.
     void addReservedWords(const StringSet& names)
@@ -79,6 +85,20 @@ class MX_GENSHADER_API GenContext
         return _reservedWords;
     }
 
+    /// Set the substitution for a token in the generated code, overriding
+    /// any substitution registered by the shader generator.
+    void setTokenSubstitution(const string& token, const string& substitution)
+    {
+        _tokenSubstitutions[token] = substitution;
+    }
+
+    /// Return the map of token substitutions used in generation, including
+    /// the substitutions registered by the shader generator.
+    const StringMap& getTokenSubstitutions() const
+    {
+        return _tokenSubstitutions;
+    }
+
     /// Cache a shader node implementation.
     void addNodeImplementation(const string& name, ShaderNodeImplPtr impl);
 
@@ -92,6 +112,19 @@ class MX_GENSHADER_API GenContext
     /// Clear all cached shader node implementation.
     void clearNodeImplementations();
 
+    /// Set a cache of initialized node implementations to share with other
+    /// contexts, or nullptr to use only the implementations of this context.
+    void setNodeImplementationCache(ShaderNodeImplCachePtr cache)
+    {
+        _nodeImplCache = cache;
+    }
+
+    /// Return the shared cache of node implementations, if any.
+    ShaderNodeImplCachePtr getNodeImplementationCache() const
+    {
+        return _nodeImplCache;
+    }
+
     /// Add user data to the context to make it
     /// available during shader generator.
     void pushUserData(const string& name, GenUserDataPtr data)
@@ -172,9 +205,15 @@ class MX_GENSHADER_API GenContext
     // Set of globally reserved words.
     StringSet _reservedWords;
 
+    // Token substitutions used in generation.
+    StringMap _tokenSubstitutions;
+
     // Cached shader node implementations.
     std::unordered_map<string, ShaderNodeImplPtr> _nodeImpls;
 
+    // Cache of shader node implementations shared with other contexts.
+    ShaderNodeImplCachePtr _nodeImplCache;
+
     // User data
     std::unordered_map<string, vector<GenUserDataPtr>> _userData;
 
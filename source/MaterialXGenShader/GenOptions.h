@@ -68,6 +68,9 @@ class MX_GENSHADER_API GenOptions
         shaderInterfaceType(SHADER_INTERFACE_COMPLETE),
         fileTextureVerticalFlip(false),
         addUpstreamDependencies(true),
+        foldConstants(false),
+        eliminateCommonSubexpressions(false),
+        scopeConditionalBranches(false),
         hwTransparency(false),
         hwSpecularEnvironmentMethod(SPECULAR_ENVIRONMENT_FIS),
         hwDirectionalAlbedoMethod(DIRECTIONAL_ALBEDO_ANALYTIC),
@@ -108,6 +111,29 @@ class MX_GENSHADER_API GenOptions
     /// for the element to generate a shader for.
     bool addUpstreamDependencies;
 
+    /// Sets whether standard library nodes whose inputs are all unconnected
+    /// values, such as arithmetic, mix, convert and swizzle nodes, are
+    /// evaluated at generation time and replaced by their resulting values.
+    /// The inputs of folded nodes are no longer published as uniforms, so
+    /// this option is best suited to reduced shader interfaces.
+    /// Defaults to false.
+    bool foldConstants;
+
+    /// Sets whether nodes with identical implementations, input values and
+    /// upstream connections are merged, so that duplicate texture samples
+    /// and function calls are emitted only once. Merged nodes share the
+    /// uniforms of the node they are merged into.
+    /// Defaults to false.
+    bool eliminateCommonSubexpressions;
+
+    /// Sets whether nodes used only by some branches of conditional nodes
+    /// are evaluated inside those branches rather than ahead of the
+    /// conditional. Texture lookups moved into non-uniform branches may
+    /// compute undefined derivatives in hardware shading languages, so
+    /// this option is best suited to conditionals on uniform selectors.
+    /// Defaults to false.
+    bool scopeConditionalBranches;
+
     /// Sets if transparency is needed or not for HW shaders.
     /// If a surface shader has potential of being transparent
     /// this must be set to true, otherwise no transparency
@@ -402,8 +402,10 @@ ShaderPtr HwShaderGenerator::createShader(const string& name, ElementPtr element
                 }
             }
             // Push subgraphs on the stack to process these as well.
+            // Compound nodes convert their filename inputs when initialized,
+            // and create the uniforms in createVariables().
             ShaderGraph* subgraph = node->getImplementation().getGraph();
-            if (subgraph)
+            if (subgraph && !dynamic_cast<const HwCompoundNode*>(&node->getImplementation()))
             {
                 graphStack.push_back(subgraph);
             }
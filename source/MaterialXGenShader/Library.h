@@ -23,6 +23,9 @@ class ShaderGraph;
 class ShaderInput;
 class ShaderOutput;
 class ShaderNodeImpl;
+class ShaderNodeImplCache;
+class SourceFile;
+class FunctionDefinitionCache;
 class GenOptions;
 class GenContext;
 class TypeDesc;
@@ -38,6 +41,12 @@ using ShaderStagePtr = shared_ptr<ShaderStage>;
 using ShaderGeneratorPtr = shared_ptr<ShaderGenerator>;
 /// Shared pointer to a ShaderNodeImpl
 using ShaderNodeImplPtr = shared_ptr<ShaderNodeImpl>;
+/// Shared pointer to a ShaderNodeImplCache
+using ShaderNodeImplCachePtr = shared_ptr<ShaderNodeImplCache>;
+/// Shared pointer to a const SourceFile
+using ConstSourceFilePtr = shared_ptr<const SourceFile>;
+/// Shared pointer to a FunctionDefinitionCache
+using FunctionDefinitionCachePtr = shared_ptr<FunctionDefinitionCache>;
 /// Shared pointer to a GenContext
 using GenContextPtr = shared_ptr<GenContext>;
 
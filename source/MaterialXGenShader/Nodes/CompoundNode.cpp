@@ -6,6 +6,7 @@
 #include <MaterialXGenShader/Nodes/CompoundNode.h>
 #include <MaterialXGenShader/ShaderGenerator.h>
 #include <MaterialXGenShader/HwShaderGenerator.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/Util.h>
 
 #include <MaterialXCore/Library.h>
@@ -38,12 +39,23 @@ void CompoundNode::initialize(const InterfaceElement& element, GenContext& conte
     // so always use the reduced interface for this graph.
     const int oldShaderInterfaceType = context.getOptions().shaderInterfaceType;
     context.getOptions().shaderInterfaceType = SHADER_INTERFACE_REDUCED;
-    _rootGraph = ShaderGraph::create(nullptr, graph, context);
+    try
+    {
+        _rootGraph = ShaderGraph::create(nullptr, graph, context);
+    }
+    catch (...)
+    {
+        context.getOptions().shaderInterfaceType = oldShaderInterfaceType;
+        throw;
+    }
     context.getOptions().shaderInterfaceType = oldShaderInterfaceType;
 
     // Set hash using the function name.
     // TODO: Could be improved to include the full function signature.
     _hash = std::hash<string>{}(_functionName);
+
+    // The emitted definition depends only on the graph and the generation options.
+    _functionDefinitionCache = FunctionDefinitionCache::create();
 }
 
 void CompoundNode::createVariables(const ShaderNode&, GenContext& context, Shader& shader) const
@@ -58,6 +70,8 @@ void CompoundNode::createVariables(const ShaderNode&, GenContext& context, Shade
 void CompoundNode::emitFunctionDefinition(const ShaderNode&, GenContext& context, ShaderStage& stage) const
 {
     BEGIN_SHADER_STAGE(stage, Stage::PIXEL)
+        std::lock_guard<std::mutex> lock(_emitMutex);
+
         const ShaderGenerator& shadergen = context.getShaderGenerator();
         const Syntax& syntax = shadergen.getSyntax();
 
@@ -10,6 +10,8 @@
 #include <MaterialXGenShader/ShaderGraph.h>
 #include <MaterialXGenShader/Shader.h>
 
+#include <mutex>
+
 namespace MaterialX
 {
 
@@ -32,6 +34,11 @@ class MX_GENSHADER_API CompoundNode : public ShaderNodeImpl
   protected:
     ShaderGraphPtr _rootGraph;
     string _functionName;
+
+    // Guards the graph while the function body is emitted, since node
+    // implementations may edit the graph temporarily during emission,
+    // and the implementation may be shared by contexts on other threads.
+    mutable std::mutex _emitMutex;
 };
 
 } // namespace MaterialX
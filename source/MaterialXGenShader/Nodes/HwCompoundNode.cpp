@@ -15,9 +15,51 @@ ShaderNodeImplPtr HwCompoundNode::create()
     return std::make_shared<HwCompoundNode>();
 }
 
+void HwCompoundNode::initialize(const InterfaceElement& element, GenContext& context)
+{
+    CompoundNode::initialize(element, context);
+
+    // Unconnected filename inputs on file texture nodes are converted into
+    // texture sampler uniforms.  Assign the uniform names to the inputs so
+    // they are referenced during code generation, keeping the original values
+    // for the uniforms created for each shader.
+    _fileTextureUniforms.clear();
+    for (ShaderNode* node : _rootGraph->getNodes())
+    {
+        if (node->hasClassification(ShaderNode::Classification::FILETEXTURE))
+        {
+            for (ShaderInput* input : node->getInputs())
+            {
+                if (!input->getConnection() && input->getType() == Type::FILENAME)
+                {
+                    ShaderPortPtr uniform = std::make_shared<ShaderPort>(nullptr, Type::FILENAME, input->getVariable(), input->getValue());
+                    uniform->setPath(input->getPath());
+                    _fileTextureUniforms.push_back(uniform);
+                    input->setValue(Value::createValue(input->getVariable()));
+                }
+            }
+        }
+    }
+}
+
+void HwCompoundNode::createVariables(const ShaderNode& node, GenContext& context, Shader& shader) const
+{
+    CompoundNode::createVariables(node, context, shader);
+
+    ShaderStage& ps = shader.getStage(Stage::PIXEL);
+    VariableBlock& psPublicUniforms = ps.getUniformBlock(HW::PUBLIC_UNIFORMS);
+    for (ShaderPortPtr uniform : _fileTextureUniforms)
+    {
+        ShaderPort* filename = psPublicUniforms.add(uniform->getType(), uniform->getName(), uniform->getValue());
+        filename->setPath(uniform->getPath());
+    }
+}
+
 void HwCompoundNode::emitFunctionDefinition(const ShaderNode& node, GenContext& context, ShaderStage& stage) const
 {
     BEGIN_SHADER_STAGE(stage, Stage::PIXEL)
+        std::lock_guard<std::mutex> lock(_emitMutex);
+
         const HwShaderGenerator& shadergen = static_cast<const HwShaderGenerator&>(context.getShaderGenerator());
 
         // Emit functions for all child nodes
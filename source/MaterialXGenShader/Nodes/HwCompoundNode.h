@@ -18,12 +18,18 @@ class MX_GENSHADER_API HwCompoundNode : public CompoundNode
 public:
     static ShaderNodeImplPtr create();
 
+    void initialize(const InterfaceElement& element, GenContext& context) override;
+
+    void createVariables(const ShaderNode& node, GenContext& context, Shader& shader) const override;
+
     void emitFunctionDefinition(const ShaderNode& node, GenContext& context, ShaderStage& stage) const override;
 
     void emitFunctionCall(const ShaderNode& node, GenContext& context, ShaderStage& stage) const override;
 
 protected:
     void emitFunctionDefinition(HwClosureContextPtr ccx, GenContext& context, ShaderStage& stage) const;
+
+    vector<ShaderPortPtr> _fileTextureUniforms;
 };
 
 } // namespace MaterialX
@@ -9,6 +9,8 @@
 #include <MaterialXGenShader/ShaderStage.h>
 #include <MaterialXGenShader/ShaderGenerator.h>
 
+#include <algorithm>
+
 namespace MaterialX
 {
 
@@ -54,11 +56,13 @@ void IfNode::emitFunctionCall(const ShaderNode& node, GenContext& context, Shade
 
             shadergen.emitScopeBegin(stage);
 
-            // Emit function calls for nodes that are ONLY needed in this scope
+            // Emit function calls for nodes that are ONLY needed in this scope,
+            // where scope branches are identified by their input index.
+            const int inputIndex = int(std::find(node.getInputs().begin(), node.getInputs().end(), input) - node.getInputs().begin());
             for (const ShaderNode* otherNode : graph.getNodes())
             {
                 const ShaderNode::ScopeInfo& scope = otherNode->getScopeInfo();
-                if (scope.conditionalNode == &node && scope.usedByBranch(branch))
+                if (scope.conditionalNode == &node && scope.usedByBranch(inputIndex))
                 {
                     // Force ignore scope otherwise the function call will be omitted.
                     shadergen.emitFunctionCall(*otherNode, context, stage, false);
@@ -76,6 +80,11 @@ void IfNode::emitFunctionCall(const ShaderNode& node, GenContext& context, Shade
     END_SHADER_STAGE(stage, Stage::PIXEL)
 }
 
+bool IfNode::isConditionalBranch(const ShaderInput& input) const
+{
+    return input.getName() == INPUT_NAMES[2] || input.getName() == INPUT_NAMES[3];
+}
+
 ShaderNodeImplPtr IfGreaterNode::create()
 {
     return std::make_shared<IfGreaterNode>();
@@ -18,6 +18,8 @@ class MX_GENSHADER_API IfNode : public ShaderNodeImpl
   public:
     void emitFunctionCall(const ShaderNode& node, GenContext& context, ShaderStage& stage) const override;
 
+    bool isConditionalBranch(const ShaderInput& input) const override;
+
   private:
     /// Provides the shader code equality operator string to use
     virtual const string& equalityString() const = 0;
@@ -5,6 +5,7 @@
 
 #include <MaterialXGenShader/Nodes/SourceCodeNode.h>
 #include <MaterialXGenShader/GenContext.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/ShaderNode.h>
 #include <MaterialXGenShader/ShaderStage.h>
 #include <MaterialXGenShader/ShaderGenerator.h>
@@ -35,12 +36,13 @@ void SourceCodeNode::initialize(const InterfaceElement& element, GenContext& con
     {
         FilePath file(impl.getAttribute("file"));
         file = context.resolveSourceFile(file);
-        _functionSource = readFile(file);
-        if (_functionSource.empty())
+        ConstSourceFilePtr sourceFile = SourceFileCache::getInstance().read(file);
+        if (!sourceFile)
         {
             throw ExceptionShaderGenError("Failed to get source code from file '" + file.asString() +
                 "' used by implementation '" + impl.getName() + "'");
         }
+        _functionSource = sourceFile->content;
     }
 
     // Find the function name to use
@@ -66,6 +68,9 @@ void SourceCodeNode::initialize(const InterfaceElement& element, GenContext& con
     // Set hash using the function name.
     // TODO: Could be improved to include the full function signature.
     _hash = std::hash<string>{}(_functionName);
+
+    // The emitted definition depends only on the source code.
+    _functionDefinitionCache = FunctionDefinitionCache::create();
 }
 
 void SourceCodeNode::emitFunctionDefinition(const ShaderNode&, GenContext& context, ShaderStage& stage) const
@@ -9,6 +9,8 @@
 #include <MaterialXGenShader/ShaderStage.h>
 #include <MaterialXGenShader/ShaderGenerator.h>
 
+#include <algorithm>
+
 namespace MaterialX
 {
 
@@ -19,6 +21,11 @@ ShaderNodeImplPtr SwitchNode::create()
     return std::make_shared<SwitchNode>();
 }
 
+bool SwitchNode::isConditionalBranch(const ShaderInput& input) const
+{
+    return input.getName() != INPUT_NAMES[5];
+}
+
 void SwitchNode::emitFunctionCall(const ShaderNode& node, GenContext& context, ShaderStage& stage) const
 {
     BEGIN_SHADER_STAGE(stage, Stage::PIXEL)
@@ -59,11 +66,13 @@ void SwitchNode::emitFunctionCall(const ShaderNode& node, GenContext& context, S
 
             shadergen.emitScopeBegin(stage);
 
-            // Emit nodes that are ONLY needed in this scope
+            // Emit nodes that are ONLY needed in this scope,
+            // where scope branches are identified by their input index.
+            const int inputIndex = int(std::find(node.getInputs().begin(), node.getInputs().end(), input) - node.getInputs().begin());
             for (const ShaderNode* otherNode : graph.getNodes())
             {
                 const ShaderNode::ScopeInfo& scope = otherNode->getScopeInfo();
-                if (scope.conditionalNode == &node && scope.usedByBranch(branch))
+                if (scope.conditionalNode == &node && scope.usedByBranch(inputIndex))
                 {
                     shadergen.emitFunctionCall(*otherNode, context, stage, false);
                 }
@@ -19,6 +19,8 @@ public:
 
     void emitFunctionCall(const ShaderNode& node, GenContext& context, ShaderStage& stage) const override;
 
+    bool isConditionalBranch(const ShaderInput& input) const override;
+
 public:
     static const StringVec INPUT_NAMES;
 };
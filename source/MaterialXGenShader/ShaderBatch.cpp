@@ -0,0 +1,115 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <MaterialXGenShader/ShaderBatch.h>
+
+#include <MaterialXGenShader/ShaderCache.h>
+#include <MaterialXGenShader/ShaderGenerator.h>
+#include <MaterialXGenShader/Util.h>
+
+#include <MaterialXCore/Material.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <thread>
+
+namespace MaterialX
+{
+
+namespace {
+
+// Generate the shader for a single element, storing any error in the result.
+void generateShader(ShaderBatchResult& result, GenContext& context)
+{
+    try
+    {
+        ElementPtr root = result.element;
+        NodePtr materialNode = root->asA<Node>();
+        if (materialNode && materialNode->getType() == MATERIAL_TYPE_STRING)
+        {
+            vector<NodePtr> shaderNodes = getShaderNodes(materialNode, SURFACE_SHADER_TYPE_STRING);
+            if (shaderNodes.empty())
+            {
+                throw ExceptionShaderGenError("Material node '" + materialNode->getName() + "' has no surface shader");
+            }
+            root = shaderNodes[0];
+        }
+        result.shader = context.getShaderGenerator().generate(result.element->getName(), root, context);
+    }
+    catch (std::exception& e)
+    {
+        result.error = e.what();
+    }
+    catch (...)
+    {
+        result.error = "Unknown error generating shader for element '" + result.element->getName() + "'";
+    }
+}
+
+} // anonymous namespace
+
+ShaderBatchResultVec generateShaders(const vector<TypedElementPtr>& elements, const GenContext& context, unsigned int threadCount)
+{
+    ShaderBatchResultVec results(elements.size());
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        results[i].element = elements[i];
+    }
+
+    if (threadCount == 0)
+    {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = (unsigned int) std::max(std::min((size_t) threadCount, elements.size()), (size_t) 1);
+
+    // Share initialized implementations between the thread contexts.
+    ShaderNodeImplCachePtr implCache = context.getNodeImplementationCache();
+    if (!implCache)
+    {
+        implCache = ShaderNodeImplCache::create();
+    }
+
+    // Float formatting is set per thread, so each thread applies the
+    // formatting of the calling thread.
+    Value::FloatFormat floatFormat = Value::getFloatFormat();
+    int floatPrecision = Value::getFloatPrecision();
+
+    // Each thread takes the next pending element as it becomes idle, so that
+    // threads finishing simple shaders pick up the remaining work.  A failed
+    // generation may leave state behind in its context, so the context of
+    // the thread is replaced before generating further elements.
+    std::atomic<size_t> nextIndex(0);
+    runWorkerThreads(threadCount, [&]()
+    {
+        ScopedFloatFormatting formatting(floatFormat, floatPrecision);
+        std::unique_ptr<GenContext> threadContext;
+        for (size_t i = nextIndex++; i < results.size(); i = nextIndex++)
+        {
+            if (!threadContext)
+            {
+                threadContext.reset(new GenContext(context));
+                threadContext->clearNodeImplementations();
+                threadContext->setNodeImplementationCache(implCache);
+            }
+            generateShader(results[i], *threadContext);
+            if (!results[i].error.empty())
+            {
+                threadContext.reset();
+            }
+        }
+    });
+    return results;
+}
+
+ShaderBatchResultVec generateShaders(ConstDocumentPtr doc, const GenContext& context, unsigned int threadCount)
+{
+    vector<TypedElementPtr> elements;
+    findRenderableElements(doc, elements);
+    return generateShaders(elements, context, threadCount);
+}
+
+} // namespace MaterialX
@@ -0,0 +1,76 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#ifndef MATERIALX_SHADERBATCH_H
+#define MATERIALX_SHADERBATCH_H
+
+/// @file
+/// Generation of shaders for batches of elements
+
+#include <MaterialXGenShader/Export.h>
+
+#include <MaterialXGenShader/GenContext.h>
+#include <MaterialXGenShader/Shader.h>
+
+namespace MaterialX
+{
+
+/// @class ShaderBatchResult
+/// The result of generating a shader for one element of a batch.
+class MX_GENSHADER_API ShaderBatchResult
+{
+  public:
+    /// The element for which a shader was requested.
+    TypedElementPtr element;
+
+    /// The generated shader, or nullptr if generation failed.
+    ShaderPtr shader;
+
+    /// The message of the error that caused generation to fail, or an
+    /// empty string if generation succeeded.
+    string error;
+};
+
+/// A vector of shader batch results
+using ShaderBatchResultVec = vector<ShaderBatchResult>;
+
+/// Generate shaders for the given elements, returning one result per element
+/// in the order of the given vector.
+///
+/// Elements may be any renderable elements, such as outputs and shader nodes.
+/// A material node is generated from its surface shader node, and the shader
+/// is named after the element in both cases.  Errors raised while generating
+/// an element are stored in its result, rather than thrown.
+///
+/// Each thread takes the next pending element as it becomes idle, and
+/// generates it in a copy of the given context, which is left unchanged.  The
+/// copies share the shader generator along with the user data of the given
+/// context, which must support concurrent use when generating on multiple
+/// threads.  A resource binding context, in particular, should only be set
+/// for serial generation.  Initialized node implementations are shared
+/// between the copies through the implementation cache of the given context,
+/// or through a cache created for the batch if the context has none.
+///
+/// @param elements The elements to generate shaders for.
+/// @param context The context for generation.
+/// @param threadCount The number of threads on which shaders are generated.
+///    A value of zero selects the hardware concurrency of the system.
+MX_GENSHADER_API ShaderBatchResultVec generateShaders(const vector<TypedElementPtr>& elements,
+                                                      const GenContext& context,
+                                                      unsigned int threadCount = 0);
+
+/// Generate shaders for all renderable elements of the given document, as
+/// returned by findRenderableElements, returning one result per element.
+/// @param doc The document to generate shaders for.
+/// @param context The context for generation.
+/// @param threadCount The number of threads on which shaders are generated.
+///    A value of zero selects the hardware concurrency of the system.
+MX_GENSHADER_API ShaderBatchResultVec generateShaders(ConstDocumentPtr doc,
+                                                      const GenContext& context,
+                                                      unsigned int threadCount = 0);
+
+} // namespace MaterialX
+
+#endif
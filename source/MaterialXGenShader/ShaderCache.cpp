@@ -0,0 +1,489 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <MaterialXGenShader/ShaderCache.h>
+
+#include <MaterialXGenShader/ColorManagementSystem.h>
+#include <MaterialXGenShader/ShaderGenerator.h>
+#include <MaterialXGenShader/UnitSystem.h>
+
+#include <MaterialXFormat/Util.h>
+
+#include <MaterialXCore/Traversal.h>
+
+#include <cstdint>
+#include <typeinfo>
+#include <unordered_set>
+
+namespace MaterialX
+{
+
+namespace {
+
+// Serializes the content that determines the code generated for an element
+// into a key.  The full content is kept, rather than a digest of it, so that
+// distinct content can never share a cache entry.
+class ContentKey
+{
+  public:
+    ContentKey(const string& target) :
+        _target(target)
+    {
+    }
+
+    void add(const string& str)
+    {
+        add((uint64_t) str.size());
+        _key += str;
+    }
+
+    void add(uint64_t value)
+    {
+        for (size_t i = 0; i < sizeof(value); i++)
+        {
+            _key += (char) (value >> (i * 8));
+        }
+    }
+
+    // Add the given element and its descendants, if not already added.
+    void addSubtree(ConstElementPtr elem)
+    {
+        if (_visited.insert(elem).second)
+        {
+            addElement(elem);
+        }
+    }
+
+    // Add the top-level element containing the given element, so that graph
+    // interfaces and values on enclosing elements are included.
+    void addTopLevel(ConstElementPtr elem)
+    {
+        while (elem->getParent() && elem->getParent() != elem->getRoot())
+        {
+            elem = elem->getParent();
+        }
+        addSubtree(elem);
+    }
+
+    // Add the nodedef and implementation of the given node, recursing into
+    // the nodes of nodegraph implementations.
+    void addDefinition(ConstNodePtr node)
+    {
+        NodeDefPtr nodeDef = node->getNodeDef(_target);
+        if (!nodeDef || _visited.count(nodeDef))
+        {
+            return;
+        }
+        addSubtree(nodeDef);
+
+        InterfaceElementPtr impl = nodeDef->getImplementation(_target);
+        if (!impl)
+        {
+            return;
+        }
+        addSubtree(impl);
+        NodeGraphPtr implGraph = impl->asA<NodeGraph>();
+        if (implGraph)
+        {
+            for (NodePtr implNode : implGraph->getNodes())
+            {
+                addDefinition(implNode);
+            }
+        }
+    }
+
+    // Add the upstream graph of the given element.
+    void addUpstreamGraph(ConstElementPtr elem)
+    {
+        for (Edge edge : elem->traverseGraph())
+        {
+            ElementPtr upstream = edge.getUpstreamElement();
+            addTopLevel(upstream);
+            NodePtr node = upstream->asA<Node>();
+            if (node)
+            {
+                addDefinition(node);
+            }
+        }
+    }
+
+    const string& getKey() const
+    {
+        return _key;
+    }
+
+  private:
+    void addElement(ConstElementPtr elem)
+    {
+        add(elem->getCategory());
+        add(elem->getName());
+        const StringVec& attrNames = elem->getAttributeNames();
+        add((uint64_t) attrNames.size());
+        for (const string& attrName : attrNames)
+        {
+            add(attrName);
+            add(elem->getAttribute(attrName));
+        }
+        const vector<ElementPtr>& children = elem->getChildren();
+        add((uint64_t) children.size());
+        for (ConstElementPtr child : children)
+        {
+            addElement(child);
+        }
+    }
+
+  private:
+    string _target;
+    string _key;
+    std::unordered_set<ConstElementPtr> _visited;
+};
+
+void addGenOptions(ContentKey& content, const GenOptions& options)
+{
+    content.add((uint64_t) options.shaderInterfaceType);
+    content.add((uint64_t) options.fileTextureVerticalFlip);
+    content.add(options.targetColorSpaceOverride);
+    content.add(options.targetDistanceUnit);
+    content.add((uint64_t) options.addUpstreamDependencies);
+    content.add((uint64_t) options.foldConstants);
+    content.add((uint64_t) options.eliminateCommonSubexpressions);
+    content.add((uint64_t) options.scopeConditionalBranches);
+    content.add((uint64_t) options.hwTransparency);
+    content.add((uint64_t) options.hwSpecularEnvironmentMethod);
+    content.add((uint64_t) options.hwDirectionalAlbedoMethod);
+    content.add((uint64_t) options.hwWriteDepthMoments);
+    content.add((uint64_t) options.hwShadowMap);
+    content.add((uint64_t) options.hwAmbientOcclusion);
+    content.add((uint64_t) options.hwMaxActiveLightSources);
+    content.add((uint64_t) options.hwNormalizeUdimTexCoords);
+    content.add((uint64_t) options.hwWriteAlbedoTable);
+}
+
+void addGenerator(ContentKey& content, const ShaderGenerator& generator)
+{
+    // Add the target and generator state, distinguishing generator classes
+    // that share a target.
+    content.add(generator.getTarget());
+    content.add(typeid(generator).name());
+    ColorManagementSystemPtr cms = generator.getColorManagementSystem();
+    content.add(cms ? cms->getName() : EMPTY_STRING);
+    UnitSystemPtr unitSystem = generator.getUnitSystem();
+    content.add(unitSystem ? unitSystem->getName() : EMPTY_STRING);
+}
+
+} // anonymous namespace
+
+//
+// ShaderCache methods
+//
+
+ShaderPtr ShaderCache::generate(const string& name, ElementPtr element, GenContext& context)
+{
+    const string key = computeKey(name, element, context);
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _shaders.find(key);
+        if (it != _shaders.end())
+        {
+            _hitCount++;
+            return it->second;
+        }
+    }
+
+    ShaderPtr shader = context.getShaderGenerator().generate(name, element, context);
+    add(key, shader);
+    return shader;
+}
+
+string ShaderCache::computeKey(const string& name, ElementPtr element, GenContext& context)
+{
+    const ShaderGenerator& generator = context.getShaderGenerator();
+    ContentKey content(generator.getTarget());
+
+    addGenerator(content, generator);
+    addGenOptions(content, context.getOptions());
+
+    // Add the shader name and document-level settings.
+    content.add(name);
+    ConstDocumentPtr doc = element->getDocument();
+    content.add(doc->getColorSpace());
+    content.add(doc->getVersionString());
+
+    // Add the element, its upstream graph, and the definitions it reaches.
+    content.addTopLevel(element);
+    content.addUpstreamGraph(element);
+    NodeGraphPtr graph = element->asA<NodeGraph>();
+    if (graph)
+    {
+        for (OutputPtr output : graph->getOutputs())
+        {
+            content.addUpstreamGraph(output);
+        }
+    }
+    NodePtr node = element->asA<Node>();
+    if (node)
+    {
+        content.addDefinition(node);
+    }
+
+    return content.getKey();
+}
+
+ShaderPtr ShaderCache::find(const string& key) const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _shaders.find(key);
+    return it != _shaders.end() ? it->second : nullptr;
+}
+
+void ShaderCache::add(const string& key, ShaderPtr shader)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _shaders[key] = shader;
+}
+
+size_t ShaderCache::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _shaders.size();
+}
+
+size_t ShaderCache::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hitCount;
+}
+
+void ShaderCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _shaders.clear();
+    _hitCount = 0;
+}
+
+//
+// ShaderNodeImplCache methods
+//
+
+bool ShaderNodeImplCache::isShareable(const InterfaceElement& element)
+{
+    NodeDefPtr nodeDef;
+    if (element.isA<Implementation>())
+    {
+        nodeDef = static_cast<const Implementation&>(element).getNodeDef();
+    }
+    else if (element.isA<NodeGraph>())
+    {
+        nodeDef = static_cast<const NodeGraph&>(element).getNodeDef();
+    }
+    return !nodeDef || TypeDesc::get(nodeDef->getType()) != Type::LIGHTSHADER;
+}
+
+string ShaderNodeImplCache::computeKey(const InterfaceElement& element, GenContext& context)
+{
+    const ShaderGenerator& generator = context.getShaderGenerator();
+    ContentKey content(generator.getTarget());
+    addGenerator(content, generator);
+    addGenOptions(content, context.getOptions());
+
+    // Add the context state used when initializing implementations.
+    content.add(context.getSourceCodeSearchPath().asString());
+    const StringSet& reservedWords = context.getReservedWords();
+    content.add((uint64_t) reservedWords.size());
+    for (const string& word : reservedWords)
+    {
+        content.add(word);
+    }
+
+    // Add document-level settings.
+    ConstDocumentPtr doc = element.getDocument();
+    content.add(doc->getColorSpace());
+    content.add(doc->getVersionString());
+
+    // Add the element, its nodedef, and the definitions of nodes in
+    // nodegraph implementations.
+    content.addTopLevel(element.getSelf());
+    NodeDefPtr nodeDef;
+    if (element.isA<Implementation>())
+    {
+        nodeDef = static_cast<const Implementation&>(element).getNodeDef();
+    }
+    else if (element.isA<NodeGraph>())
+    {
+        const NodeGraph& graph = static_cast<const NodeGraph&>(element);
+        nodeDef = graph.getNodeDef();
+        for (NodePtr node : graph.getNodes())
+        {
+            content.addDefinition(node);
+        }
+    }
+    if (nodeDef)
+    {
+        content.addSubtree(nodeDef);
+    }
+
+    return content.getKey();
+}
+
+ShaderNodeImplPtr ShaderNodeImplCache::find(const string& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _impls.find(key);
+    if (it == _impls.end())
+    {
+        return nullptr;
+    }
+    _hitCount++;
+    return it->second;
+}
+
+ShaderNodeImplPtr ShaderNodeImplCache::add(const string& key, ShaderNodeImplPtr impl)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _impls.emplace(key, impl).first->second;
+}
+
+size_t ShaderNodeImplCache::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _impls.size();
+}
+
+size_t ShaderNodeImplCache::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hitCount;
+}
+
+void ShaderNodeImplCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _impls.clear();
+    _hitCount = 0;
+}
+
+//
+// SourceFileCache methods
+//
+
+SourceFileCache& SourceFileCache::getInstance()
+{
+    static SourceFileCache cache;
+    return cache;
+}
+
+ConstSourceFilePtr SourceFileCache::read(const FilePath& file)
+{
+    const string path = file.asString();
+    const uint64_t modificationTime = file.getModificationTime();
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        auto it = _files.find(path);
+        if (it != _files.end() && it->second->modificationTime == modificationTime)
+        {
+            _hitCount++;
+            return it->second;
+        }
+    }
+
+    // Read and split the file outside of the lock, so that reads of
+    // other files are not blocked.
+    std::shared_ptr<SourceFile> source = std::make_shared<SourceFile>();
+    source->content = readFile(file);
+    if (source->content.empty())
+    {
+        return nullptr;
+    }
+    StringStream stream(source->content);
+    for (string line; std::getline(stream, line); )
+    {
+        source->lines.push_back(line);
+    }
+    source->modificationTime = modificationTime;
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _missCount++;
+    _files[path] = source;
+    return source;
+}
+
+size_t SourceFileCache::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _files.size();
+}
+
+size_t SourceFileCache::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hitCount;
+}
+
+size_t SourceFileCache::getMissCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _missCount;
+}
+
+void SourceFileCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _files.clear();
+    _hitCount = 0;
+    _missCount = 0;
+}
+
+//
+// FunctionDefinitionCache methods
+//
+
+string FunctionDefinitionCache::computeKey(const ShaderStage& stage, GenContext& context)
+{
+    const ShaderGenerator& generator = context.getShaderGenerator();
+    ContentKey content(generator.getTarget());
+    addGenerator(content, generator);
+    addGenOptions(content, context.getOptions());
+    content.add(stage.getName());
+    return content.getKey();
+}
+
+ConstShaderFragmentPtr FunctionDefinitionCache::find(const string& key)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    auto it = _definitions.find(key);
+    if (it == _definitions.end())
+    {
+        return nullptr;
+    }
+    _hitCount++;
+    return it->second;
+}
+
+void FunctionDefinitionCache::add(const string& key, ConstShaderFragmentPtr fragment)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _definitions[key] = fragment;
+}
+
+size_t FunctionDefinitionCache::size() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _definitions.size();
+}
+
+size_t FunctionDefinitionCache::getHitCount() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _hitCount;
+}
+
+void FunctionDefinitionCache::clear()
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    _definitions.clear();
+    _hitCount = 0;
+}
+
+} // namespace MaterialX
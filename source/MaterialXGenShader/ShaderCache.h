@@ -0,0 +1,275 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#ifndef MATERIALX_SHADERCACHE_H
+#define MATERIALX_SHADERCACHE_H
+
+/// @file
+/// Caches of generated shaders and node implementations keyed by content
+
+#include <MaterialXGenShader/Export.h>
+
+#include <MaterialXGenShader/GenContext.h>
+#include <MaterialXGenShader/Shader.h>
+
+#include <mutex>
+
+namespace MaterialX
+{
+
+/// A shared pointer to a ShaderCache
+using ShaderCachePtr = shared_ptr<class ShaderCache>;
+
+/// @class ShaderCache
+/// A content-addressed cache of generated shaders.
+///
+/// Shaders are keyed by a serialization of the content that determines their
+/// generated code: the shader name, the upstream graph of the element, the
+/// nodedefs and implementations that the graph reaches, the generation
+/// options, and the target of the shader generator.  Generating a shader for
+/// content that matches a previously generated shader returns the cached
+/// shader, including its stages and their variable blocks, without running
+/// code generation.
+///
+/// Source files referenced by implementations, and generator state that is
+/// not part of the key, such as user data and bound light shaders, are
+/// assumed to remain constant for the lifetime of the cache.  If this state
+/// changes, then the cache should be cleared.
+///
+/// Cached shaders are shared between all callers that generate matching
+/// content, and should be treated as read-only.  All methods are thread-safe.
+class MX_GENSHADER_API ShaderCache
+{
+  public:
+    ShaderCache() :
+        _hitCount(0)
+    {
+    }
+    ~ShaderCache() { }
+
+    /// Create a new shader cache.
+    static ShaderCachePtr create()
+    {
+        return std::make_shared<ShaderCache>();
+    }
+
+    /// Generate a shader for the given element, returning a cached shader
+    /// if one has been generated for matching content.
+    /// @param name Name of the shader.
+    /// @param element The element to generate a shader for.
+    /// @param context The generation context, whose shader generator is used
+    ///    to generate shaders that are not found in the cache.
+    ShaderPtr generate(const string& name, ElementPtr element, GenContext& context);
+
+    /// Return the cache key for a shader generated with the given arguments.
+    static string computeKey(const string& name, ElementPtr element, GenContext& context);
+
+    /// Return the shader with the given key, or nullptr if no such shader
+    /// is found in the cache.
+    ShaderPtr find(const string& key) const;
+
+    /// Add a shader to the cache with the given key.
+    void add(const string& key, ShaderPtr shader);
+
+    /// Return the number of shaders in the cache.
+    size_t size() const;
+
+    /// Return the number of generate calls that have been served from
+    /// the cache.
+    size_t getHitCount() const;
+
+    /// Clear all shaders from the cache.
+    void clear();
+
+  private:
+    mutable std::mutex _mutex;
+    std::unordered_map<string, ShaderPtr> _shaders;
+    size_t _hitCount;
+};
+
+/// @class ShaderNodeImplCache
+/// A cache of initialized shader node implementations, which may be shared
+/// by the generation contexts of multiple threads.
+///
+/// When a context holds a node implementation cache, implementations that
+/// are not found in the context are looked up in the shared cache, and
+/// implementations initialized by the context are added to it, so source
+/// files are read and compound graphs are built once per process rather
+/// than once per context.
+///
+/// Implementations are keyed by the content of their implementation element
+/// and the definitions it reaches, the target and class of the shader
+/// generator, the generation options, and the source code search path and
+/// reserved words of the initializing context.  Implementations are shared
+/// only when the shader generator leaves them unmodified during generation,
+/// and light shader implementations, which are modified when bound, are
+/// never shared.  All methods are thread-safe.
+class MX_GENSHADER_API ShaderNodeImplCache
+{
+  public:
+    ShaderNodeImplCache() :
+        _hitCount(0)
+    {
+    }
+    ~ShaderNodeImplCache() { }
+
+    /// Create a new node implementation cache.
+    static ShaderNodeImplCachePtr create()
+    {
+        return std::make_shared<ShaderNodeImplCache>();
+    }
+
+    /// Return true if implementations of the given element may be shared
+    /// between contexts.
+    static bool isShareable(const InterfaceElement& element);
+
+    /// Return the cache key for an implementation of the given element
+    /// initialized by the given context.
+    static string computeKey(const InterfaceElement& element, GenContext& context);
+
+    /// Return the implementation with the given key, or nullptr if no such
+    /// implementation is found in the cache.
+    ShaderNodeImplPtr find(const string& key);
+
+    /// Add an initialized implementation to the cache with the given key,
+    /// returning the cached implementation.  If an implementation has already
+    /// been added with this key, for example by another thread initializing
+    /// the same element, then the existing implementation is kept.
+    ShaderNodeImplPtr add(const string& key, ShaderNodeImplPtr impl);
+
+    /// Return the number of implementations in the cache.
+    size_t size() const;
+
+    /// Return the number of lookups that have been served from the cache.
+    size_t getHitCount() const;
+
+    /// Clear all implementations from the cache.
+    void clear();
+
+  private:
+    mutable std::mutex _mutex;
+    std::unordered_map<string, ShaderNodeImplPtr> _impls;
+    size_t _hitCount;
+};
+
+/// @class SourceFile
+/// The content of a source code file, as stored in a SourceFileCache.
+class MX_GENSHADER_API SourceFile
+{
+  public:
+    /// The content of the file.
+    string content;
+
+    /// The content of the file split into lines, without line endings.
+    StringVec lines;
+
+    /// The modification time of the file when it was read.
+    uint64_t modificationTime = 0;
+};
+
+/// @class SourceFileCache
+/// A process-wide cache of the source code files read during shader
+/// generation, such as node implementation sources and included files.
+///
+/// Files are keyed by their resolved path, and are read again when their
+/// modification time changes.  Each file is split into lines once when it
+/// is read, so that emitting its content does not split it again.  All
+/// methods are thread-safe.
+class MX_GENSHADER_API SourceFileCache
+{
+  public:
+    SourceFileCache() :
+        _hitCount(0),
+        _missCount(0)
+    {
+    }
+    ~SourceFileCache() { }
+
+    /// Return the source file cache shared by all shader generators.
+    static SourceFileCache& getInstance();
+
+    /// Return the content of the given file, reading it if it is not found
+    /// in the cache or has been modified since it was read.  Returns nullptr
+    /// if the file cannot be read or is empty.
+    ConstSourceFilePtr read(const FilePath& file);
+
+    /// Return the number of files in the cache.
+    size_t size() const;
+
+    /// Return the number of reads that have been served from the cache.
+    size_t getHitCount() const;
+
+    /// Return the number of reads that have loaded a file from disk.
+    size_t getMissCount() const;
+
+    /// Clear all files and statistics from the cache.
+    void clear();
+
+  private:
+    mutable std::mutex _mutex;
+    std::unordered_map<string, ConstSourceFilePtr> _files;
+    size_t _hitCount;
+    size_t _missCount;
+};
+
+/// @class FunctionDefinitionCache
+/// A cache of the function definitions emitted by a node implementation.
+///
+/// Implementations whose function definitions depend only on their own
+/// content, the shader generator and the generation options hold such a
+/// cache, so that a definition is emitted once and then added to the stages
+/// of later shaders as a recorded fragment.  This saves re-emitting the
+/// nested graphs of compound nodes when regenerating shaders, for example
+/// after an edit to a material.  Fragments reference the definitions of
+/// nested nodes and the files they include, which are only added to stages
+/// that do not already contain them.
+///
+/// Definitions are keyed by the shader stage, the target and class of the
+/// shader generator, and the generation options.  All methods are
+/// thread-safe.
+class MX_GENSHADER_API FunctionDefinitionCache
+{
+  public:
+    FunctionDefinitionCache() :
+        _hitCount(0)
+    {
+    }
+    ~FunctionDefinitionCache() { }
+
+    /// Create a new function definition cache.
+    static FunctionDefinitionCachePtr create()
+    {
+        return std::make_shared<FunctionDefinitionCache>();
+    }
+
+    /// Return the cache key for a definition emitted to the given stage
+    /// with the given context.
+    static string computeKey(const ShaderStage& stage, GenContext& context);
+
+    /// Return the definition with the given key, or nullptr if no such
+    /// definition is found in the cache.
+    ConstShaderFragmentPtr find(const string& key);
+
+    /// Add a definition to the cache with the given key.
+    void add(const string& key, ConstShaderFragmentPtr fragment);
+
+    /// Return the number of definitions in the cache.
+    size_t size() const;
+
+    /// Return the number of lookups that have been served from the cache.
+    size_t getHitCount() const;
+
+    /// Clear all definitions from the cache.
+    void clear();
+
+  private:
+    mutable std::mutex _mutex;
+    std::unordered_map<string, ConstShaderFragmentPtr> _definitions;
+    size_t _hitCount;
+};
+
+} // namespace MaterialX
+
+#endif
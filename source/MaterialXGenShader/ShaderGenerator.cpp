@@ -6,6 +6,7 @@
 #include <MaterialXGenShader/ShaderGenerator.h>
 
 #include <MaterialXGenShader/GenContext.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/ShaderNodeImpl.h>
 #include <MaterialXGenShader/Nodes/CompoundNode.h>
 #include <MaterialXGenShader/Nodes/SourceCodeNode.h>
@@ -263,6 +264,24 @@ ShaderNodeImplPtr ShaderGenerator::getImplementation(const InterfaceElement& ele
         return impl;
     }
 
+    // Check if it's been initialized by another context sharing a cache.
+    ShaderNodeImplCachePtr sharedCache = context.getNodeImplementationCache();
+    if (sharedCache && (!canShareImplementations() || !ShaderNodeImplCache::isShareable(element)))
+    {
+        sharedCache = nullptr;
+    }
+    string sharedKey;
+    if (sharedCache)
+    {
+        sharedKey = ShaderNodeImplCache::computeKey(element, context);
+        impl = sharedCache->find(sharedKey);
+        if (impl)
+        {
+            context.addNodeImplementation(name, impl);
+            return impl;
+        }
+    }
+
     if (element.isA<NodeGraph>())
     {
         // Use a compound implementation.
@@ -284,7 +303,11 @@ ShaderNodeImplPtr ShaderGenerator::getImplementation(const InterfaceElement& ele
     }
     impl->initialize(element, context);
 
-    // Cache it.
+    // Cache it, sharing it with other contexts if requested.
+    if (sharedCache)
+    {
+        impl = sharedCache->add(sharedKey, impl);
+    }
     context.addNodeImplementation(name, impl);
 
     return impl;
@@ -350,7 +373,7 @@ void ShaderGenerator::registerShaderMetadata(const DocumentPtr& doc, GenContext&
 void ShaderGenerator::replaceTokens(const StringMap& substitutions, ShaderStage& stage) const
 {
     // Replace tokens in source code
-    tokenSubstitution(substitutions, stage._code);
+    stage.substituteTokens(substitutions);
 
     // Replace tokens on shader interface
     for (size_t i = 0; i < stage._constants.size(); ++i)
@@ -26,6 +26,9 @@ namespace MaterialX
 /// All third-party shader generators should derive from this class.
 /// Derived classes should use DECLARE_SHADER_GENERATOR / DEFINE_SHADER_GENERATOR
 /// in their declaration / definition, and register with the Registry class.
+/// A generator holds no state that changes during generation, so a single
+/// instance may generate shaders concurrently on several threads, given a
+/// separate GenContext per thread.
 class MX_GENSHADER_API ShaderGenerator
 {
   public:
@@ -162,7 +165,17 @@ class MX_GENSHADER_API ShaderGenerator
     /// will be returned, as defined by the createDefaultImplementation method.
     ShaderNodeImplPtr getImplementation(const InterfaceElement& element, GenContext& context) const;
 
-    /// Return the map of token substitutions used by the generator.
+    /// Return true if node implementations initialized by this generator may
+    /// be shared between contexts through a ShaderNodeImplCache.  Generators
+    /// that modify the graphs of implementations during shader generation
+    /// should return false.  Defaults to true.
+    virtual bool canShareImplementations() const
+    {
+        return true;
+    }
+
+    /// Return the map of token substitutions registered by the generator.
+    /// Substitutions that vary per generation are set on the GenContext.
     const StringMap& getTokenSubstitutions() const
     {
         return _tokenSubstitutions;
@@ -217,7 +230,7 @@ class MX_GENSHADER_API ShaderGenerator
     Factory<ShaderNodeImpl> _implFactory;
     ColorManagementSystemPtr _colorManagementSystem;
     UnitSystemPtr _unitSystem;
-    mutable StringMap _tokenSubstitutions;
+    StringMap _tokenSubstitutions;
 
     friend ShaderGraph;
 };
@@ -9,19 +9,392 @@
 #include <MaterialXGenShader/ShaderGenerator.h>
 #include <MaterialXGenShader/Util.h>
 
+#include <algorithm>
+#include <cmath>
+#include <functional>
 #include <iostream>
 #include <queue>
+#include <set>
+#include <unordered_map>
 
 namespace MaterialX
 {
 
+namespace {
+
+// Return the channels of a numeric value, converting integer and boolean
+// values to floats.  Returns false if the type is not numeric, or does not
+// match the type of the value.
+bool getValueChannels(const TypeDesc* type, const Value& value, vector<float>& channels)
+{
+    channels.clear();
+    if (value.getTypeString() != type->getName())
+    {
+        return false;
+    }
+    if (type == Type::FLOAT)
+    {
+        channels.push_back(value.asA<float>());
+    }
+    else if (type == Type::INTEGER)
+    {
+        channels.push_back((float) value.asA<int>());
+    }
+    else if (type == Type::BOOLEAN)
+    {
+        channels.push_back(value.asA<bool>() ? 1.0f : 0.0f);
+    }
+    else if (type == Type::VECTOR2)
+    {
+        const Vector2& v = value.asA<Vector2>();
+        channels.assign(v.begin(), v.end());
+    }
+    else if (type == Type::VECTOR3)
+    {
+        const Vector3& v = value.asA<Vector3>();
+        channels.assign(v.begin(), v.end());
+    }
+    else if (type == Type::VECTOR4)
+    {
+        const Vector4& v = value.asA<Vector4>();
+        channels.assign(v.begin(), v.end());
+    }
+    else if (type == Type::COLOR3)
+    {
+        const Color3& v = value.asA<Color3>();
+        channels.assign(v.begin(), v.end());
+    }
+    else if (type == Type::COLOR4)
+    {
+        const Color4& v = value.asA<Color4>();
+        channels.assign(v.begin(), v.end());
+    }
+    return !channels.empty();
+}
+
+// Return the channels of a literal input value.  Returns false if the input
+// is connected, has no value, or is not of a numeric type.
+bool getValueChannels(const ShaderInput* input, vector<float>& channels)
+{
+    if (!input || input->getConnection() || !input->getValue())
+    {
+        channels.clear();
+        return false;
+    }
+
+    // Values pushed downstream through swizzles are stored as strings, so
+    // are parsed as the type of the input.
+    ValuePtr value = input->getValue();
+    if (value->isA<string>() && input->getType() != Type::STRING)
+    {
+        try
+        {
+            value = Value::createValueFromStrings(value->asA<string>(), input->getType()->getName());
+        }
+        catch (ExceptionTypeError&)
+        {
+            channels.clear();
+            return false;
+        }
+    }
+    return getValueChannels(input->getType(), *value, channels);
+}
+
+// Create a value of the given float-based type from its channels, returning
+// nullptr if the type is not supported.
+ValuePtr createChannelValue(const TypeDesc* type, const vector<float>& c)
+{
+    if (type == Type::FLOAT && c.size() == 1)
+    {
+        return Value::createValue(c[0]);
+    }
+    if (type == Type::VECTOR2 && c.size() == 2)
+    {
+        return Value::createValue(Vector2(c[0], c[1]));
+    }
+    if (type == Type::VECTOR3 && c.size() == 3)
+    {
+        return Value::createValue(Vector3(c[0], c[1], c[2]));
+    }
+    if (type == Type::VECTOR4 && c.size() == 4)
+    {
+        return Value::createValue(Vector4(c[0], c[1], c[2], c[3]));
+    }
+    if (type == Type::COLOR3 && c.size() == 3)
+    {
+        return Value::createValue(Color3(c[0], c[1], c[2]));
+    }
+    if (type == Type::COLOR4 && c.size() == 4)
+    {
+        return Value::createValue(Color4(c[0], c[1], c[2], c[3]));
+    }
+    return nullptr;
+}
+
+// Evaluate a standard library node over literal inputs, mirroring the
+// behavior of its shader implementations.  Returns nullptr if the node
+// category or its types are not supported, or if evaluation would depend
+// on behavior that differs between targets, such as division by zero.
+ValuePtr evaluateConstantNode(const ShaderNode& node)
+{
+    using UnaryOp = std::function<float(float)>;
+    using BinaryOp = std::function<float(float, float)>;
+    static const std::unordered_map<string, UnaryOp> UNARY_OPS =
+    {
+        { "absval", [](float a) { return std::abs(a); } },
+        { "floor", [](float a) { return std::floor(a); } },
+        { "ceil", [](float a) { return std::ceil(a); } }
+    };
+    static const std::unordered_map<string, BinaryOp> BINARY_OPS =
+    {
+        { "add", [](float a, float b) { return a + b; } },
+        { "subtract", [](float a, float b) { return a - b; } },
+        { "multiply", [](float a, float b) { return a * b; } },
+        { "divide", [](float a, float b) { return a / b; } },
+        { "min", [](float a, float b) { return std::min(a, b); } },
+        { "max", [](float a, float b) { return std::max(a, b); } }
+    };
+
+    const string& category = node.getCategory();
+    const ShaderOutput* output = node.getOutput();
+    const size_t outSize = output->getType()->getSize();
+    if (outSize < 1 || outSize > 4)
+    {
+        return nullptr;
+    }
+
+    // Return the given channel of a componentwise operand, broadcasting
+    // scalar operands across all channels.
+    auto channel = [](const vector<float>& operand, size_t i)
+    {
+        return operand.size() == 1 ? operand[0] : operand[i];
+    };
+    auto isOperand = [outSize](const vector<float>& operand)
+    {
+        return operand.size() == 1 || operand.size() == outSize;
+    };
+
+    vector<float> in1, in2, in3;
+    vector<float> result(outSize);
+    auto unaryOp = UNARY_OPS.find(category);
+    auto binaryOp = BINARY_OPS.find(category);
+    if (unaryOp != UNARY_OPS.end())
+    {
+        if (!getValueChannels(node.getInput("in"), in1) || in1.size() != outSize)
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            result[i] = unaryOp->second(in1[i]);
+        }
+    }
+    else if (binaryOp != BINARY_OPS.end())
+    {
+        if (!getValueChannels(node.getInput("in1"), in1) || in1.size() != outSize ||
+            !getValueChannels(node.getInput("in2"), in2) || !isOperand(in2))
+        {
+            return nullptr;
+        }
+        if (category == "divide" && std::find(in2.begin(), in2.end(), 0.0f) != in2.end())
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            result[i] = binaryOp->second(in1[i], channel(in2, i));
+        }
+    }
+    else if (category == "invert")
+    {
+        if (!getValueChannels(node.getInput("in"), in1) || in1.size() != outSize ||
+            !getValueChannels(node.getInput("amount"), in2) || !isOperand(in2))
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            result[i] = channel(in2, i) - in1[i];
+        }
+    }
+    else if (category == "clamp")
+    {
+        if (!getValueChannels(node.getInput("in"), in1) || in1.size() != outSize ||
+            !getValueChannels(node.getInput("low"), in2) || !isOperand(in2) ||
+            !getValueChannels(node.getInput("high"), in3) || !isOperand(in3))
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            result[i] = std::min(std::max(in1[i], channel(in2, i)), channel(in3, i));
+        }
+    }
+    else if (category == "mix")
+    {
+        if (!getValueChannels(node.getInput("fg"), in1) || in1.size() != outSize ||
+            !getValueChannels(node.getInput("bg"), in2) || in2.size() != outSize ||
+            !getValueChannels(node.getInput("mix"), in3) || !isOperand(in3))
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            const float mix = channel(in3, i);
+            result[i] = in2[i] * (1.0f - mix) + in1[i] * mix;
+        }
+    }
+    else if (category == "convert")
+    {
+        // Scalars are broadcast, while vectors are truncated or padded with
+        // zero, or with one for a fourth channel, as in ConvertNode.
+        if (!getValueChannels(node.getInput("in"), in1))
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            result[i] = in1.size() == 1 ? in1[0] : (i < in1.size() ? in1[i] : (i == 3 ? 1.0f : 0.0f));
+        }
+    }
+    else if (category == "swizzle")
+    {
+        const ShaderInput* in = node.getInput("in");
+        const ShaderInput* channels = node.getInput("channels");
+        if (!getValueChannels(in, in1) || !channels || channels->getConnection() || !channels->getValue())
+        {
+            return nullptr;
+        }
+        const string& pattern = channels->getValue()->getValueString();
+        if (pattern.size() != outSize)
+        {
+            return nullptr;
+        }
+        for (size_t i = 0; i < outSize; i++)
+        {
+            const char ch = pattern[i];
+            if (ch == '0' || ch == '1')
+            {
+                result[i] = ch == '0' ? 0.0f : 1.0f;
+                continue;
+            }
+            const int index = in->getType()->getChannelIndex(ch);
+            if (index < 0 || (size_t) index >= in1.size())
+            {
+                return nullptr;
+            }
+            result[i] = in1[index];
+        }
+    }
+    else if (category == "combine2" || category == "combine3" || category == "combine4")
+    {
+        result.clear();
+        for (const ShaderInput* input : node.getInputs())
+        {
+            if (!getValueChannels(input, in1))
+            {
+                return nullptr;
+            }
+            result.insert(result.end(), in1.begin(), in1.end());
+        }
+    }
+    else if (category == "extract")
+    {
+        const ShaderInput* index = node.getInput("index");
+        if (!getValueChannels(node.getInput("in"), in1) || !getValueChannels(index, in2) ||
+            index->getType() != Type::INTEGER || in2[0] < 0.0f || in2[0] >= (float) in1.size())
+        {
+            return nullptr;
+        }
+        result[0] = in1[(size_t) in2[0]];
+    }
+    else
+    {
+        return nullptr;
+    }
+
+    return createChannelValue(output->getType(), result);
+}
+
+template<class T> void appendKey(string& key, const T& data)
+{
+    key.append(reinterpret_cast<const char*>(&data), sizeof(T));
+}
+
+void appendKey(string& key, const string& str)
+{
+    appendKey(key, str.size());
+    key.append(str);
+}
+
+// Append an exact encoding of a value to a node key.  Numeric values are
+// encoded by their bits, since their strings may round distinct values.
+void appendValueKey(string& key, const TypeDesc* type, const ValuePtr& value)
+{
+    vector<float> channels;
+    if (!value)
+    {
+        appendKey(key, (size_t) 0);
+    }
+    else if (type != Type::INTEGER && getValueChannels(type, *value, channels))
+    {
+        appendKey(key, channels.size());
+        key.append(reinterpret_cast<const char*>(channels.data()), channels.size() * sizeof(float));
+    }
+    else if (type == Type::MATRIX33)
+    {
+        const Matrix33& m = value->asA<Matrix33>();
+        key.append(reinterpret_cast<const char*>(&m), sizeof(Matrix33));
+    }
+    else if (type == Type::MATRIX44)
+    {
+        const Matrix44& m = value->asA<Matrix44>();
+        key.append(reinterpret_cast<const char*>(&m), sizeof(Matrix44));
+    }
+    else
+    {
+        appendKey(key, value->getValueString());
+    }
+}
+
+// Return a key that is shared by nodes computing identical results: nodes
+// with the same implementation, input values and upstream connections.
+string getNodeKey(const ShaderNode& node)
+{
+    string key;
+    appendKey(key, &node.getImplementation());
+    appendKey(key, node.getCategory());
+    for (const ShaderOutput* output : node.getOutputs())
+    {
+        appendKey(key, output->getName());
+        appendKey(key, output->getType());
+    }
+    for (const ShaderInput* input : node.getInputs())
+    {
+        appendKey(key, input->getName());
+        appendKey(key, input->getType());
+        appendKey(key, input->getFlags());
+        appendKey(key, input->getConnection());
+        appendKey(key, input->getChannels());
+        appendKey(key, input->getUnit());
+        appendKey(key, input->getGeomProp());
+        appendKey(key, input->getSemantic());
+        appendValueKey(key, input->getType(), input->getValue());
+    }
+    return key;
+}
+
+} // anonymous namespace
+
 //
 // ShaderGraph methods
 //
 
 ShaderGraph::ShaderGraph(const ShaderGraph* parent, const string& name, ConstDocumentPtr document, const StringSet& reservedWords) :
     ShaderNode(parent, name),
-    _document(document)
+    _document(document),
+    _numMergedNodes(0),
+    _numMergedTextureNodes(0)
 {
     // Add all reserved words as taken identifiers
     for (const string& n : reservedWords)
@@ -746,7 +1119,7 @@ ShaderNode* ShaderGraph::createNode(const Node& node, GenContext& context)
     _nodeOrder.push_back(newNode.get());
 
     // Check if any of the node inputs should be connected to the graph interface
-    for (ValueElementPtr elem : node.getChildrenOfType<ValueElement>())
+    for (ValueElementPtr elem : node.traverseChildrenOfType<ValueElement>())
     {
         const string& interfaceName = elem->getInterfaceName();
         if (!interfaceName.empty())
@@ -795,7 +1168,7 @@ ShaderNode* ShaderGraph::createNode(const Node& node, GenContext& context)
     UnitSystemPtr unitSystem = context.getShaderGenerator().getUnitSystem();
     const string& targetDistanceUnit = context.getOptions().targetDistanceUnit;
 
-    for (InputPtr input : node.getInputs())
+    for (InputPtr input : node.traverseInputs())
     {
         // It is sufficient that the input type is a filename regardless of whether it is marked as a uniform 
         if (input->getType() == FILENAME_TYPE_STRING)
@@ -885,12 +1258,17 @@ void ShaderGraph::finalize(GenContext& context)
     // Sort the nodes in topological order.
     topologicalSort();
 
+    // Merge nodes that compute identical results.
+    if (context.getOptions().eliminateCommonSubexpressions)
+    {
+        eliminateCommonSubexpressions();
+    }
+
     // Calculate scopes for all nodes in the graph.
-    //
-    // TODO: Enable calculateScopes() again when support for 
-    // conditional nodes are improved.
-    //
-    // calculateScopes();
+    if (context.getOptions().scopeConditionalBranches)
+    {
+        calculateScopes();
+    }
 
     // Analyze the graph and extract information needed by shader nodes and BSDF nodes.
     bool layerOperatorUsed = false;
@@ -1008,6 +1386,14 @@ void ShaderGraph::disconnect(ShaderNode* node) const
 
 void ShaderGraph::optimize(GenContext& context)
 {
+    // Visit nodes in topological order when folding constants, so that
+    // folded values propagate through chains of foldable nodes.
+    const bool foldConstantNodes = context.getOptions().foldConstants;
+    if (foldConstantNodes)
+    {
+        topologicalSort();
+    }
+
     size_t numEdits = 0;
     for (ShaderNode* node : getNodes())
     {
@@ -1058,6 +1444,10 @@ void ShaderGraph::optimize(GenContext& context)
                 ++numEdits;
             }
         }
+        else if (foldConstantNodes && foldConstants(context, node))
+        {
+            ++numEdits;
+        }
     }
 
     if (numEdits > 0)
@@ -1076,7 +1466,10 @@ void ShaderGraph::optimize(GenContext& context)
             }
         }
 
-        // Remove any unused nodes
+        // Remove any unused nodes, keeping the existing order of used nodes
+        // so that the generated code does not depend on node addresses.
+        vector<ShaderNode*> usedNodeOrder;
+        usedNodeOrder.reserve(usedNodes.size());
         for (ShaderNode* node : _nodeOrder)
         {
             if (usedNodes.count(node) == 0)
@@ -1087,10 +1480,13 @@ void ShaderGraph::optimize(GenContext& context)
                 // Erase from storage
                 _nodeMap.erase(node->getName());
             }
+            else
+            {
+                usedNodeOrder.push_back(node);
+            }
         }
 
-        _nodeOrder.resize(usedNodes.size());
-        _nodeOrder.assign(usedNodes.begin(), usedNodes.end());
+        _nodeOrder = usedNodeOrder;
     }
 }
 
@@ -1146,6 +1542,111 @@ void ShaderGraph::bypass(GenContext& context, ShaderNode* node, size_t inputInde
     }
 }
 
+bool ShaderGraph::foldConstants(GenContext& context, ShaderNode* node)
+{
+    // Only standard library nodes are folded, as other nodedefs may share
+    // their categories with different behavior.
+    if (!node->getFlag(ShaderNodeFlag::STANDARD_LIBRARY) ||
+        node->numOutputs() != 1 || node->getOutput()->getConnections().empty())
+    {
+        return false;
+    }
+    for (const ShaderInput* input : node->getInputs())
+    {
+        if (input->getConnection())
+        {
+            return false;
+        }
+    }
+    ValuePtr value = evaluateConstantNode(*node);
+    if (!value)
+    {
+        return false;
+    }
+
+    // Assign the folded value downstream, applying any channel swizzles
+    // as done when bypassing constant nodes.
+    ShaderOutput* output = node->getOutput();
+    ShaderInputVec downstreamConnections = output->getConnections();
+    for (ShaderInput* downstream : downstreamConnections)
+    {
+        output->breakConnection(downstream);
+        const string& channels = downstream->getChannels();
+        if (!channels.empty())
+        {
+            downstream->setValue(context.getShaderGenerator().getSyntax().getSwizzledValue(value,
+                                                                                      output->getType(),
+                                                                                      channels,
+                                                                                      downstream->getType()));
+            downstream->setChannels(EMPTY_STRING);
+        }
+        else
+        {
+            downstream->setValue(value);
+        }
+    }
+    return true;
+}
+
+void ShaderGraph::eliminateCommonSubexpressions()
+{
+    // Visit nodes in topological order, so that upstream duplicates have
+    // been merged before their downstream nodes are keyed.  Closure and
+    // shader nodes are never merged, as their evaluation depends on the
+    // context in which they are used.
+    std::unordered_map<string, ShaderNode*> uniqueNodes;
+    std::set<ShaderNode*> mergedNodes;
+    for (ShaderNode* node : _nodeOrder)
+    {
+        if (node->hasClassification(ShaderNode::Classification::CLOSURE) ||
+            node->hasClassification(ShaderNode::Classification::SHADER))
+        {
+            continue;
+        }
+        auto result = uniqueNodes.emplace(getNodeKey(*node), node);
+        if (result.second)
+        {
+            continue;
+        }
+
+        // Re-route the downstream connections of the duplicate node
+        // to the equivalent outputs of the unique node.
+        ShaderNode* uniqueNode = result.first->second;
+        for (size_t i = 0; i < node->numOutputs(); i++)
+        {
+            ShaderOutput* output = node->getOutput(i);
+            ShaderInputVec downstreamConnections = output->getConnections();
+            for (ShaderInput* downstream : downstreamConnections)
+            {
+                output->breakConnection(downstream);
+                downstream->makeConnection(uniqueNode->getOutput(i));
+            }
+        }
+        mergedNodes.insert(node);
+        _numMergedNodes++;
+        if (node->hasClassification(ShaderNode::Classification::FILETEXTURE))
+        {
+            _numMergedTextureNodes++;
+        }
+    }
+
+    // Remove the merged nodes, preserving the order of remaining nodes.
+    if (!mergedNodes.empty())
+    {
+        for (ShaderNode* node : mergedNodes)
+        {
+            disconnect(node);
+        }
+        _nodeOrder.erase(std::remove_if(_nodeOrder.begin(), _nodeOrder.end(),
+                                        [&mergedNodes](ShaderNode* node) { return mergedNodes.count(node) > 0; }),
+                         _nodeOrder.end());
+        for (ShaderNode* node : mergedNodes)
+        {
+            _nodeMap.erase(node->getName());
+        }
+    }
+}
+
 void ShaderGraph::topologicalSort()
 {
     // Calculate a topological order of the children, using Kahn's algorithm
@@ -1218,62 +1719,68 @@ void ShaderGraph::calculateScopes()
     // TODO: Refactor the scope handling, using scope id's instead
     //
 
-    if (_nodeOrder.empty())
+    for (ShaderNode* node : _nodeOrder)
     {
-        return;
+        node->getScopeInfo() = ShaderNode::ScopeInfo();
     }
 
-    size_t lastNodeIndex = _nodeOrder.size() - 1;
-    ShaderNode* lastNode = _nodeOrder[lastNodeIndex];
-    lastNode->getScopeInfo().type = ShaderNode::ScopeInfo::GLOBAL;
-
-    std::set<ShaderNode*> nodeUsed;
-    nodeUsed.insert(lastNode);
+    // Nodes connected to the graph outputs are always evaluated.
+    ShaderNode::ScopeInfo globalScopeInfo;
+    globalScopeInfo.type = ShaderNode::ScopeInfo::GLOBAL;
+    for (ShaderGraphOutputSocket* outputSocket : getOutputSockets())
+    {
+        ShaderOutput* upstream = outputSocket->getConnection();
+        if (upstream && upstream->getNode() != this)
+        {
+            upstream->getNode()->getScopeInfo().merge(globalScopeInfo);
+        }
+    }
 
     // Iterate nodes in reversed toplogical order such that every node is visited AFTER
     // each of the nodes that depend on it have been processed first.
-    for (int nodeIndex = int(lastNodeIndex); nodeIndex >= 0; --nodeIndex)
+    for (auto it = _nodeOrder.rbegin(); it != _nodeOrder.rend(); ++it)
     {
-        ShaderNode* node = _nodeOrder[nodeIndex];
+        ShaderNode* node = *it;
 
-        // Once we visit a node the scopeInfo has been determined and it will not be changed
-        // By then we have visited all the nodes that depend on it already
-        if (nodeUsed.count(node) == 0)
+        // Nodes without downstream dependencies are emitted in the global scope.
+        ShaderNode::ScopeInfo& currentScopeInfo = node->getScopeInfo();
+        if (currentScopeInfo.type == ShaderNode::ScopeInfo::UNKNOWN)
         {
-            continue;
+            currentScopeInfo.type = ShaderNode::ScopeInfo::GLOBAL;
         }
 
-        const bool isIfElse = node->hasClassification(ShaderNode::Classification::IFELSE);
-        const bool isSwitch = node->hasClassification(ShaderNode::Classification::SWITCH);
-
-        const ShaderNode::ScopeInfo& currentScopeInfo = node->getScopeInfo();
+        // Find the branch inputs for which the implementation emits
+        // upstream nodes inside the branch.
+        const ShaderNodeImpl& impl = node->getImplementation();
+        const size_t numBranchInputs = std::min(node->numInputs(), (size_t) 32);
+        uint32_t fullMask = 0;
+        for (size_t inputIndex = 0; inputIndex < numBranchInputs; ++inputIndex)
+        {
+            if (impl.isConditionalBranch(*node->getInput(inputIndex)))
+            {
+                fullMask |= 1u << inputIndex;
+            }
+        }
 
         for (size_t inputIndex = 0; inputIndex < node->numInputs(); ++inputIndex)
         {
             ShaderInput* input = node->getInput(inputIndex);
 
-            if (input->getConnection())
+            if (input->getConnection() && input->getConnection()->getNode() != this)
             {
                 ShaderNode* upstreamNode = input->getConnection()->getNode();
 
                 // Create scope info for this network brach
                 // If it's a conditonal branch the scope is adjusted
                 ShaderNode::ScopeInfo newScopeInfo = currentScopeInfo;
-                if (isIfElse && (inputIndex == 2 || inputIndex == 3))
+                if (inputIndex < numBranchInputs && (fullMask & (1u << inputIndex)))
                 {
-                    newScopeInfo.adjustAtConditionalInput(node, int(inputIndex), 0x12);
-                }
-                else if (isSwitch && inputIndex != node->numInputs() - 1)
-                {
-                    const uint32_t fullMask = (1 << node->numInputs()) - 1;
                     newScopeInfo.adjustAtConditionalInput(node, int(inputIndex), fullMask);
                 }
 
                 // Add the info to the upstream node
                 ShaderNode::ScopeInfo& upstreamScopeInfo = upstreamNode->getScopeInfo();
                 upstreamScopeInfo.merge(newScopeInfo);
-
-                nodeUsed.insert(upstreamNode);
             }
         }
     }
@@ -1457,7 +1964,7 @@ ShaderGraphEdgeIterator& ShaderGraphEdgeIterator::operator++()
         if (_stack.empty())
         {
             // Traversal is complete.
-            *this = ShaderGraphEdgeIterator::end();
+            _path.clear();
             return *this;
         }
 
@@ -1491,13 +1998,12 @@ const ShaderGraphEdgeIterator& ShaderGraphEdgeIterator::end()
 void ShaderGraphEdgeIterator::extendPathUpstream(ShaderOutput* upstream, ShaderInput* downstream)
 {
     // Check for cycles.
-    if (_path.count(upstream))
+    if (!_path.insert(upstream))
     {
         throw ExceptionFoundCycle("Encountered cycle at element: " + upstream->getFullName());
     }
 
     // Extend the current path to the new element.
-    _path.insert(upstream);
     _upstream = upstream;
     _downstream = downstream;
 }
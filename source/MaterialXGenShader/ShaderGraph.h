@@ -108,6 +108,13 @@ class MX_GENSHADER_API ShaderGraph : public ShaderNode
     /// Return the map of unique identifiers used in the scope of this graph.
     IdentifierMap& getIdentifierMap() { return _identifiers; }
 
+    /// Return the number of nodes merged into equivalent nodes by
+    /// common subexpression elimination.
+    size_t getNumMergedNodes() const { return _numMergedNodes; }
+
+    /// Return the number of texture sampling nodes among the merged nodes.
+    size_t getNumMergedTextureNodes() const { return _numMergedTextureNodes; }
+
   protected:
     static ShaderGraphPtr createSurfaceShader(
         const string& name,
@@ -166,6 +173,15 @@ class MX_GENSHADER_API ShaderGraph : public ShaderNode
     /// with the output's downstream connections.
     void bypass(GenContext& context, ShaderNode* node, size_t inputIndex, size_t outputIndex = 0);
 
+    /// Evaluate a standard library node whose inputs are all unconnected
+    /// values, assigning the result downstream in place of its output.
+    /// Returns true if the node was folded.
+    bool foldConstants(GenContext& context, ShaderNode* node);
+
+    /// Merge nodes with identical implementations, input values and
+    /// upstream connections, keeping the first node in topological order.
+    void eliminateCommonSubexpressions();
+
     /// Sort the nodes in topological order.
     /// @throws ExceptionFoundCycle if a cycle is encountered.
     void topologicalSort();
@@ -193,6 +209,8 @@ class MX_GENSHADER_API ShaderGraph : public ShaderNode
     std::unordered_map<string, ShaderNodePtr> _nodeMap;
     std::vector<ShaderNode*> _nodeOrder;
     IdentifierMap _identifiers;
+    size_t _numMergedNodes;
+    size_t _numMergedTextureNodes;
 
     // Temporary storage for inputs that require color transformations
     std::unordered_map<ShaderInput*, ColorSpaceTransform> _inputColorTransformMap;
@@ -266,7 +284,7 @@ class MX_GENSHADER_API ShaderGraphEdgeIterator
     ShaderInput* _downstream;
     using StackFrame = std::pair<ShaderOutput*, size_t>;
     std::vector<StackFrame> _stack;
-    std::set<ShaderOutput*> _path;
+    PointerSet<ShaderOutput> _path;
 };
 
 } // namespace MaterialX
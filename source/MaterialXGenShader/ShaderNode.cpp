@@ -170,18 +170,16 @@ bool ShaderNode::referencedConditionally() const
 
 void ShaderNode::ScopeInfo::adjustAtConditionalInput(ShaderNode* condNode, int branch, uint32_t fullMask)
 {
-    if (type == ScopeInfo::GLOBAL || (type == ScopeInfo::SINGLE && conditionBitmask == fullConditionMask))
+    // A branch nested inside the branch of another conditional is only
+    // evaluated when both branches are taken, so its scope is the inner
+    // branch, which is itself emitted inside the outer one.
+    if (type == ScopeInfo::GLOBAL || type == ScopeInfo::SINGLE)
     {
         type = ScopeInfo::SINGLE;
         conditionalNode = condNode;
         conditionBitmask = 1 << branch;
         fullConditionMask = fullMask;
     }
-    else if (type == ScopeInfo::SINGLE)
-    {
-        type = ScopeInfo::MULTIPLE;
-        conditionalNode = nullptr;
-    }
 }
 
 void ShaderNode::ScopeInfo::merge(const ScopeInfo &fromScope)
@@ -213,9 +211,25 @@ void ShaderNode::ScopeInfo::merge(const ScopeInfo &fromScope)
     }
 }
 
+namespace
+{
+
+// Return true if the given nodedef has the name of a standard library
+// nodedef, "ND_<node>_<types>", outside of any namespace.
+bool isStandardLibraryNodeDef(const NodeDef& nodeDef)
+{
+    const string prefix = "ND_" + nodeDef.getNodeString() + "_";
+    const string& name = nodeDef.getName();
+    return name.compare(0, prefix.size(), prefix) == 0 &&
+           nodeDef.getQualifiedName(name) == name;
+}
+
+} // anonymous namespace
+
 ShaderNodePtr ShaderNode::create(const ShaderGraph* parent, const string& name, const NodeDef& nodeDef, GenContext& context)
 {
     ShaderNodePtr newNode = std::make_shared<ShaderNode>(parent, name);
+    newNode->_category = nodeDef.getNodeString();
 
     const ShaderGenerator& shadergen = context.getShaderGenerator();
 
@@ -230,6 +244,11 @@ ShaderNodePtr ShaderNode::create(const ShaderGraph* parent, const string& name,
         throw ExceptionShaderGenError("Could not find a matching implementation for node '" + nodeDef.getNodeString() +
             "' matching target '" + shadergen.getTarget() + "'");
     }
+    // The standard library flag is only needed for constant folding.
+    if (context.getOptions().foldConstants)
+    {
+        newNode->setFlag(ShaderNodeFlag::STANDARD_LIBRARY, isStandardLibraryNodeDef(nodeDef));
+    }
 
     // Check for classification based on group name
     unsigned int groupClassification = 0;
@@ -314,6 +314,9 @@ enum class ShaderNodeFlag
 {
     /// Omit the function call for this node.
     EXCLUDE_FUNCTION_CALL = 1 << 0,
+    /// The nodedef of this node has the name of a standard library nodedef.
+    /// Only set when constant folding is enabled.
+    STANDARD_LIBRARY = 1 << 1,
 };
 
 /// @class ShaderNode
@@ -434,6 +437,13 @@ class MX_GENSHADER_API ShaderNode
         return _name;
     }
 
+    /// Return the category of the node definition from which this node was
+    /// created, or an empty string if it was not created from a definition.
+    const string& getCategory() const
+    {
+        return _category;
+    }
+
     /// Return the implementation used for this node.
     const ShaderNodeImpl& getImplementation() const
     {
@@ -532,6 +542,7 @@ class MX_GENSHADER_API ShaderNode
 
     const ShaderGraph* _parent;
     string _name;
+    string _category;
     uint32_t _classification;
     uint32_t _flags;
 
@@ -59,6 +59,13 @@ class MX_GENSHADER_API ShaderNodeImpl
         return _hash;
     }
 
+    /// Return the cache of function definitions emitted by this implementation,
+    /// or nullptr if its definitions are not cached.
+    FunctionDefinitionCachePtr getFunctionDefinitionCache() const
+    {
+        return _functionDefinitionCache;
+    }
+
     /// Add additional inputs on the node
     virtual void addInputs(ShaderNode& node, GenContext& context) const;
 
@@ -97,6 +104,15 @@ class MX_GENSHADER_API ShaderNodeImpl
         return true;
     }
 
+    /// Returns true if an input is a conditional branch of the node, whose
+    /// upstream nodes are emitted by this implementation inside the branch,
+    /// such that they are only evaluated when the branch is selected.
+    /// By default no inputs are considered to be conditional branches.
+    virtual bool isConditionalBranch(const ShaderInput& /*input*/) const
+    {
+        return false;
+    }
+
   protected:
     /// Protected constructor
     ShaderNodeImpl();
@@ -104,6 +120,11 @@ class MX_GENSHADER_API ShaderNodeImpl
   protected:
     string _name;
     size_t _hash;
+
+    /// Cache of emitted function definitions, to be created on initialization
+    /// by implementations whose definitions depend only on their own content,
+    /// the shader generator and the generation options.
+    FunctionDefinitionCachePtr _functionDefinitionCache;
 };
 
 } // namespace MaterialX
@@ -5,6 +5,7 @@
 
 #include <MaterialXGenShader/ShaderStage.h>
 
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/ShaderGenerator.h>
 #include <MaterialXGenShader/GenContext.h>
 #include <MaterialXGenShader/Syntax.h>
@@ -14,6 +15,8 @@
 
 #include <MaterialXFormat/Util.h>
 
+#include <cctype>
+
 namespace MaterialX
 {
 
@@ -22,6 +25,15 @@ namespace Stage
     const string PIXEL = "pixel";
 }
 
+namespace
+{
+    const char TOKEN_PREFIX = '$';
+
+    // Initial capacity of the source code buffer, which is large enough to
+    // hold typical stages without reallocation.
+    const size_t INITIAL_CODE_CAPACITY = 16 * 1024;
+}
+
 //
 // VariableBlock methods
 //
@@ -98,6 +110,7 @@ ShaderStage::ShaderStage(const string& name, ConstSyntaxPtr syntax) :
     _indentations(0),
     _constants("Constants", "cn")
 {
+    _code.reserve(INITIAL_CODE_CAPACITY);
 }
 
 VariableBlockPtr ShaderStage::createUniformBlock(const string& name, const string& instance)
@@ -275,6 +288,10 @@ void ShaderStage::newLine()
 
 void ShaderStage::addString(const string& str)
 {
+    for (size_t pos = str.find(TOKEN_PREFIX); pos != string::npos; pos = str.find(TOKEN_PREFIX, pos + 1))
+    {
+        _tokenPositions.push_back(_code.size() + pos);
+    }
     _code += str;
 }
 
@@ -288,70 +305,282 @@ void ShaderStage::addLine(const string& str, bool semicolon)
 void ShaderStage::addComment(const string& str)
 {
     beginLine();
-    _code += _syntax->getSingleLineComment() + str;
+    _code += _syntax->getSingleLineComment();
+    addString(str);
     endLine(false);
 }
 
 void ShaderStage::addBlock(const string& str, GenContext& context)
 {
-    const string& INCLUDE = _syntax->getIncludeStatement();
-    const string& QUOTE   = _syntax->getStringQuote();
-
     // Add each line in the block seperatelly
     // to get correct indentation
     StringStream stream(str);
     for (string line; std::getline(stream, line); )
     {
-        size_t pos = line.find(INCLUDE);
-        if (pos != string::npos)
+        addBlockLine(line, context);
+    }
+}
+
+void ShaderStage::addBlock(const StringVec& lines, GenContext& context)
+{
+    for (const string& line : lines)
+    {
+        addBlockLine(line, context);
+    }
+}
+
+void ShaderStage::addBlockLine(const string& line, GenContext& context)
+{
+    const string& INCLUDE = _syntax->getIncludeStatement();
+    const string& QUOTE   = _syntax->getStringQuote();
+
+    size_t pos = line.find(INCLUDE);
+    if (pos != string::npos)
+    {
+        size_t startQuote = line.find_first_of(QUOTE);
+        size_t endQuote = line.find_last_of(QUOTE);
+        if (startQuote != string::npos && endQuote != string::npos && endQuote > startQuote)
         {
-            size_t startQuote = line.find_first_of(QUOTE);
-            size_t endQuote = line.find_last_of(QUOTE);
-            if (startQuote != string::npos && endQuote != string::npos && endQuote > startQuote)
+            size_t length = (endQuote - startQuote) - 1;
+            if (length)
             {
-                size_t length = (endQuote - startQuote) - 1;
-                if (length)
-                {
-                    const string filename = line.substr(startQuote + 1, length);
-                    addInclude(filename, context);
-                }
+                const string filename = line.substr(startQuote + 1, length);
+                addInclude(filename, context);
             }
         }
-        else
-        {
-            addLine(line, false);
-        }
+    }
+    else
+    {
+        addLine(line, false);
     }
 }
 
 void ShaderStage::addInclude(const string& file, GenContext& context)
 {
+    addFragmentPart(ShaderFragment::Part::INCLUDE, file);
+
     string modifiedFile = file;
-    tokenSubstitution(context.getShaderGenerator().getTokenSubstitutions(), modifiedFile);
+    tokenSubstitution(context.getTokenSubstitutions(), modifiedFile);
     FilePath resolvedFile = context.resolveSourceFile(modifiedFile);
 
     if (!_includes.count(resolvedFile))
     {
-        string content = readFile(resolvedFile);
-        if (content.empty())
+        ConstSourceFilePtr source = SourceFileCache::getInstance().read(resolvedFile);
+        if (!source)
         {
             throw ExceptionShaderGenError("Could not find include file: '" + file + "'");
         }
         _includes.insert(resolvedFile);
-        addBlock(content, context);
+        beginFragment(nullptr);
+        try
+        {
+            addBlock(source->lines, context);
+        }
+        catch (...)
+        {
+            endFragment();
+            throw;
+        }
+        endFragment();
+    }
+}
+
+void ShaderStage::substituteTokens(const StringMap& substitutions)
+{
+    if (_tokenPositions.empty())
+    {
+        return;
+    }
+
+    // Find the substitution for each token, and the size of the result.
+    const size_t length = _code.size();
+    vector<size_t> tokenEnds(_tokenPositions.size());
+    vector<const string*> replacements(_tokenPositions.size());
+    size_t resultLength = length;
+    for (size_t i = 0; i < _tokenPositions.size(); i++)
+    {
+        const size_t start = _tokenPositions[i];
+        size_t end = start + 1;
+        while (end < length && isalnum((unsigned char) _code[end]))
+        {
+            end++;
+        }
+        tokenEnds[i] = end;
+        if (end > start + 1)
+        {
+            auto it = substitutions.find(_code.substr(start, end - start));
+            if (it != substitutions.end())
+            {
+                replacements[i] = &it->second;
+                resultLength = resultLength - (end - start) + it->second.size();
+            }
+        }
+    }
+
+    // Build the result, recording the positions of any remaining tokens.
+    string result;
+    result.reserve(resultLength);
+    vector<size_t> resultPositions;
+    size_t pos = 0;
+    for (size_t i = 0; i < _tokenPositions.size(); i++)
+    {
+        result.append(_code, pos, _tokenPositions[i] - pos);
+        if (replacements[i])
+        {
+            const string& replacement = *replacements[i];
+            for (size_t p = replacement.find(TOKEN_PREFIX); p != string::npos; p = replacement.find(TOKEN_PREFIX, p + 1))
+            {
+                resultPositions.push_back(result.size() + p);
+            }
+            result += replacement;
+        }
+        else
+        {
+            resultPositions.push_back(result.size());
+            result.append(_code, _tokenPositions[i], tokenEnds[i] - _tokenPositions[i]);
+        }
+        pos = tokenEnds[i];
     }
+    result.append(_code, pos, string::npos);
+
+    _code.swap(result);
+    _tokenPositions.swap(resultPositions);
 }
 
 void ShaderStage::addFunctionDefinition(const ShaderNode& node, GenContext& context)
 {
     const ShaderNodeImpl& impl = node.getImplementation();
     const size_t id = impl.getHash();
+    const bool defined = _definedFunctions.count(id) != 0;
 
-    if (!_definedFunctions.count(id))
+    // A fragment being recorded references definitions of nodes in its own
+    // graph.  Definitions of other nodes, such as bound light shaders, are
+    // only valid in stages that already contain them.
+    if (!_fragmentRecordings.empty() && _fragmentRecordings.back().fragment)
+    {
+        FragmentRecording& recording = _fragmentRecordings.back();
+        if (recording.graph && node.getParent() == recording.graph)
+        {
+            addFragmentPart(ShaderFragment::Part::FUNCTION_DEFINITION, EMPTY_STRING, &node);
+        }
+        else if (defined)
+        {
+            recording.fragment->requiredFunctions.insert(id);
+        }
+        else
+        {
+            recording.incomplete = true;
+        }
+    }
+
+    if (!defined)
     {
         _definedFunctions.insert(id);
-        impl.emitFunctionDefinition(node, context, *this);
+
+        // Cached definitions are only used at global scope, and for generators
+        // that leave implementations unmodified during generation.
+        FunctionDefinitionCachePtr cache = impl.getFunctionDefinitionCache();
+        if (cache && (!_scopes.empty() || !context.getShaderGenerator().canShareImplementations()))
+        {
+            cache = nullptr;
+        }
+        string key;
+        ConstShaderFragmentPtr cached;
+        if (cache)
+        {
+            key = FunctionDefinitionCache::computeKey(*this, context);
+            cached = cache->find(key);
+        }
+
+        // Record the definition if it should be cached, and otherwise
+        // suspend the recording of any enclosing fragment, which only
+        // references the definition.
+        beginFragment(cache && !cached ? std::make_shared<ShaderFragment>() : nullptr, impl.getGraph());
+        try
+        {
+            if (!cached || !addFragment(*cached, context))
+            {
+                impl.emitFunctionDefinition(node, context, *this);
+            }
+        }
+        catch (...)
+        {
+            endFragment();
+            throw;
+        }
+        ShaderFragmentPtr fragment = endFragment();
+
+        if (fragment)
+        {
+            cache->add(key, fragment);
+        }
+    }
+}
+
+bool ShaderStage::addFragment(const ShaderFragment& fragment, GenContext& context)
+{
+    for (size_t id : fragment.requiredFunctions)
+    {
+        if (!_definedFunctions.count(id))
+        {
+            return false;
+        }
+    }
+
+    for (const ShaderFragment::Part& part : fragment.parts)
+    {
+        switch (part.type)
+        {
+        case ShaderFragment::Part::CODE:
+            addString(part.str);
+            break;
+        case ShaderFragment::Part::FUNCTION_DEFINITION:
+            addFunctionDefinition(*part.node, context);
+            break;
+        case ShaderFragment::Part::INCLUDE:
+            addInclude(part.str, context);
+            break;
+        }
+    }
+    return true;
+}
+
+void ShaderStage::beginFragment(ShaderFragmentPtr fragment, const ShaderGraph* graph)
+{
+    _fragmentRecordings.push_back({ fragment, graph, _code.size(), false });
+}
+
+ShaderFragmentPtr ShaderStage::endFragment()
+{
+    FragmentRecording& recording = _fragmentRecordings.back();
+    ShaderFragmentPtr fragment = recording.incomplete ? nullptr : recording.fragment;
+    if (fragment && _code.size() > recording.start)
+    {
+        fragment->parts.push_back({ ShaderFragment::Part::CODE, _code.substr(recording.start), nullptr });
+    }
+    _fragmentRecordings.pop_back();
+
+    // The enclosing fragment continues after the code of the ended fragment.
+    if (!_fragmentRecordings.empty())
+    {
+        _fragmentRecordings.back().start = _code.size();
+    }
+    return fragment;
+}
+
+void ShaderStage::addFragmentPart(ShaderFragment::Part::Type type, const string& str, const ShaderNode* node)
+{
+    if (_fragmentRecordings.empty() || !_fragmentRecordings.back().fragment)
+    {
+        return;
+    }
+    FragmentRecording& recording = _fragmentRecordings.back();
+    if (_code.size() > recording.start)
+    {
+        recording.fragment->parts.push_back({ ShaderFragment::Part::CODE, _code.substr(recording.start), nullptr });
     }
+    recording.fragment->parts.push_back({ type, str, node });
+    recording.start = _code.size();
 }
 
 }
@@ -116,6 +116,51 @@ class MX_GENSHADER_API VariableBlock
     vector<ShaderPort*> _variableOrder;
 };
 
+/// @class ShaderFragment
+/// A fragment of code recorded from a shader stage, which can be added to
+/// other stages.  Along with the code that was emitted directly, a fragment
+/// references the function definitions of nodes in the graph it was recorded
+/// from, and the include files that were added while it was recorded, so
+/// these are only added to a stage that does not already contain them.
+/// Definitions of other nodes that the stage already contained are required
+/// to be present in the stages to which the fragment is added.
+class MX_GENSHADER_API ShaderFragment
+{
+  public:
+    /// A part of a fragment.
+    class Part
+    {
+      public:
+        enum Type
+        {
+            CODE,
+            FUNCTION_DEFINITION,
+            INCLUDE
+        };
+
+        /// The type of this part.
+        Type type;
+
+        /// The code of a CODE part, or the filename of an INCLUDE part.
+        string str;
+
+        /// The node whose function definition is referenced by a
+        /// FUNCTION_DEFINITION part.
+        const ShaderNode* node;
+    };
+
+    /// The parts of the fragment, in the order they were added.
+    vector<Part> parts;
+
+    /// The hashes of function definitions that a stage must contain for
+    /// the fragment to be added.
+    std::set<size_t> requiredFunctions;
+};
+
+/// Shared pointer to a ShaderFragment
+using ShaderFragmentPtr = shared_ptr<ShaderFragment>;
+/// Shared pointer to a const ShaderFragment
+using ConstShaderFragmentPtr = shared_ptr<const ShaderFragment>;
 
 /// @class ShaderStage
 /// A shader stage, containing the state and 
@@ -214,6 +259,9 @@ class MX_GENSHADER_API ShaderStage
     /// Add a block of code.
     void addBlock(const string& str, GenContext& context);
 
+    /// Add a block of code that has been split into lines.
+    void addBlock(const StringVec& lines, GenContext& context);
+
     /// Add the contents of an include file. Making sure it is 
     /// only included once for the shader stage.
     void addInclude(const string& file, GenContext& context);
@@ -224,18 +272,64 @@ class MX_GENSHADER_API ShaderStage
     {
         StringStream str;
         str << value;
-        _code += str.str();
+        addString(str.str());
     }
 
     /// Add the function definition for a node.
+    /// If the implementation of the node holds a function definition cache,
+    /// then the definition is recorded when first emitted, and later stages
+    /// add the cached fragment instead of emitting it again.
     void addFunctionDefinition(const ShaderNode& node, GenContext& context);
 
+    /// Add a fragment of code, along with the function definitions and
+    /// include files it references that have not already been added.
+    /// Returns false, without adding any code, if the stage does not contain
+    /// the function definitions required by the fragment.
+    bool addFragment(const ShaderFragment& fragment, GenContext& context);
+
     /// Set stage function name.
     void setFunctionName(const string& functionName) 
     { 
         _functionName = functionName;
     }
 
+  private:
+    /// Add a single line of a code block, expanding include statements.
+    void addBlockLine(const string& line, GenContext& context);
+
+    /// Replace the tokens found in the source code in a single pass,
+    /// using the token positions recorded as the code was added.
+    void substituteTokens(const StringMap& substitutions);
+
+    /// Begin recording a fragment for the given graph, whose nodes may be
+    /// referenced by the fragment.  If the given fragment is nullptr, then
+    /// the recording of the current fragment is suspended instead.
+    void beginFragment(ShaderFragmentPtr fragment, const ShaderGraph* graph = nullptr);
+
+    /// End the fragment begun by the last call to beginFragment, resuming
+    /// the recording of the enclosing fragment.  Returns the recorded
+    /// fragment, or nullptr if the fragment could not be recorded.
+    ShaderFragmentPtr endFragment();
+
+    /// Add a part to the fragment being recorded, if any.
+    void addFragmentPart(ShaderFragment::Part::Type type, const string& str, const ShaderNode* node = nullptr);
+
+    /// A fragment being recorded.
+    struct FragmentRecording
+    {
+        /// The fragment, or nullptr if recording is suspended.
+        ShaderFragmentPtr fragment;
+
+        /// The graph whose nodes may be referenced by the fragment.
+        const ShaderGraph* graph;
+
+        /// The position in the source code from which pending code starts.
+        size_t start;
+
+        /// Set if a definition that cannot be referenced was emitted.
+        bool incomplete;
+    };
+
   private:
     /// Name of the stage
     const string _name;
@@ -273,6 +367,12 @@ class MX_GENSHADER_API ShaderStage
     /// Resulting source code for this stage.
     string _code;
 
+    /// Positions of the token prefixes in the source code.
+    vector<size_t> _tokenPositions;
+
+    /// Stack of fragments being recorded.
+    vector<FragmentRecording> _fragmentRecordings;
+
     friend class ShaderGenerator;
 };
 
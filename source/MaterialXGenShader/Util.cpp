@@ -465,30 +465,36 @@ namespace
 
 void tokenSubstitution(const StringMap& substitutions, string& source)
 {
+    size_t p1 = source.find(TOKEN_PREFIX);
+    if (p1 == string::npos)
+    {
+        return;
+    }
+
     string buffer;
+    buffer.reserve(source.length());
     size_t pos = 0, len = source.length();
-    while (pos < len)
+    while (p1 != string::npos)
     {
-        size_t p1 = source.find_first_of(TOKEN_PREFIX, pos);
-        if (p1 != string::npos && p1 + 1 < len)
+        buffer.append(source, pos, p1 - pos);
+        pos = p1 + 1;
+        while (pos < len && isalnum((unsigned char) source[pos]))
         {
-            buffer += source.substr(pos, p1 - pos);
-            pos = p1 + 1;
-            string token = { TOKEN_PREFIX };
-            while (pos < len && isalnum(source[pos]))
-            {
-                token += source[pos++];
-            }
-            auto it = substitutions.find(token);
-            buffer += (it != substitutions.end() ? it->second : token);
+            pos++;
+        }
+        auto it = pos > p1 + 1 ? substitutions.find(source.substr(p1, pos - p1)) : substitutions.end();
+        if (it != substitutions.end())
+        {
+            buffer += it->second;
         }
         else
         {
-            buffer += source.substr(pos);
-            break;
+            buffer.append(source, p1, pos - p1);
         }
+        p1 = source.find(TOKEN_PREFIX, pos);
     }
-    source = buffer;
+    buffer.append(source, pos, string::npos);
+    source.swap(buffer);
 }
 
 vector<Vector2> getUdimCoordinates(const StringVec& udimIdentifiers)
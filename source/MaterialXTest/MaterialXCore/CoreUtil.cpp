@@ -8,6 +8,8 @@
 #include <MaterialXCore/Util.h>
 #include <MaterialXCore/Document.h>
 
+#include <atomic>
+
 namespace mx = MaterialX;
 
 TEST_CASE("String utilities", "[coreutil]")
@@ -30,6 +32,33 @@ TEST_CASE("String utilities", "[coreutil]")
     REQUIRE(mx::splitString("[one...two...three]", "[.]") == (std::vector<std::string>{"one", "two", "three"}));
 }
 
+TEST_CASE("Worker threads", "[coreutil]")
+{
+    // Each task is run exactly once across the workers.
+    const size_t TASK_COUNT = 1000;
+    std::vector<int> counts(TASK_COUNT, 0);
+    std::atomic<size_t> nextTask(0);
+    mx::runWorkerThreads(4, [&]()
+    {
+        for (size_t i = nextTask++; i < TASK_COUNT; i = nextTask++)
+        {
+            counts[i]++;
+        }
+    });
+    REQUIRE(counts == std::vector<int>(TASK_COUNT, 1));
+
+    // An exception thrown by a worker is rethrown once all threads are joined.
+    std::atomic<unsigned int> finished(0);
+    REQUIRE_THROWS_AS(mx::runWorkerThreads(4, [&]()
+    {
+        if (finished++ == 0)
+        {
+            throw mx::Exception("Worker failed");
+        }
+    }), mx::Exception&);
+    REQUIRE(finished == 4);
+}
+
 TEST_CASE("Print utilities", "[coreutil]")
 {
     // Create a document.
@@ -10,6 +10,9 @@
 #include <MaterialXFormat/Util.h>
 #include <MaterialXFormat/XmlIo.h>
 
+#include <atomic>
+#include <thread>
+
 namespace mx = MaterialX;
 
 TEST_CASE("Document", "[document]")
@@ -212,3 +215,301 @@ TEST_CASE("Version", "[document]")
     }
 }
 
+
+TEST_CASE("Document cache", "[document]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::loadLibraries({ "stdlib", "pbrlib" }, searchPath, doc);
+
+    // Return the matching elements for each lookup, independent of order.
+    auto getLookups = [](mx::DocumentPtr document, const std::string& name)
+    {
+        std::set<mx::ElementPtr> lookups;
+        for (mx::NodeDefPtr nodeDef : document->getMatchingNodeDefs(name))
+        {
+            lookups.insert(nodeDef);
+            for (mx::InterfaceElementPtr impl : document->getMatchingImplementations(nodeDef->getName()))
+            {
+                lookups.insert(impl);
+            }
+        }
+        for (mx::PortElementPtr port : document->getMatchingPorts(name))
+        {
+            lookups.insert(port);
+        }
+        return lookups;
+    };
+
+    // Populate the cache.
+    REQUIRE(doc->getNodeDef("ND_add_float"));
+
+    // Incrementally add a nodedef, implementations and a connected node.
+    mx::NodeDefPtr nodeDef = doc->addNodeDef("ND_test_float", "float", "test");
+    mx::ImplementationPtr impl = doc->addImplementation("IM_test_float");
+    impl->setNodeDef(nodeDef);
+    mx::NodeGraphPtr graph = doc->addNodeGraph("NG_test_float");
+    graph->setNodeDef(nodeDef);
+    mx::NodePtr node = graph->addNode("test", "test1", "float");
+    mx::OutputPtr output = graph->addOutput("out", "float");
+    output->setConnectedNode(node);
+    REQUIRE(node->getNodeDef() == nodeDef);
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 2);
+    REQUIRE(doc->getMatchingPorts("test1").size() == 1);
+
+    // Reference a node graph by name, before and after it exists.
+    mx::ImplementationPtr graphImpl = doc->addImplementation("IM_test_graph");
+    graphImpl->setNodeGraph("NG_test_graph");
+    graphImpl->setNodeDef(nodeDef);
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 2);
+    mx::NodeGraphPtr refGraph = doc->addNodeGraph("NG_test_graph");
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 3);
+    refGraph->setName("NG_test_graph_renamed");
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 2);
+    refGraph->setName("NG_test_graph");
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 3);
+
+    // Edit and remove cached attributes and elements.
+    output->setNodeName("test2");
+    REQUIRE(doc->getMatchingPorts("test1").empty());
+    REQUIRE(doc->getMatchingPorts("test2").size() == 1);
+    nodeDef->setNodeString("test_renamed");
+    REQUIRE(doc->getMatchingNodeDefs("test").empty());
+    REQUIRE(doc->getMatchingNodeDefs("test_renamed").size() == 1);
+    doc->removeImplementation("IM_test_float");
+    REQUIRE(doc->getMatchingImplementations("ND_test_float").size() == 2);
+
+    // Apply a namespace to a subtree.
+    graph->setNamespace("custom");
+    REQUIRE(doc->getMatchingPorts("test2").empty());
+    REQUIRE(doc->getMatchingPorts("custom:test2").size() == 1);
+    graph->removeAttribute(mx::Element::NAMESPACE_ATTRIBUTE);
+    REQUIRE(doc->getMatchingPorts("test2").size() == 1);
+
+    // Verify that incremental results match a full rebuild.
+    const std::vector<std::string> names = { "add", "test", "test_renamed", "test2", "custom:test2", "ND_test_float", "standard_surface" };
+    std::vector<std::set<mx::ElementPtr>> incremental;
+    for (const std::string& name : names)
+    {
+        incremental.push_back(getLookups(doc, name));
+    }
+    doc->invalidateCache();
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        REQUIRE(getLookups(doc, names[i]) == incremental[i]);
+    }
+}
+
+TEST_CASE("Document cache threading", "[document]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::loadLibraries({ "stdlib", "pbrlib", "bxdf" }, searchPath, doc);
+    REQUIRE(!doc->getMatchingNodeDefs("add").empty());
+
+    mx::StringVec nodeNames;
+    for (mx::NodeDefPtr nodeDef : doc->getNodeDefs())
+    {
+        nodeNames.push_back(nodeDef->getNodeString());
+    }
+    const size_t expectedCount = doc->getMatchingNodeDefs("add").size();
+
+    // Run lookups concurrently against a single shared document, starting
+    // from an invalid cache so that threads also race on the first refresh.
+    const size_t LOOKUP_COUNT = 2000;
+    for (unsigned int threadCount : { 1u, 2u, 4u, 8u })
+    {
+        doc->invalidateCache();
+        std::atomic<size_t> failures(0);
+        std::vector<std::thread> threads;
+        for (unsigned int t = 0; t < threadCount; t++)
+        {
+            threads.emplace_back([&doc, &nodeNames, &failures, expectedCount]()
+            {
+                for (size_t i = 0; i < LOOKUP_COUNT; i++)
+                {
+                    const std::string& nodeName = nodeNames[i % nodeNames.size()];
+                    if (doc->getMatchingNodeDefs(nodeName).empty() ||
+                        doc->getMatchingNodeDefs("add").size() != expectedCount)
+                    {
+                        failures++;
+                    }
+                }
+            });
+        }
+        for (std::thread& thread : threads)
+        {
+            thread.join();
+        }
+        REQUIRE(failures == 0);
+    }
+}
+
+TEST_CASE("NodeDef resolution index", "[document]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::loadLibraries({ "stdlib" }, searchPath, doc);
+
+    // Resolutions track edits to nodedefs and their ports.
+    mx::NodeDefPtr nodeDef = doc->addNodeDef("ND_resolve_float", "float", "resolve");
+    mx::InputPtr declInput = nodeDef->addInput("in", "float");
+    mx::NodeGraphPtr graph = doc->addNodeGraph();
+    mx::NodePtr node = graph->addNode("resolve", "resolve1", "float");
+    node->setInputValue("in", 1.0f);
+    REQUIRE(node->getNodeDef() == nodeDef);
+    declInput->setType("color3");
+    REQUIRE(!node->getNodeDef());
+    declInput->setType("float");
+    REQUIRE(node->getNodeDef() == nodeDef);
+    nodeDef->setTarget("genglsl");
+    REQUIRE(node->getNodeDef("genglsl") == nodeDef);
+    REQUIRE(!node->getNodeDef("genosl"));
+    nodeDef->removeAttribute(mx::InterfaceElement::TARGET_ATTRIBUTE);
+    REQUIRE(node->getNodeDef("genosl") == nodeDef);
+    declInput->setName("in2");
+    REQUIRE(!node->getNodeDef());
+    declInput->setName("in");
+    REQUIRE(node->getNodeDef() == nodeDef);
+    nodeDef->setName("ND_resolve_float_renamed");
+    REQUIRE(node->getNodeDef() == nodeDef);
+    nodeDef->setNodeString("resolve2");
+    REQUIRE(!node->getNodeDef());
+    nodeDef->setNodeString("resolve");
+    REQUIRE(node->getNodeDef() == nodeDef);
+    nodeDef->getActiveOutputs()[0]->setType("color3");
+    REQUIRE(!node->getNodeDef());
+    nodeDef->getActiveOutputs()[0]->setType("float");
+    REQUIRE(node->getNodeDef() == nodeDef);
+    doc->removeNodeDef(nodeDef->getName());
+    REQUIRE(!node->getNodeDef());
+    nodeDef = doc->addNodeDef("ND_resolve_float", "float", "resolve");
+    nodeDef->addInput("in", "float");
+    REQUIRE(node->getNodeDef() == nodeDef);
+
+    // Resolutions track referenced libraries.
+    mx::DocumentPtr library = mx::createDocument();
+    mx::NodeDefPtr libraryNodeDef = library->addNodeDef("ND_resolve_color3", "color3", "resolve");
+    node->setType("color3");
+    node->removeInput("in");
+    REQUIRE(!node->getNodeDef());
+    doc->addReferencedLibrary(library);
+    REQUIRE(node->getNodeDef() == libraryNodeDef);
+    doc->clearReferencedLibraries();
+    REQUIRE(!node->getNodeDef());
+    doc->removeNodeGraph(graph->getName());
+
+    // Verify that indexed resolutions match a reference resolution, first
+    // populating the index from an empty state and then reading it.
+    std::vector<mx::NodeDefPtr> nodeDefs = doc->getNodeDefs();
+    std::vector<mx::NodePtr> nodes;
+    for (size_t i = 0; i < 10000; i++)
+    {
+        if (i % 1000 == 0)
+        {
+            graph = doc->addNodeGraph();
+        }
+        mx::NodeDefPtr decl = nodeDefs[i % nodeDefs.size()];
+        mx::NodePtr instance = graph->addNode(decl->getNodeString(), mx::EMPTY_STRING, decl->getType());
+        for (mx::InputPtr input : decl->getActiveInputs())
+        {
+            instance->addInput(input->getName(), input->getType());
+        }
+        nodes.push_back(instance);
+    }
+    std::vector<mx::NodeDefPtr> reference;
+    for (mx::NodePtr instance : nodes)
+    {
+        mx::NodeDefPtr match;
+        std::vector<mx::NodeDefPtr> candidates = doc->getMatchingNodeDefs(instance->getQualifiedName(instance->getCategory()));
+        std::vector<mx::NodeDefPtr> secondary = doc->getMatchingNodeDefs(instance->getCategory());
+        candidates.insert(candidates.end(), secondary.begin(), secondary.end());
+        for (mx::NodeDefPtr candidate : candidates)
+        {
+            if (mx::targetStringsMatch(candidate->getTarget(), mx::EMPTY_STRING) &&
+                candidate->isVersionCompatible(instance->getVersionString()) &&
+                instance->isTypeCompatible(candidate))
+            {
+                match = candidate;
+                break;
+            }
+        }
+        reference.push_back(match);
+    }
+    doc->invalidateCache();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        std::vector<mx::NodeDefPtr> resolved;
+        for (mx::NodePtr instance : nodes)
+        {
+            resolved.push_back(instance->getNodeDef());
+        }
+        REQUIRE(resolved == reference);
+    }
+    for (size_t i = 0; i < nodes.size(); i++)
+    {
+        REQUIRE(reference[i]);
+        REQUIRE(reference[i]->getNodeString() == nodes[i]->getCategory());
+    }
+}
+
+TEST_CASE("Parallel validation", "[document]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::loadLibraries({ "stdlib", "pbrlib", "bxdf" }, searchPath, doc);
+
+    // Add graphs with invalid connections and values spread through them.
+    for (int i = 0; i < 20; i++)
+    {
+        mx::NodeGraphPtr graph = doc->addNodeGraph("graph" + std::to_string(i));
+        mx::NodePtr prev = graph->addNode("constant", "node0", "color3");
+        for (int j = 1; j < 200; j++)
+        {
+            mx::NodePtr node = graph->addNode("multiply", "node" + std::to_string(j), "color3");
+            node->setConnectedNode("in1", prev);
+            node->setInputValue("in2", mx::Color3(0.5f));
+            if (j % 97 == 0)
+            {
+                node->getInput("in1")->setNodeName("missing");
+            }
+            if (j % 89 == 0)
+            {
+                node->getInput("in2")->setValueString("invalid");
+            }
+            prev = node;
+        }
+        graph->addOutput("out", "color3")->setConnectedNode(prev);
+    }
+    doc->getNodeDef("ND_add_float")->getInput("in1")->setType("unknown");
+
+    // Validate serially as a reference.
+    std::string serialMessage;
+    bool serialResult = doc->validate(&serialMessage);
+    REQUIRE(!serialResult);
+    REQUIRE(!serialMessage.empty());
+
+    // Verify that parallel results are identical for each thread count.
+    for (unsigned int threadCount : { 1u, 2u, 4u, 8u })
+    {
+        std::string parallelMessage;
+        bool parallelResult = doc->validateParallel(&parallelMessage, threadCount);
+        REQUIRE(parallelResult == serialResult);
+        REQUIRE(parallelMessage == serialMessage);
+        REQUIRE(doc->validateParallel(nullptr, threadCount) == serialResult);
+    }
+
+    // Verify results for a valid document.
+    mx::DocumentPtr validDoc = mx::createDocument();
+    validDoc->importLibrary(doc);
+    for (mx::NodeGraphPtr graph : validDoc->getNodeGraphs())
+    {
+        if (graph->getName().compare(0, 5, "graph") == 0)
+        {
+            validDoc->removeNodeGraph(graph->getName());
+        }
+    }
+    validDoc->getNodeDef("ND_add_float")->getInput("in1")->setType("float");
+    REQUIRE(validDoc->validate());
+    REQUIRE(validDoc->validateParallel(nullptr, 4));
+}
@@ -66,3 +66,121 @@ TEST_CASE("Element", "[element]")
     }
     REQUIRE_THROWS_AS(orphan->getDocument(), mx::ExceptionOrphanedElement&);    
 }
+
+TEST_CASE("Attribute storage", "[element]")
+{
+    // Generate a chain of nodes with connected and valued inputs.
+    const int NODE_COUNT = 200;
+    const int INPUT_COUNT = 20;
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::NodeGraphPtr nodeGraph = doc->addNodeGraph();
+    mx::NodePtr prevNode;
+    for (int i = 0; i < NODE_COUNT; i++)
+    {
+        mx::NodePtr node = nodeGraph->addNode("add", "node" + std::to_string(i), "color3");
+        for (int j = 0; j < INPUT_COUNT; j++)
+        {
+            mx::InputPtr input = node->addInput("in" + std::to_string(j), "color3");
+            if (prevNode && j == 0)
+            {
+                input->setNodeName(prevNode->getName());
+            }
+            else
+            {
+                input->setValueString("0.5, 0.5, 0.5");
+                input->setAttribute(mx::ValueElement::UI_NAME_ATTRIBUTE, "Input " + std::to_string(j));
+            }
+        }
+        prevNode = node;
+    }
+
+    // Validate attribute order and values.
+    mx::InputPtr input = doc->getNodeGraphs()[0]->getNode("node1")->getInput("in1");
+    const mx::StringVec expectedNames = { mx::TypedElement::TYPE_ATTRIBUTE, mx::ValueElement::VALUE_ATTRIBUTE, mx::ValueElement::UI_NAME_ATTRIBUTE };
+    REQUIRE(input->getAttributeNames() == expectedNames);
+    REQUIRE(input->getAttribute(mx::ValueElement::UI_NAME_ATTRIBUTE) == "Input 1");
+    input->removeAttribute(mx::ValueElement::VALUE_ATTRIBUTE);
+    REQUIRE(!input->hasAttribute(mx::ValueElement::VALUE_ATTRIBUTE));
+    REQUIRE(input->getAttributeNames().size() == 2);
+    input->setValueString("0.5, 0.5, 0.5");
+    REQUIRE(input->getAttributeNames().back() == mx::ValueElement::VALUE_ATTRIBUTE);
+
+    // Validate attribute lookups across the document.
+    size_t found = 0;
+    for (mx::ElementPtr elem : doc->traverseTree())
+    {
+        found += elem->hasAttribute(mx::PortElement::NODE_NAME_ATTRIBUTE) ? 1 : 0;
+        found += elem->getAttribute(mx::ValueElement::VALUE_ATTRIBUTE).empty() ? 0 : 1;
+        found += elem->getAttribute(mx::TypedElement::TYPE_ATTRIBUTE).empty() ? 0 : 1;
+    }
+    REQUIRE(found == (size_t) NODE_COUNT * (INPUT_COUNT * 2 + 1));
+}
+
+TEST_CASE("Child ranges", "[element]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::NodeGraphPtr nodeGraph = doc->addNodeGraph();
+    mx::NodePtr constant = nodeGraph->addNode("constant", "constant1", "color3");
+    mx::NodePtr image = nodeGraph->addNode("image", "image1", "color3");
+    mx::NodePtr add = nodeGraph->addNode("add", "add1", "color3");
+    add->setConnectedNode("in1", constant);
+    add->setConnectedNode("in2", image);
+    add->addToken("token1");
+    mx::OutputPtr output = nodeGraph->addOutput("out", "color3");
+    output->setConnectedNode(add);
+    nodeGraph->addChildOfCategory("comment");
+
+    // Ranges match the corresponding vectors.
+    std::vector<mx::NodePtr> nodes;
+    for (mx::NodePtr node : nodeGraph->traverseNodes())
+    {
+        nodes.push_back(node);
+    }
+    REQUIRE(nodes == nodeGraph->getNodes());
+    nodes.clear();
+    for (mx::NodePtr node : nodeGraph->traverseNodes("image"))
+    {
+        nodes.push_back(node);
+    }
+    REQUIRE(nodes == nodeGraph->getNodes("image"));
+    std::vector<mx::ValueElementPtr> values;
+    for (mx::ValueElementPtr value : add->traverseChildrenOfType<mx::ValueElement>())
+    {
+        values.push_back(value);
+    }
+    REQUIRE(values == add->getChildrenOfType<mx::ValueElement>());
+    REQUIRE(values.size() == 3);
+    REQUIRE(nodeGraph->traverseOutputs().size() == 1);
+    REQUIRE(nodeGraph->traverseInputs().empty());
+    REQUIRE(nodeGraph->traverseNodes("multiply").empty());
+    REQUIRE(nodeGraph->traverseChildrenOfType<mx::CommentElement>().size() == 1);
+
+    // Subclass checks agree with dynamic casts.
+    for (mx::ElementPtr elem : doc->traverseTree())
+    {
+        REQUIRE(elem->isA<mx::Node>() == (std::dynamic_pointer_cast<mx::Node>(elem) != nullptr));
+        REQUIRE(elem->isA<mx::ValueElement>() == (std::dynamic_pointer_cast<mx::ValueElement>(elem) != nullptr));
+        REQUIRE(elem->isA<mx::PortElement>() == (std::dynamic_pointer_cast<mx::PortElement>(elem) != nullptr));
+        REQUIRE(elem->isA<mx::InterfaceElement>() == (std::dynamic_pointer_cast<mx::InterfaceElement>(elem) != nullptr));
+        REQUIRE(elem->isA<mx::GraphElement>() == (std::dynamic_pointer_cast<mx::GraphElement>(elem) != nullptr));
+        REQUIRE(elem->asA<mx::Input>() == std::dynamic_pointer_cast<mx::Input>(elem));
+    }
+
+    // Ranges may be nested.
+    size_t inputCount = 0;
+    for (mx::NodePtr node : nodeGraph->traverseNodes())
+    {
+        for (mx::InputPtr input : node->traverseInputs())
+        {
+            inputCount += input->hasNodeName() ? 1 : 0;
+        }
+    }
+    REQUIRE(inputCount == 2);
+
+    size_t rangeCount = 0;
+    for (mx::NodePtr node : nodeGraph->traverseNodes())
+    {
+        rangeCount += node->traverseInputs().size();
+    }
+    REQUIRE(rangeCount == 2);
+}
@@ -7,6 +7,8 @@
 
 #include <MaterialXCore/Document.h>
 
+#include <algorithm>
+
 namespace mx = MaterialX;
 
 TEST_CASE("Look", "[look]")
@@ -119,3 +121,216 @@ TEST_CASE("LookGroup", "[look]")
     lookGroups = doc->getLookGroups();
     REQUIRE(lookGroups.size() == 0);
 }
+
+TEST_CASE("GeomAssignIndex", "[look]")
+{
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::NodePtr shaderNode = doc->addNode("standard_surface", "shader1", "surfaceshader");
+    mx::NodePtr materialNode = doc->addMaterialNode("material1", shaderNode);
+    mx::PropertySetPtr propertySet = doc->addPropertySet("propertySet1");
+
+    // Create a scene hierarchy in depth-first order.
+    const int GROUP_COUNT = 10;
+    const int OBJECT_COUNT = 10;
+    const int PART_COUNT = 10;
+    mx::StringVec scene = { "/", "/scene" };
+    for (int i = 0; i < GROUP_COUNT; i++)
+    {
+        std::string group = "/scene/group" + std::to_string(i);
+        scene.push_back(group);
+        for (int j = 0; j < OBJECT_COUNT; j++)
+        {
+            std::string object = group + "/object" + std::to_string(j);
+            scene.push_back(object);
+            for (int k = 0; k < PART_COUNT; k++)
+            {
+                scene.push_back(object + "/part" + std::to_string(k));
+            }
+        }
+    }
+    scene.push_back("/other/object0");
+    scene.push_back("");
+
+    // Create collections with nested includes and excludes.
+    mx::CollectionPtr nested = doc->addCollection("nested");
+    nested->setIncludeGeom("/scene/group3, /scene/group4/object1");
+    nested->setExcludeGeom("/scene/group3/object2");
+    for (int i = 0; i < GROUP_COUNT; i++)
+    {
+        mx::CollectionPtr collection = doc->addCollection("collection" + std::to_string(i));
+        collection->setIncludeGeom("/scene/group" + std::to_string(i));
+        collection->setExcludeGeom("/scene/group" + std::to_string(i) + "/object" + std::to_string(i) +
+                                   ", /scene/group3/object" + std::to_string(i) + "/part1");
+        if (i % 3 == 0)
+        {
+            collection->setIncludeCollection(nested);
+        }
+    }
+
+    // Create looks with assignments to geometry strings and collections.
+    mx::LookPtr look1 = doc->addLook("look1");
+    for (int i = 0; i < GROUP_COUNT; i++)
+    {
+        for (int j = 0; j < OBJECT_COUNT; j += 3)
+        {
+            std::string geom = "/scene/group" + std::to_string(i) + "/object" + std::to_string(j);
+            look1->addMaterialAssign("", materialNode->getName())->setGeom(geom + "/part" + std::to_string(i));
+            mx::PropertyAssignPtr propertyAssign = look1->addPropertyAssign();
+            propertyAssign->setProperty("twosided");
+            propertyAssign->setGeom(geom + ", /scene/group" + std::to_string(j));
+            propertyAssign->setValue(true);
+        }
+        look1->addMaterialAssign("", materialNode->getName())->setCollectionString("collection" + std::to_string(i));
+        look1->addPropertySetAssign()->setCollectionString("collection" + std::to_string((i + 1) % GROUP_COUNT));
+    }
+    mx::VisibilityPtr visibility = look1->addVisibility();
+    visibility->setGeom("/");
+    mx::LookPtr look2 = doc->addLook("look2");
+    look2->setInheritsFrom(look1);
+    look2->addVisibility()->setCollection(nested);
+    look2->addPropertySetAssign()->setPropertySet(propertySet);
+    REQUIRE(doc->validate());
+
+    // Resolve the scene by matching each path against each assignment.
+    mx::LookVec looks = doc->getLooks();
+    auto isBound = [](const std::string& geom, const std::string& assignGeom, mx::CollectionPtr collection)
+    {
+        return mx::geomStringsMatch(geom, assignGeom) || (collection && collection->matchesGeomString(geom));
+    };
+    std::vector<mx::GeomAssigns> reference(scene.size());
+    for (size_t i = 0; i < scene.size(); i++)
+    {
+        const std::string& geom = scene[i];
+        for (mx::LookPtr look : looks)
+        {
+            for (mx::MaterialAssignPtr assign : look->getActiveMaterialAssigns())
+            {
+                if (isBound(geom, assign->getActiveGeom(), assign->getCollection()))
+                {
+                    reference[i].materialAssigns.push_back(assign);
+                }
+            }
+            for (mx::PropertyAssignPtr assign : look->getActivePropertyAssigns())
+            {
+                if (isBound(geom, assign->getGeom(), assign->getCollection()))
+                {
+                    reference[i].propertyAssigns.push_back(assign);
+                }
+            }
+            for (mx::PropertySetAssignPtr assign : look->getActivePropertySetAssigns())
+            {
+                if (isBound(geom, assign->getActiveGeom(), assign->getCollection()))
+                {
+                    reference[i].propertySetAssigns.push_back(assign);
+                }
+            }
+            for (mx::VisibilityPtr assign : look->getActiveVisibilities())
+            {
+                if (isBound(geom, assign->getActiveGeom(), assign->getCollection()))
+                {
+                    reference[i].visibilities.push_back(assign);
+                }
+            }
+        }
+    }
+
+    // Resolve the scene through an index, both by path and as a batch.
+    mx::GeomAssignIndexPtr index = mx::GeomAssignIndex::create(looks);
+    std::vector<mx::GeomAssigns> batch = index->resolve(scene);
+
+    REQUIRE(batch.size() == scene.size());
+    for (size_t i = 0; i < scene.size(); i++)
+    {
+        mx::GeomAssigns single = index->resolve(scene[i]);
+        for (const mx::GeomAssigns& assigns : { single, batch[i] })
+        {
+            REQUIRE(assigns.materialAssigns == reference[i].materialAssigns);
+            REQUIRE(assigns.propertyAssigns == reference[i].propertyAssigns);
+            REQUIRE(assigns.propertySetAssigns == reference[i].propertySetAssigns);
+            REQUIRE(assigns.visibilities == reference[i].visibilities);
+        }
+    }
+    REQUIRE(index->resolve("/scene/group3/object2/part0").visibilities.size() == 2);
+    REQUIRE(index->resolve("/scene/group4/object1/part0").visibilities.size() == 3);
+    REQUIRE(index->resolve("").visibilities.empty());
+
+    // Cycles in collection include chains are reported on creation.
+    nested->setIncludeCollection(doc->getCollection("collection0"));
+    REQUIRE_THROWS_AS(mx::GeomAssignIndex::create(looks), mx::ExceptionFoundCycle&);
+}
+
+TEST_CASE("Batch look resolution", "[look]")
+{
+    // Create a sorted scene hierarchy, and a look group whose active look
+    // inherits from a base look, with assignments spread through the scene.
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::StringVec scene;
+    mx::NodePtr shaderNode = doc->addNode("standard_surface", "shader1", "surfaceshader");
+    mx::NodePtr materialNode = doc->addMaterialNode("material1", shaderNode);
+
+    for (int i = 0; i < 20; i++)
+    {
+        std::string group = "/scene/group" + std::to_string(i);
+        scene.push_back(group);
+        for (int j = 0; j < 50; j++)
+        {
+            std::string object = group + "/object" + std::to_string(j);
+            scene.push_back(object);
+            for (int k = 0; k < 20; k++)
+            {
+                scene.push_back(object + "/part" + std::to_string(k));
+            }
+        }
+    }
+    std::sort(scene.begin(), scene.end());
+
+    mx::LookPtr baseLook = doc->addLook("baseLook");
+    baseLook->addMaterialAssign("", materialNode->getName())->setGeom("/scene");
+    baseLook->addVisibility()->setGeom("/scene/group1");
+    mx::LookPtr look = doc->addLook("look");
+    look->setInheritsFrom(baseLook);
+    for (int i = 0; i < 20; i++)
+    {
+        for (int j = 0; j < 50; j += 7)
+        {
+            std::string object = "/scene/group" + std::to_string(i) + "/object" + std::to_string(j);
+            look->addMaterialAssign("", materialNode->getName())->setGeom(object);
+            mx::PropertyAssignPtr propertyAssign = look->addPropertyAssign();
+            propertyAssign->setProperty("matte");
+            propertyAssign->setGeom(object + "/part" + std::to_string(i));
+            propertyAssign->setValue(true);
+        }
+    }
+    mx::LookGroupPtr lookGroup = doc->addLookGroup("lookGroup");
+    lookGroup->setLooks("baseLook, look");
+    lookGroup->setActiveLook("look");
+
+    // Resolve each path independently as a reference.
+    mx::GeomAssignIndexPtr index = mx::GeomAssignIndex::create({ doc->getLook("look") });
+    std::vector<mx::GeomAssigns> reference;
+    for (const std::string& geom : scene)
+    {
+        reference.push_back(index->resolve(geom));
+    }
+
+    // Compare batch resolution for each thread count.
+    for (unsigned int threadCount : { 1u, 2u, 4u, 0u })
+    {
+        std::vector<mx::GeomAssigns> results = mx::resolveGeomAssigns(lookGroup, scene, threadCount);
+        REQUIRE(results.size() == scene.size());
+        for (size_t i = 0; i < scene.size(); i++)
+        {
+            REQUIRE(results[i].materialAssigns == reference[i].materialAssigns);
+            REQUIRE(results[i].propertyAssigns == reference[i].propertyAssigns);
+            REQUIRE(results[i].visibilities == reference[i].visibilities);
+        }
+    }
+    REQUIRE(mx::resolveGeomAssigns(lookGroup, { "/scene/group1/object7" })[0].materialAssigns.size() == 2);
+    REQUIRE(mx::resolveGeomAssigns(lookGroup, { "/scene/group1/object7" })[0].visibilities.size() == 1);
+
+    // Without an active look, the first look in the group is resolved.
+    lookGroup->setActiveLook("");
+    REQUIRE(mx::resolveGeomAssigns(lookGroup, { "/scene/group1/object7" })[0].materialAssigns.size() == 1);
+    lookGroup->setLooks("");
+    REQUIRE_THROWS_AS(mx::resolveGeomAssigns(lookGroup, scene), mx::Exception&);
+}
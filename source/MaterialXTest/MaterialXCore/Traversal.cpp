@@ -198,3 +198,81 @@ TEST_CASE("InterGraph Tranversal", "[traversal]")
         }
     }
 }
+
+TEST_CASE("Deep and wide traversal", "[traversal]")
+{
+    const size_t CHAIN_DEPTH = 2000;
+    const size_t TREE_DEPTH = 13;
+
+    mx::DocumentPtr doc = mx::createDocument();
+
+    // Create a deep graph, as a single chain of nodes.
+    mx::NodeGraphPtr deepGraph = doc->addNodeGraph("deep");
+    mx::NodePtr prev = deepGraph->addNode("constant", "chain0", "float");
+    for (size_t i = 1; i < CHAIN_DEPTH; i++)
+    {
+        mx::NodePtr node = deepGraph->addNode("add", "chain" + std::to_string(i), "float");
+        node->setConnectedNode("in1", prev);
+        prev = node;
+    }
+    mx::OutputPtr deepOutput = deepGraph->addOutput("out", "float");
+    deepOutput->setConnectedNode(prev);
+
+    // Create a wide graph, as a full binary tree of nodes.
+    mx::NodeGraphPtr wideGraph = doc->addNodeGraph("wide");
+    std::vector<mx::NodePtr> level;
+    for (size_t i = 0; i < ((size_t) 1 << TREE_DEPTH); i++)
+    {
+        level.push_back(wideGraph->addNode("constant", "leaf" + std::to_string(i), "float"));
+    }
+    while (level.size() > 1)
+    {
+        std::vector<mx::NodePtr> nextLevel;
+        for (size_t i = 0; i < level.size(); i += 2)
+        {
+            mx::NodePtr node = wideGraph->addNode("add", "branch" + std::to_string(wideGraph->getChildren().size()), "float");
+            node->setConnectedNode("in1", level[i]);
+            node->setConnectedNode("in2", level[i + 1]);
+            nextLevel.push_back(node);
+        }
+        level = nextLevel;
+    }
+    mx::OutputPtr wideOutput = wideGraph->addOutput("out", "float");
+    wideOutput->setConnectedNode(level[0]);
+
+    // Validate traversal depth and edge counts.
+    size_t maxDepth = 0;
+    size_t maxNodeDepth = 0;
+    size_t edgeCount = 0;
+    for (mx::GraphIterator it = deepOutput->traverseGraph().begin(); it != mx::GraphIterator::end(); ++it)
+    {
+        maxDepth = std::max(maxDepth, it.getElementDepth());
+        edgeCount++;
+    }
+    REQUIRE(maxDepth == CHAIN_DEPTH);
+    REQUIRE(edgeCount == CHAIN_DEPTH);
+    edgeCount = 0;
+    for (mx::GraphIterator it = wideOutput->traverseGraph().begin(); it != mx::GraphIterator::end(); ++it)
+    {
+        maxNodeDepth = std::max(maxNodeDepth, it.getNodeDepth());
+        edgeCount++;
+    }
+    REQUIRE(maxNodeDepth == TREE_DEPTH + 1);
+    REQUIRE(edgeCount == ((size_t) 2 << TREE_DEPTH) - 1);
+    REQUIRE(deepGraph->topologicalSort().size() == CHAIN_DEPTH + 1);
+    REQUIRE(wideGraph->topologicalSort().size() == ((size_t) 2 << TREE_DEPTH));
+    REQUIRE(!deepOutput->hasUpstreamCycle());
+    REQUIRE(!wideOutput->hasUpstreamCycle());
+
+    // Detect cycles at the far end of each graph.
+    mx::NodePtr first = deepGraph->getNode("chain0");
+    first->setConnectedNode("in", deepOutput->getConnectedNode());
+    REQUIRE(deepOutput->hasUpstreamCycle());
+    first->removeInput("in");
+    REQUIRE(!deepOutput->hasUpstreamCycle());
+    mx::NodePtr leaf = wideGraph->getNodes()[0];
+    leaf->setConnectedNode("in", wideOutput->getConnectedNode());
+    REQUIRE(wideOutput->hasUpstreamCycle());
+    leaf->removeInput("in");
+    REQUIRE(!wideOutput->hasUpstreamCycle());
+}
@@ -8,8 +8,38 @@
 #include <MaterialXCore/Util.h>
 #include <MaterialXCore/Value.h>
 
+#include <cstring>
+#include <random>
+#include <sstream>
+
 namespace mx = MaterialX;
 
+template<class T> std::string streamValueString(const T& data, std::ios_base::fmtflags floatField, int precision)
+{
+    std::ostringstream ss;
+    ss.imbue(std::locale::classic());
+    ss.setf(floatField, std::ios_base::floatfield);
+    ss.precision(precision);
+    ss << data;
+    return ss.str();
+}
+
+template<class T> void testValueParsing(const std::string& str)
+{
+    std::istringstream ss(str);
+    ss.imbue(std::locale::classic());
+    T streamData{};
+    if (ss >> streamData)
+    {
+        T data = mx::fromValueString<T>(str);
+        REQUIRE(std::memcmp(&data, &streamData, sizeof(T)) == 0);
+    }
+    else
+    {
+        REQUIRE_THROWS_AS(mx::fromValueString<T>(str), mx::ExceptionTypeError&);
+    }
+}
+
 template<class T> void testTypedValue(const T& v1, const T& v2)
 {
     T v0{};
@@ -78,6 +108,47 @@ TEST_CASE("Value strings", "[value]")
     REQUIRE_THROWS_AS(mx::fromValueString<float>("text"), mx::ExceptionTypeError&);
     REQUIRE_THROWS_AS(mx::fromValueString<bool>("1"), mx::ExceptionTypeError&);
     REQUIRE_THROWS_AS(mx::fromValueString<mx::Color3>("1"), mx::ExceptionTypeError&);
+
+    // Verify that conversions match the results of classic-locale streams.
+    const std::vector<std::string> floatStrings =
+    {
+        "0", "-0", "+3", "1.", ".5", "0.1", "-2.5e-3", "1e10", "1E-10", "16777217",
+        "3.4028235e38", "1e-45", "0.30000000000000004", "123456789012345678901234567890",
+        "1.5abc", " 2", "nan", "inf"
+    };
+    for (const std::string& str : floatStrings)
+    {
+        testValueParsing<float>(str);
+        testValueParsing<double>(str);
+    }
+    const std::vector<std::string> intStrings =
+    {
+        "0", "-0", "+7", "007", "2147483647", "-2147483648", "2147483648", "1.5", " 3"
+    };
+    for (const std::string& str : intStrings)
+    {
+        testValueParsing<int>(str);
+        testValueParsing<long>(str);
+    }
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> dist(-1000.0f, 1000.0f);
+    for (int i = 0; i < 1000; i++)
+    {
+        float value = dist(rng) / (float) (1 << (i % 20));
+        for (int precision : { 3, 6, 9 })
+        {
+            mx::ScopedFloatFormatting defaultFmt(mx::Value::FloatFormatDefault, precision);
+            std::string str = mx::toValueString(value);
+            REQUIRE(str == streamValueString(value, std::ios_base::fmtflags(0), precision));
+            testValueParsing<float>(str);
+            mx::ScopedFloatFormatting fixedFmt(mx::Value::FloatFormatFixed, precision);
+            REQUIRE(mx::toValueString(value) == streamValueString(value, std::ios_base::fixed, precision));
+            mx::ScopedFloatFormatting scientificFmt(mx::Value::FloatFormatScientific, precision);
+            str = mx::toValueString(value);
+            REQUIRE(str == streamValueString(value, std::ios_base::scientific, precision));
+            testValueParsing<float>(str);
+        }
+    }
 }
 
 TEST_CASE("Typed values", "[value]")
@@ -122,3 +193,32 @@ TEST_CASE("Typed values", "[value]")
     REQUIRE(value->isA<std::string>());
     REQUIRE(value->asA<std::string>() == "text");
 }
+
+TEST_CASE("Value string round trip", "[value]")
+{
+    // Convert a value string of each type to and from a data value.
+    const std::vector<std::pair<std::string, std::string>> valueStrings =
+    {
+        { "integer", "42" },
+        { "boolean", "true" },
+        { "float", "0.735" },
+        { "color3", "0.8, 0.25, 0.1" },
+        { "color4", "0.8, 0.25, 0.1, 1" },
+        { "vector2", "0.5, -1.25" },
+        { "vector3", "0.5, -1.25, 3" },
+        { "vector4", "0.5, -1.25, 3, 0.001" },
+        { "matrix33", "1, 0, 0, 0, 1, 0, 0.5, 0.25, 1" },
+        { "matrix44", "1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0.5, 0.25, 0.125, 1" },
+        { "string", "text" },
+        { "integerarray", "1, 2, 3, 4, 5, 6" },
+        { "booleanarray", "true, false, true" },
+        { "floatarray", "0.1, 0.2, 0.3, 0.4, 0.5, 0.6" },
+        { "stringarray", "one, two, three" }
+    };
+    for (const auto& pair : valueStrings)
+    {
+        mx::ValuePtr value = mx::Value::createValueFromStrings(pair.second, pair.first);
+        REQUIRE(value->getTypeString() == pair.first);
+        REQUIRE(value->getValueString() == pair.second);
+    }
+}
@@ -0,0 +1,180 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <MaterialXTest/Catch/catch.hpp>
+
+#include <MaterialXFormat/BinaryIo.h>
+#include <MaterialXFormat/File.h>
+#include <MaterialXFormat/Util.h>
+#include <MaterialXFormat/XmlIo.h>
+
+#include <cstdio>
+#include <fstream>
+
+namespace mx = MaterialX;
+
+TEST_CASE("Binary snapshot", "[binaryio]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::FilePath snapshotFile = "test_libraries." + mx::MTLX_SNAPSHOT_EXTENSION;
+    std::remove(snapshotFile.asString().c_str());
+
+    // Load libraries from XML, writing a new snapshot.
+    mx::DocumentPtr xmlDoc = mx::createDocument();
+    mx::StringSet xmlLibraries = mx::loadLibrariesWithSnapshot({}, searchPath, xmlDoc, snapshotFile);
+    REQUIRE(snapshotFile.exists());
+
+    // Load libraries from the snapshot.
+    mx::DocumentPtr snapshotDoc = mx::createDocument();
+    mx::StringSet snapshotLibraries = mx::loadLibrariesWithSnapshot({}, searchPath, snapshotDoc, snapshotFile);
+
+    // Verify that both paths give identical documents.
+    REQUIRE(snapshotLibraries == xmlLibraries);
+    REQUIRE(*snapshotDoc == *xmlDoc);
+    REQUIRE(mx::writeToXmlString(snapshotDoc) == mx::writeToXmlString(xmlDoc));
+    for (mx::ElementPtr elem : xmlDoc->traverseTree())
+    {
+        mx::ElementPtr other = snapshotDoc->getDescendant(elem->getNamePath());
+        REQUIRE(other);
+        REQUIRE(other->getSourceUri() == elem->getSourceUri());
+    }
+    REQUIRE(snapshotDoc->validate());
+
+    // Libraries restored from a snapshot preserve the attributes of the
+    // document into which they are loaded.
+    mx::DocumentPtr attributeDoc = mx::createDocument();
+    attributeDoc->setColorSpace("acescg");
+    attributeDoc->setVersionString("1.37");
+    mx::loadLibrariesWithSnapshot({}, searchPath, attributeDoc, snapshotFile);
+    REQUIRE(attributeDoc->getColorSpace() == "acescg");
+    REQUIRE(attributeDoc->getVersionString() == "1.37");
+    REQUIRE(attributeDoc->getChildren().size() == xmlDoc->getChildren().size());
+
+    // Snapshots are rejected when their dependency list differs.
+    mx::DocumentPtr doc = mx::createDocument();
+    REQUIRE(!mx::readFromBinaryFile(doc, snapshotFile, { mx::FilePath("missing.mtlx") }));
+    REQUIRE(!mx::readFromBinaryFile(doc, mx::FilePath("missing." + mx::MTLX_SNAPSHOT_EXTENSION)));
+    REQUIRE(doc->getChildren().empty());
+
+    // Snapshots are rejected when a dependency is modified.
+    mx::FilePath sourceFile = "test_snapshot_source.mtlx";
+    mx::DocumentPtr sourceDoc = mx::createDocument();
+    sourceDoc->addNodeGraph("graph1")->addNode("constant", "node1", "float");
+    mx::writeToXmlFile(sourceDoc, sourceFile);
+    mx::writeToBinaryFile(sourceDoc, snapshotFile, { sourceFile });
+    REQUIRE(mx::readFromBinaryFile(doc, snapshotFile));
+    REQUIRE(*doc == *sourceDoc);
+    sourceDoc->getNodeGraph("graph1")->addNode("constant", "node2", "float");
+    mx::writeToXmlFile(sourceDoc, sourceFile);
+    doc = mx::createDocument();
+    REQUIRE(!mx::readFromBinaryFile(doc, snapshotFile));
+    REQUIRE(doc->getChildren().empty());
+
+    // Incomplete snapshots are rejected, and corrupt snapshots throw.
+    mx::writeToBinaryFile(sourceDoc, snapshotFile);
+    std::string contents = mx::readFile(snapshotFile);
+    {
+        std::ofstream file(snapshotFile.asString(), std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size() - 1);
+    }
+    REQUIRE(!mx::readFromBinaryFile(doc, snapshotFile));
+    {
+        std::ofstream file(snapshotFile.asString(), std::ios::binary | std::ios::trunc);
+        file.write(contents.data(), contents.size() - 4);
+        file.write("\xff\xff\xff\xff", 4);
+    }
+    REQUIRE_THROWS_AS(mx::readFromBinaryFile(doc, snapshotFile), mx::ExceptionParseError&);
+
+    std::remove(sourceFile.asString().c_str());
+    std::remove(snapshotFile.asString().c_str());
+}
+
+TEST_CASE("Binary snapshot dependencies", "[binaryio]")
+{
+    // Create a library folder whose file includes a file outside of it.
+    const mx::FilePath libraryFolder = "snapshot_library";
+    const mx::FilePath libraryFile = libraryFolder / mx::FilePath("snapshot_library.mtlx");
+    const mx::FilePath includeFile = "snapshot_include.mtlx";
+    const mx::FilePath snapshotFile = "snapshot_library." + mx::MTLX_SNAPSHOT_EXTENSION;
+    libraryFolder.createDirectory();
+    {
+        std::ofstream file(libraryFile.asString());
+        file << "<?xml version=\"1.0\"?>\n"
+                "<materialx version=\"1.38\">\n"
+                "  <xi:include href=\"../snapshot_include.mtlx\" />\n"
+                "  <!-- Library comment -->\n"
+                "  <nodedef name=\"ND_snapshot_library\" node=\"snapshot_library\" type=\"float\" />\n"
+                "</materialx>\n";
+    }
+    mx::DocumentPtr includeDoc = mx::createDocument();
+    includeDoc->addNodeDef("ND_snapshot_include1", "float", "snapshot_include");
+    mx::writeToXmlFile(includeDoc, includeFile);
+    std::remove(snapshotFile.asString().c_str());
+
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath());
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath, doc, snapshotFile);
+    REQUIRE(snapshotFile.exists());
+    REQUIRE(doc->getNodeDef("ND_snapshot_include1"));
+
+    // Snapshots are rebuilt when an included file is modified.
+    includeDoc->addNodeDef("ND_snapshot_include2", "float", "snapshot_include");
+    mx::writeToXmlFile(includeDoc, includeFile);
+    doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath, doc, snapshotFile);
+    REQUIRE(doc->getNodeDef("ND_snapshot_include2"));
+
+    // Snapshots are rebuilt when read with different options.
+    mx::XmlReadOptions readOptions;
+    readOptions.readComments = true;
+    doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath, doc, snapshotFile, {}, &readOptions);
+    REQUIRE(!doc->getChildrenOfType<mx::CommentElement>().empty());
+    doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath, doc, snapshotFile);
+    REQUIRE(doc->getChildrenOfType<mx::CommentElement>().empty());
+
+    // Snapshots are rebuilt when read with a different search path.
+    const mx::FilePath searchFolder1 = "snapshot_search1";
+    const mx::FilePath searchFolder2 = "snapshot_search2";
+    const mx::FilePath searchLibraryFile = libraryFolder / mx::FilePath("snapshot_search.mtlx");
+    const mx::FilePath searchIncludeFile = "snapshot_search_include.mtlx";
+    {
+        std::ofstream file(searchLibraryFile.asString());
+        file << "<?xml version=\"1.0\"?>\n"
+                "<materialx version=\"1.38\">\n"
+                "  <xi:include href=\"snapshot_search_include.mtlx\" />\n"
+                "</materialx>\n";
+    }
+    for (const mx::FilePath& searchFolder : { searchFolder1, searchFolder2 })
+    {
+        searchFolder.createDirectory();
+        mx::DocumentPtr searchDoc = mx::createDocument();
+        searchDoc->addNodeDef("ND_" + searchFolder.asString(), "float", "snapshot_search");
+        mx::writeToXmlFile(searchDoc, searchFolder / searchIncludeFile);
+    }
+    mx::FileSearchPath searchPath1 = searchPath;
+    searchPath1.append(mx::FilePath::getCurrentPath() / searchFolder1);
+    mx::FileSearchPath searchPath2 = searchPath;
+    searchPath2.append(mx::FilePath::getCurrentPath() / searchFolder2);
+    doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath1, doc, snapshotFile);
+    REQUIRE(doc->getNodeDef("ND_snapshot_search1"));
+    doc = mx::createDocument();
+    mx::loadLibrariesWithSnapshot({ libraryFolder }, searchPath2, doc, snapshotFile);
+    REQUIRE(doc->getNodeDef("ND_snapshot_search2"));
+    REQUIRE(!doc->getNodeDef("ND_snapshot_search1"));
+    for (const mx::FilePath& searchFolder : { searchFolder1, searchFolder2 })
+    {
+        std::remove((searchFolder / searchIncludeFile).asString().c_str());
+        std::remove(searchFolder.asString().c_str());
+    }
+    std::remove(searchLibraryFile.asString().c_str());
+
+    std::remove(libraryFile.asString().c_str());
+    std::remove(libraryFolder.asString().c_str());
+    std::remove(includeFile.asString().c_str());
+    std::remove(snapshotFile.asString().c_str());
+}
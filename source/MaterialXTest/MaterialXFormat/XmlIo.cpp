@@ -10,6 +10,12 @@
 #include <MaterialXFormat/Util.h>
 #include <MaterialXFormat/XmlIo.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
 namespace mx = MaterialX;
 
 TEST_CASE("Load content", "[xmlio]")
@@ -332,3 +338,294 @@ TEST_CASE("Load locale content", "[xmlio_locale]")
     }
 }
 
+TEST_CASE("Parallel library loading", "[xmlio]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+
+    // Load the standard libraries serially and in parallel.
+    std::vector<mx::DocumentPtr> docs;
+    std::vector<mx::StringSet> loadedLibraries;
+    for (unsigned int threadCount : { 1u, 4u, 0u })
+    {
+        mx::DocumentPtr doc = mx::createDocument();
+        loadedLibraries.push_back(mx::loadLibraries({}, searchPath, doc, mx::StringSet(), nullptr, threadCount));
+        docs.push_back(doc);
+    }
+
+    // Verify that all paths give identical documents, including child order.
+    for (size_t i = 1; i < docs.size(); i++)
+    {
+        REQUIRE(loadedLibraries[i] == loadedLibraries[0]);
+        REQUIRE(*docs[i] == *docs[0]);
+        REQUIRE(mx::writeToXmlString(docs[i]) == mx::writeToXmlString(docs[0]));
+    }
+    REQUIRE(docs[1]->validate());
+}
+
+TEST_CASE("Shared xincludes", "[xmlio]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    const size_t DOC_COUNT = 10;
+
+    // A document with xincludes of standard library definitions and
+    // implementations.
+    const std::string docString =
+        "<?xml version=\"1.0\"?>\n"
+        "<materialx version=\"1.38\" xmlns:xi=\"http://www.w3.org/2001/XInclude\">\n"
+        "  <xi:include href=\"stdlib/stdlib_defs.mtlx\" />\n"
+        "  <xi:include href=\"stdlib/stdlib_ng.mtlx\" />\n"
+        "  <xi:include href=\"stdlib/genglsl/stdlib_genglsl_impl.mtlx\" />\n"
+        "  <nodegraph name=\"graph1\">\n"
+        "    <constant name=\"constant1\" type=\"color3\" />\n"
+        "    <multiply name=\"multiply1\" type=\"color3\">\n"
+        "      <input name=\"in1\" type=\"color3\" nodename=\"constant1\" />\n"
+        "    </multiply>\n"
+        "    <smoothstep name=\"smoothstep1\" type=\"color3\">\n"
+        "      <input name=\"in\" type=\"color3\" nodename=\"multiply1\" />\n"
+        "    </smoothstep>\n"
+        "    <output name=\"out\" type=\"color3\" nodename=\"smoothstep1\" />\n"
+        "  </nodegraph>\n"
+        "</materialx>\n";
+
+    // Read documents with copied and shared xincludes.
+    mx::XmlReadOptions sharedOptions;
+    sharedOptions.shareXIncludes = true;
+    mx::clearXIncludeCache();
+    std::vector<mx::DocumentPtr> copiedDocs, sharedDocs;
+    for (size_t i = 0; i < DOC_COUNT; i++)
+    {
+        copiedDocs.push_back(mx::createDocument());
+        mx::readFromXmlString(copiedDocs.back(), docString, searchPath);
+    }
+    for (size_t i = 0; i < DOC_COUNT; i++)
+    {
+        sharedDocs.push_back(mx::createDocument());
+        mx::readFromXmlString(sharedDocs.back(), docString, searchPath, &sharedOptions);
+    }
+
+    mx::DocumentPtr copiedDoc = copiedDocs[0];
+    mx::DocumentPtr sharedDoc = sharedDocs[0];
+    REQUIRE(copiedDoc->validate());
+    REQUIRE(sharedDoc->validate());
+
+    // Shared libraries are referenced rather than copied, and are read once.
+    REQUIRE(sharedDoc->getChildren().size() == 1);
+    REQUIRE(sharedDoc->getReferencedLibraries().size() == 1);
+    for (size_t i = 1; i < DOC_COUNT; i++)
+    {
+        REQUIRE(sharedDocs[i]->getReferencedLibraries() == sharedDoc->getReferencedLibraries());
+    }
+
+    // Definition lookups fall through to shared libraries.
+    mx::NodeDefPtr nodeDef = sharedDoc->getNodeDef("ND_multiply_color3");
+    REQUIRE(nodeDef);
+    REQUIRE(nodeDef->getDocument() == sharedDoc->getReferencedLibraries()[0]);
+    REQUIRE(sharedDoc->getMatchingNodeDefs("multiply").size() == copiedDoc->getMatchingNodeDefs("multiply").size());
+    REQUIRE(sharedDoc->getMatchingImplementations("ND_multiply_color3").size() == 1);
+    REQUIRE(sharedDoc->getImplementation("IM_multiply_color3_genglsl"));
+    REQUIRE(sharedDoc->getTypeDef("color3"));
+    REQUIRE(nodeDef->getImplementation() == sharedDoc->getImplementation("IM_multiply_color3_genglsl"));
+    mx::NodeGraphPtr sharedGraph = sharedDoc->getNodeGraph("graph1");
+    mx::NodeGraphPtr copiedGraph = copiedDoc->getNodeGraph("graph1");
+    for (mx::NodePtr node : copiedGraph->getNodes())
+    {
+        mx::NodeDefPtr sharedNodeDef = sharedGraph->getNode(node->getName())->getNodeDef();
+        REQUIRE(sharedNodeDef);
+        REQUIRE(*sharedNodeDef == *node->getNodeDef());
+    }
+    mx::NodeGraphPtr implGraph = sharedDoc->getReferencedLibraryChild("NG_tiledimage_color3")->asA<mx::NodeGraph>();
+    REQUIRE(implGraph);
+    REQUIRE(implGraph->getNodeDef() == sharedDoc->getNodeDef("ND_tiledimage_color3"));
+    std::vector<mx::InterfaceElementPtr> graphImpls = sharedDoc->getMatchingImplementations("ND_tiledimage_color3");
+    REQUIRE(std::find(graphImpls.begin(), graphImpls.end(), implGraph) != graphImpls.end());
+
+    // Local elements take precedence over library elements of the same name.
+    mx::NodeDefPtr localNodeDef = sharedDoc->addNodeDef("ND_multiply_color3", "color3", "multiply");
+    REQUIRE(sharedDoc->getNodeDef("ND_multiply_color3") == localNodeDef);
+    REQUIRE(sharedDoc->getMatchingNodeDefs("multiply").size() == copiedDoc->getMatchingNodeDefs("multiply").size());
+    sharedDoc->removeNodeDef("ND_multiply_color3");
+
+    // Shared libraries are written as xincludes, and round-trip.
+    std::string xmlString = mx::writeToXmlString(sharedDoc);
+    REQUIRE(xmlString.find("stdlib_defs.mtlx") != std::string::npos);
+    REQUIRE(xmlString.find("stdlib_genglsl_impl.mtlx") != std::string::npos);
+    mx::DocumentPtr rereadDoc = mx::createDocument();
+    mx::readFromXmlString(rereadDoc, xmlString, searchPath, &sharedOptions);
+    REQUIRE(rereadDoc->getReferencedLibraries() == sharedDoc->getReferencedLibraries());
+    REQUIRE(*rereadDoc == *sharedDoc);
+
+    // Referenced libraries carry through copies and imports.
+    REQUIRE(sharedDoc->copy()->getNodeDef("ND_multiply_color3"));
+    mx::DocumentPtr importDoc = mx::createDocument();
+    importDoc->importLibrary(sharedDoc);
+    REQUIRE(importDoc->getNodeDef("ND_multiply_color3"));
+    importDoc->clearReferencedLibraries();
+    REQUIRE(!importDoc->getNodeDef("ND_multiply_color3"));
+
+    // Cycles of referenced libraries are rejected.
+    mx::DocumentPtr cycleLibrary = mx::createDocument();
+    cycleLibrary->addReferencedLibrary(importDoc);
+    REQUIRE_THROWS_AS(importDoc->addReferencedLibrary(cycleLibrary), mx::ExceptionFoundCycle&);
+    REQUIRE_THROWS_AS(importDoc->addReferencedLibrary(importDoc), mx::ExceptionFoundCycle&);
+
+    // Shared libraries are distinguished by the read options that affect
+    // their contents.
+    mx::XmlReadOptions commentOptions = sharedOptions;
+    commentOptions.readComments = true;
+    mx::DocumentPtr commentDoc = mx::createDocument();
+    mx::readFromXmlString(commentDoc, docString, searchPath, &commentOptions);
+    REQUIRE(commentDoc->getReferencedLibraries() != sharedDoc->getReferencedLibraries());
+    mx::XmlReadOptions functionOptions = sharedOptions;
+    functionOptions.readXIncludeFunction = [](mx::DocumentPtr doc, const mx::FilePath& filename,
+                                              const mx::FileSearchPath& path, const mx::XmlReadOptions* options)
+    {
+        mx::readFromXmlFile(doc, filename, path, options);
+    };
+    mx::DocumentPtr functionDoc = mx::createDocument();
+    mx::readFromXmlString(functionDoc, docString, searchPath, &functionOptions);
+    REQUIRE(functionDoc->getReferencedLibraries() != sharedDoc->getReferencedLibraries());
+    REQUIRE(functionDoc->getNodeDef("ND_multiply_color3"));
+
+    // Shared libraries are read again when their includes are modified.
+    const mx::FilePath includeFilename = mx::FilePath::getCurrentPath() / mx::FilePath("shared_xinclude_test.mtlx");
+    {
+        std::ofstream file(includeFilename.asString());
+        file << "<materialx version=\"1.38\"><nodedef name=\"ND_first\" node=\"first\" /></materialx>\n";
+    }
+    const std::string includeDocString =
+        "<materialx version=\"1.38\"><xi:include href=\"" + includeFilename.asString() + "\" /></materialx>\n";
+    mx::DocumentPtr includeDoc = mx::createDocument();
+    mx::readFromXmlString(includeDoc, includeDocString, searchPath, &sharedOptions);
+    REQUIRE(includeDoc->getNodeDef("ND_first"));
+    const uint64_t modificationTime = includeFilename.getModificationTime();
+    for (int i = 0; i < 100 && includeFilename.getModificationTime() == modificationTime; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::ofstream file(includeFilename.asString());
+        file << "<materialx version=\"1.38\"><nodedef name=\"ND_second\" node=\"second\" /></materialx>\n";
+    }
+    REQUIRE(includeFilename.getModificationTime() != modificationTime);
+    includeDoc = mx::createDocument();
+    mx::readFromXmlString(includeDoc, includeDocString, searchPath, &sharedOptions);
+    REQUIRE(!includeDoc->getNodeDef("ND_first"));
+    REQUIRE(includeDoc->getNodeDef("ND_second"));
+    std::remove(includeFilename.asString().c_str());
+
+    mx::clearXIncludeCache();
+}
+
+TEST_CASE("Streaming read and write", "[xmlio]")
+{
+    mx::FilePath libraryPath("libraries/stdlib");
+    mx::FilePath examplesPath("resources/Materials/Examples/Syntax");
+    mx::FileSearchPath searchPath = libraryPath.asString() +
+        mx::PATH_LIST_SEPARATOR +
+        examplesPath.asString();
+    mx::XmlReadOptions domReadOptions;
+    domReadOptions.readComments = true;
+    mx::XmlReadOptions streamReadOptions = domReadOptions;
+    streamReadOptions.streaming = true;
+    mx::XmlWriteOptions streamWriteOptions;
+    streamWriteOptions.streaming = true;
+
+    // Verify that streaming reads and writes match their default equivalents
+    // for library and example documents.
+    mx::FilePathVec filenames = libraryPath.getFilesInDirectory(mx::MTLX_EXTENSION);
+    for (const mx::FilePath& filename : examplesPath.getFilesInDirectory(mx::MTLX_EXTENSION))
+    {
+        filenames.push_back(filename);
+    }
+    for (const mx::FilePath& filename : filenames)
+    {
+        mx::DocumentPtr domDoc = mx::createDocument();
+        mx::readFromXmlFile(domDoc, filename, searchPath, &domReadOptions);
+        mx::DocumentPtr streamDoc = mx::createDocument();
+        mx::readFromXmlFile(streamDoc, filename, searchPath, &streamReadOptions);
+        REQUIRE(*streamDoc == *domDoc);
+        REQUIRE(mx::writeToXmlString(domDoc, &streamWriteOptions) == mx::writeToXmlString(domDoc));
+    }
+
+    // Verify the handling of comments, character references, and whitespace.
+    const std::string docString =
+        "<?xml version=\"1.0\"?>\n"
+        "<!DOCTYPE materialx [ <!ENTITY unused \"value\"> ]>\n"
+        "<materialx version=\"1.38\">\r\n"
+        "  <!-- Comment with\r\n line endings -->\n"
+        "  <nodegraph name='graph1' doc=\"a &amp; b &lt;c&gt; &quot;d&quot; &apos;e&apos; &#65;&#x42; &#x2264; &unknown;\">\n"
+        "    <constant name=\"constant1\" type=\"string\" doc=\"tab\tnewline\ncarriage\r\nend\" />\n"
+        "    <![CDATA[ <ignored name=\"ignored1\" /> ]]>\n"
+        "    <constant name=\"constant1\" type=\"float\" />\n"
+        "  </nodegraph>\n"
+        "</materialx>\n";
+    mx::DocumentPtr domDoc = mx::createDocument();
+    mx::readFromXmlString(domDoc, docString, mx::FileSearchPath(), &domReadOptions);
+    mx::DocumentPtr streamDoc = mx::createDocument();
+    mx::readFromXmlString(streamDoc, docString, mx::FileSearchPath(), &streamReadOptions);
+    REQUIRE(*streamDoc == *domDoc);
+    REQUIRE(streamDoc->getChildren().size() == 2);
+    REQUIRE(streamDoc->getNodeGraph("graph1")->getNodes().size() == 1);
+    domDoc->getChildren()[0]->setDocString("Comment -- with dashes -");
+    domDoc->getNodeGraph("graph1")->setAttribute("control", std::string("\x01\x1f"));
+    REQUIRE(mx::writeToXmlString(domDoc, &streamWriteOptions) == mx::writeToXmlString(domDoc));
+
+    // Verify that XIncludes are processed ahead of document content, with
+    // duplicate elements resolved as in the default reader.
+    const std::string includeString =
+        "<?xml version=\"1.0\"?>\n"
+        "<materialx version=\"1.38\">\n"
+        "  <nodedef name=\"ND_add_float\" node=\"localadd\" />\n"
+        "  <xi:include href=\"stdlib_defs.mtlx\" />\n"
+        "  <nodegraph name=\"graph1\" />\n"
+        "  <xi:include href=\"stdlib_ng.mtlx\" />\n"
+        "</materialx>\n";
+    domDoc = mx::createDocument();
+    mx::readFromXmlString(domDoc, includeString, searchPath, &domReadOptions);
+    streamDoc = mx::createDocument();
+    mx::readFromXmlString(streamDoc, includeString, searchPath, &streamReadOptions);
+    REQUIRE(domDoc->getNodeDef("ND_add_float")->getNodeString() == "add");
+    REQUIRE(domDoc->getChildren().back()->getName() == "graph1");
+    REQUIRE(mx::writeToXmlString(streamDoc) == mx::writeToXmlString(domDoc));
+    REQUIRE(*streamDoc == *domDoc);
+
+    // Malformed documents are reported as parse errors.
+    mx::DocumentPtr errorDoc = mx::createDocument();
+    REQUIRE_THROWS_AS(mx::readFromXmlString(errorDoc, "<materialx><nodegraph name=\"a\"></materialx>",
+                                            mx::FileSearchPath(), &streamReadOptions), mx::ExceptionParseError&);
+    REQUIRE_THROWS_AS(mx::readFromXmlString(errorDoc, "<materialx><nodegraph name=\"a></materialx>",
+                                            mx::FileSearchPath(), &streamReadOptions), mx::ExceptionParseError&);
+
+    // A UTF-8 byte order mark is skipped, while UTF-16 content is rejected.
+    const std::string bomString = "\xEF\xBB\xBF" + docString;
+    streamDoc = mx::createDocument();
+    mx::readFromXmlString(streamDoc, bomString, mx::FileSearchPath(), &streamReadOptions);
+    REQUIRE(streamDoc->getNodeGraph("graph1"));
+    const std::string utf16String("\xFF\xFE<\0m\0a\0t\0>\0", 10);
+    REQUIRE_THROWS_AS(mx::readFromXmlString(errorDoc, utf16String, mx::FileSearchPath(), &streamReadOptions),
+                      mx::ExceptionParseError&);
+
+    // Verify streaming reads and writes of a large generated document.
+    mx::DocumentPtr largeDoc = mx::createDocument();
+    for (int i = 0; i < 20; i++)
+    {
+        mx::NodeGraphPtr graph = largeDoc->addNodeGraph();
+        mx::NodePtr prevNode;
+        for (int j = 0; j < 100; j++)
+        {
+            mx::NodePtr node = graph->addNode("add", mx::EMPTY_STRING, "color3");
+            node->setInputValue("in2", mx::Color3(0.1f, 0.2f, 0.3f));
+            if (prevNode)
+            {
+                node->setConnectedNode("in1", prevNode);
+            }
+            prevNode = node;
+        }
+        graph->addOutput("out", "color3")->setConnectedNode(prevNode);
+    }
+    std::string largeString = mx::writeToXmlString(largeDoc, &streamWriteOptions);
+    REQUIRE(largeString == mx::writeToXmlString(largeDoc));
+    domDoc = mx::createDocument();
+    mx::readFromXmlString(domDoc, largeString, mx::FileSearchPath(), &domReadOptions);
+    streamDoc = mx::createDocument();
+    mx::readFromXmlString(streamDoc, largeString, mx::FileSearchPath(), &streamReadOptions);
+    REQUIRE(*streamDoc == *domDoc);
+}
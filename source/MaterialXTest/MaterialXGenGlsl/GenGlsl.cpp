@@ -10,13 +10,22 @@
 #include <MaterialXCore/Document.h>
 
 #include <MaterialXFormat/File.h>
+#include <MaterialXFormat/Util.h>
 
+#include <MaterialXGenShader/Shader.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/TypeDesc.h>
+#include <MaterialXGenShader/Util.h>
 
 #include <MaterialXGenGlsl/GlslShaderGenerator.h>
 #include <MaterialXGenGlsl/GlslSyntax.h>
 #include <MaterialXGenGlsl/GlslResourceBindingContext.h>
 
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <thread>
+
 namespace mx = MaterialX;
 
 TEST_CASE("GenShader: GLSL Syntax Check", "[genglsl]")
@@ -169,3 +178,373 @@ TEST_CASE("GenShader: GLSL Shader with Layout Generation", "[genglsl]")
     // Generate GLSL with layout i.e version 400 + layout extension
     generateGlslCode(true);
 }
+
+TEST_CASE("GenShader: GLSL Constant Folding", "[genglsl]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+    mx::GenContext context(mx::GlslShaderGenerator::create());
+    context.registerSourceCodeSearchPath(searchPath);
+    context.getOptions().shaderInterfaceType = mx::SHADER_INTERFACE_REDUCED;
+    mx::GenContext foldContext(context);
+    foldContext.getOptions().foldConstants = true;
+
+    // Create a chain of foldable nodes feeding a texture lookup.
+    mx::DocumentPtr doc = mx::createDocument();
+    doc->importLibrary(libraries);
+    mx::NodeGraphPtr graph = doc->addNodeGraph("graph");
+    mx::NodePtr constant = graph->addNode("constant", "constant1", "float");
+    constant->setInputValue("value", 2.0f);
+    mx::NodePtr add = graph->addNode("add", "add1", "float");
+    add->setConnectedNode("in1", constant);
+    add->setInputValue("in2", 3.0f);
+    mx::NodePtr convert = graph->addNode("convert", "convert1", "color3");
+    convert->setConnectedNode("in", add);
+    mx::NodePtr swizzle = graph->addNode("swizzle", "swizzle1", "color3");
+    swizzle->setInputValue("in", mx::Color3(0.25f, 0.5f, 1.0f));
+    swizzle->setInputValue("channels", std::string("bgr"));
+    mx::NodePtr mix = graph->addNode("mix", "mix1", "color3");
+    mix->setConnectedNode("fg", convert);
+    mix->setConnectedNode("bg", swizzle);
+    mix->setInputValue("mix", 0.5f);
+    mx::NodePtr image = graph->addNode("image", "image1", "color3");
+    mx::NodePtr multiply = graph->addNode("multiply", "multiply1", "color3");
+    multiply->setConnectedNode("in1", mix);
+    multiply->setConnectedNode("in2", image);
+    mx::OutputPtr output = graph->addOutput("out", "color3");
+    output->setConnectedNode(multiply);
+    REQUIRE(doc->validate());
+
+    // The folded value (3.0, 2.75, 2.625) replaces the chain of nodes.
+    mx::ShaderPtr shader = context.getShaderGenerator().generate("unfolded", output, context);
+    mx::ShaderPtr foldedShader = foldContext.getShaderGenerator().generate("folded", output, foldContext);
+    const std::string& source = shader->getSourceCode(mx::Stage::PIXEL);
+    const std::string& foldedSource = foldedShader->getSourceCode(mx::Stage::PIXEL);
+    REQUIRE(source.find("vec3(3.000000, 2.750000, 2.625000)") == std::string::npos);
+    REQUIRE(foldedSource.find("vec3(3.000000, 2.750000, 2.625000)") != std::string::npos);
+    REQUIRE(foldedSource.find("mix1") == std::string::npos);
+    REQUIRE(foldedSource.find("image1") != std::string::npos);
+    REQUIRE(foldedSource.size() < source.size());
+
+    // Nodes of other libraries that share the category of a foldable
+    // standard library node are not folded.
+    mx::DocumentPtr customLibrary = mx::createDocument();
+    customLibrary->setNamespace("custom");
+    mx::NodeDefPtr customNodeDef = customLibrary->addNodeDef("ND_add_float", "float", "add");
+    customNodeDef->addInput("in1", "float");
+    customNodeDef->addInput("in2", "float");
+    mx::ImplementationPtr customImpl = customLibrary->addImplementation("IM_add_float_genglsl");
+    customImpl->setNodeDef(customNodeDef);
+    customImpl->setTarget(mx::GlslShaderGenerator::TARGET);
+    customImpl->setAttribute("sourcecode", "{{in1}} - {{in2}}");
+    doc->importLibrary(customLibrary);
+    mx::NodePtr customAdd = graph->addNode("custom:add", "customAdd1", "float");
+    customAdd->setInputValue("in1", 2.0f);
+    customAdd->setInputValue("in2", 3.0f);
+    add->setConnectedNode("in1", customAdd);
+    REQUIRE(customAdd->getNodeDef()->getNamespace() == "custom");
+    foldedShader = foldContext.getShaderGenerator().generate("folded", output, foldContext);
+    const std::string& customSource = foldedShader->getSourceCode(mx::Stage::PIXEL);
+    REQUIRE(customSource.find("customAdd1_out = customAdd1_in1_tmp - customAdd1_in2_tmp;") != std::string::npos);
+    add->setConnectedNode("in1", constant);
+    graph->removeNode(customAdd->getName());
+
+    // Folding never grows the shaders of the example and test suite
+    // materials, and reduces their total size and statement count.
+    size_t sourceSize = 0, foldedSourceSize = 0;
+    size_t statementCount = 0, foldedStatementCount = 0;
+    size_t shaderCount = GenShaderUtil::compareMaterialShaders(libraries, context, foldContext,
+        [&](mx::ShaderPtr elementShader, mx::ShaderPtr foldedElementShader)
+    {
+        const std::string& pixelSource = elementShader->getSourceCode(mx::Stage::PIXEL);
+        const std::string& foldedPixelSource = foldedElementShader->getSourceCode(mx::Stage::PIXEL);
+        REQUIRE(foldedPixelSource.size() <= pixelSource.size());
+        sourceSize += pixelSource.size();
+        foldedSourceSize += foldedPixelSource.size();
+        statementCount += std::count(pixelSource.begin(), pixelSource.end(), ';');
+        foldedStatementCount += std::count(foldedPixelSource.begin(), foldedPixelSource.end(), ';');
+    });
+    REQUIRE(shaderCount > 0);
+    REQUIRE(foldedSourceSize < sourceSize);
+    REQUIRE(foldedStatementCount < statementCount);
+}
+
+TEST_CASE("GenShader: GLSL Common Subexpression Elimination", "[genglsl]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+    mx::GenContext context(mx::GlslShaderGenerator::create());
+    context.registerSourceCodeSearchPath(searchPath);
+    mx::GenContext cseContext(context);
+    cseContext.getOptions().eliminateCommonSubexpressions = true;
+
+    // Create two identical texture lookup chains and a third lookup
+    // of a different file.
+    mx::DocumentPtr doc = mx::createDocument();
+    doc->importLibrary(libraries);
+    mx::NodeGraphPtr graph = doc->addNodeGraph("graph");
+    std::vector<mx::NodePtr> images;
+    for (int i = 0; i < 3; i++)
+    {
+        mx::NodePtr texcoord = graph->addNode("texcoord", "texcoord" + std::to_string(i), "vector2");
+        mx::NodePtr multiply = graph->addNode("multiply", "scale" + std::to_string(i), "vector2");
+        multiply->setConnectedNode("in1", texcoord);
+        multiply->setInputValue("in2", mx::Vector2(2.0f, 2.0f));
+        mx::NodePtr image = graph->addNode("image", "image" + std::to_string(i), "color3");
+        image->setInputValue("file", std::string(i < 2 ? "brick.png" : "wood.png"), mx::FILENAME_TYPE_STRING);
+        image->setConnectedNode("texcoord", multiply);
+        images.push_back(image);
+    }
+    mx::NodePtr add = graph->addNode("add", "add1", "color3");
+    add->setConnectedNode("in1", images[0]);
+    add->setConnectedNode("in2", images[1]);
+    mx::NodePtr multiply = graph->addNode("multiply", "multiply1", "color3");
+    multiply->setConnectedNode("in1", add);
+    multiply->setConnectedNode("in2", images[2]);
+    mx::OutputPtr output = graph->addOutput("out", "color3");
+    output->setConnectedNode(multiply);
+    REQUIRE(doc->validate());
+
+    // The coordinate nodes of all chains and the second lookup are merged
+    // into the first chain, while the lookup of the different file is kept.
+    mx::ShaderPtr shader = context.getShaderGenerator().generate("shader", output, context);
+    mx::ShaderPtr cseShader = cseContext.getShaderGenerator().generate("cse", output, cseContext);
+    const std::string& source = shader->getSourceCode(mx::Stage::PIXEL);
+    const std::string& cseSource = cseShader->getSourceCode(mx::Stage::PIXEL);
+    REQUIRE(shader->getGraph().getNumMergedNodes() == 0);
+    REQUIRE(cseShader->getGraph().getNumMergedNodes() == 5);
+    REQUIRE(cseShader->getGraph().getNumMergedTextureNodes() == 1);
+    REQUIRE(source.find("image1_out") != std::string::npos);
+    REQUIRE(cseSource.find("image1_out") == std::string::npos);
+    REQUIRE(cseSource.find("image0_out") != std::string::npos);
+    REQUIRE(cseSource.find("image2_out") != std::string::npos);
+    REQUIRE(cseSource.size() < source.size());
+
+    // Merging never grows the shaders of the example and test suite
+    // materials, and removes calls from some of them.
+    size_t mergedNodeCount = 0;
+    size_t shaderCount = GenShaderUtil::compareMaterialShaders(libraries, context, cseContext,
+        [&](mx::ShaderPtr elementShader, mx::ShaderPtr cseElementShader)
+    {
+        const std::string& pixelSource = elementShader->getSourceCode(mx::Stage::PIXEL);
+        const std::string& csePixelSource = cseElementShader->getSourceCode(mx::Stage::PIXEL);
+        REQUIRE(csePixelSource.size() <= pixelSource.size());
+        REQUIRE(elementShader->getGraph().getNumMergedNodes() == 0);
+        mergedNodeCount += cseElementShader->getGraph().getNumMergedNodes();
+    });
+    REQUIRE(shaderCount > 0);
+    REQUIRE(mergedNodeCount > 0);
+}
+
+TEST_CASE("GenShader: GLSL Conditional Branch Scopes", "[genglsl]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib" }, searchPath, doc);
+
+    // Create a switch between texture lookups, where the second branch
+    // holds a nested conditional with a lookup of its own, and where the
+    // texture coordinates are shared by all branches and conditions.
+    mx::NodeGraphPtr graph = doc->addNodeGraph("graph");
+    mx::NodePtr texcoord = graph->addNode("texcoord", "texcoord1", "vector2");
+    std::vector<mx::NodePtr> images;
+    for (int i = 0; i < 3; i++)
+    {
+        mx::NodePtr image = graph->addNode("image", "image" + std::to_string(i + 1), "color3");
+        image->setInputValue("file", "image" + std::to_string(i + 1) + ".png", mx::FILENAME_TYPE_STRING);
+        image->setConnectedNode("texcoord", texcoord);
+        images.push_back(image);
+    }
+    mx::NodePtr separate = graph->addNode("separate2", "separate1", "multioutput");
+    separate->setConnectedNode("in", texcoord);
+    mx::NodePtr ifgreater = graph->addNode("ifgreater", "ifgreater1", "color3");
+    ifgreater->addInput("value1", "float")->setConnectedNode(separate);
+    ifgreater->getInput("value1")->setOutputString("outx");
+    ifgreater->setConnectedNode("in1", images[1]);
+    ifgreater->setInputValue("in2", mx::Color3(1.0f, 0.0f, 0.0f));
+    mx::NodePtr switchNode = graph->addNode("switch", "switch1", "color3");
+    switchNode->setConnectedNode("in1", images[0]);
+    switchNode->setConnectedNode("in2", ifgreater);
+    switchNode->setConnectedNode("in3", images[2]);
+    switchNode->addInput("which", "float")->setConnectedNode(separate);
+    switchNode->getInput("which")->setOutputString("outy");
+    mx::OutputPtr output = graph->addOutput("out", "color3");
+    output->setConnectedNode(switchNode);
+    REQUIRE(doc->validate());
+
+    mx::GenContext context(mx::GlslShaderGenerator::create());
+    context.registerSourceCodeSearchPath(searchPath);
+    context.getOptions().scopeConditionalBranches = true;
+    mx::ShaderPtr shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string source = shader->getSourceCode(mx::Stage::PIXEL);
+
+    // Each lookup is only evaluated inside the branch that selects it.
+    const size_t branch1 = source.find("if (float(separate1_outy) < float(1))");
+    const size_t branch2 = source.find("else if (float(separate1_outy) < float(2))");
+    const size_t nested = source.find("if (separate1_outx > ifgreater1_value2)");
+    const size_t branch3 = source.find("else if (float(separate1_outy) < float(3))");
+    REQUIRE(branch1 != std::string::npos);
+    REQUIRE(branch2 != std::string::npos);
+    REQUIRE(nested != std::string::npos);
+    REQUIRE(branch3 != std::string::npos);
+    REQUIRE(source.find("Omitted node 'image1'") < branch1);
+    REQUIRE(source.find("Omitted node 'ifgreater1'") < branch1);
+    REQUIRE(source.find("vec3 image1_out") > branch1);
+    REQUIRE(source.find("vec3 image1_out") < branch2);
+    REQUIRE(source.find("vec3 ifgreater1_out") > branch2);
+    REQUIRE(source.find("vec3 image2_out") > nested);
+    REQUIRE(source.find("vec3 image2_out") < branch3);
+    REQUIRE(source.find("vec3 image3_out") > branch3);
+
+    // Shared nodes are evaluated once, ahead of the conditional.
+    REQUIRE(source.find("vec2 texcoord1_out") < branch1);
+    REQUIRE(source.find("vec2 texcoord1_out", source.find("vec2 texcoord1_out") + 1) == std::string::npos);
+    REQUIRE(source.find("separate1_outx") < branch1);
+
+    // The results of the selected branches are unchanged.
+    REQUIRE(source.find("switch1_out = image1_out;") > branch1);
+    REQUIRE(source.find("switch1_out = ifgreater1_out;") > branch2);
+    REQUIRE(source.find("ifgreater1_out = image2_out;") > nested);
+    REQUIRE(source.find("switch1_out = image3_out;") > branch3);
+
+    // Without branch scoping, every lookup is evaluated ahead of the
+    // conditional.
+    context.getOptions().scopeConditionalBranches = false;
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string unscopedSource = shader->getSourceCode(mx::Stage::PIXEL);
+    const size_t unscopedBranch1 = unscopedSource.find("if (float(separate1_outy) < float(1))");
+    REQUIRE(unscopedBranch1 != std::string::npos);
+    REQUIRE(unscopedSource.find("Omitted node") == std::string::npos);
+    REQUIRE(unscopedSource.find("vec3 image1_out") < unscopedBranch1);
+    REQUIRE(unscopedSource.find("vec3 image2_out") < unscopedBranch1);
+    REQUIRE(unscopedSource.find("vec3 image3_out") < unscopedBranch1);
+    REQUIRE(unscopedSource.find("vec3 ifgreater1_out") < unscopedBranch1);
+
+    // Shaders without conditionals are unchanged by branch scoping.
+    output->setConnectedNode(images[0]);
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string plainSource = shader->getSourceCode(mx::Stage::PIXEL);
+    context.getOptions().scopeConditionalBranches = true;
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    REQUIRE(shader->getSourceCode(mx::Stage::PIXEL) == plainSource);
+}
+
+namespace
+{
+
+// Generate pixel shaders for the given elements on the given number of
+// threads, each with its own context, optionally sharing an implementation
+// cache.  Elements that fail to generate return an empty string.
+std::vector<std::string> generatePixelShaders(const std::vector<mx::TypedElementPtr>& elements,
+                                              const mx::FileSearchPath& searchPath,
+                                              unsigned threadCount,
+                                              mx::ShaderNodeImplCachePtr implCache)
+{
+    std::vector<std::string> sources(elements.size());
+    std::atomic<size_t> nextElement(0);
+    std::vector<std::exception_ptr> exceptions(threadCount);
+    auto worker = [&](unsigned threadIndex)
+    {
+        try
+        {
+            mx::GenContext context(mx::GlslShaderGenerator::create());
+            context.registerSourceCodeSearchPath(searchPath);
+            context.setNodeImplementationCache(implCache);
+            for (size_t i = nextElement++; i < elements.size(); i = nextElement++)
+            {
+                try
+                {
+                    mx::ShaderPtr shader = context.getShaderGenerator().generate("shader", elements[i], context);
+                    sources[i] = shader->getSourceCode(mx::Stage::PIXEL);
+                }
+                catch (mx::Exception&)
+                {
+                }
+            }
+        }
+        catch (...)
+        {
+            exceptions[threadIndex] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (std::exception_ptr exception : exceptions)
+    {
+        if (exception)
+        {
+            std::rethrow_exception(exception);
+        }
+    }
+    return sources;
+}
+
+} // anonymous namespace
+
+TEST_CASE("GenShader: GLSL Shared Implementation Cache", "[genglsl]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf", "lights" }, searchPath, libraries);
+
+    // Gather the renderable elements of the example and test suite materials.
+    mx::FilePath materialsPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials");
+    std::vector<mx::DocumentPtr> documents;
+    mx::StringVec documentPaths;
+    mx::loadDocuments(materialsPath, searchPath, {}, {}, documents, documentPaths);
+    std::vector<mx::TypedElementPtr> elements;
+    for (mx::DocumentPtr doc : documents)
+    {
+        doc->importLibrary(libraries);
+        std::vector<mx::TypedElementPtr> docElements;
+        try
+        {
+            mx::findRenderableElements(doc, docElements);
+        }
+        catch (mx::Exception&)
+        {
+            continue;
+        }
+        elements.insert(elements.end(), docElements.begin(), docElements.end());
+    }
+    REQUIRE(!elements.empty());
+
+    // Generate with per-thread contexts, without and with a shared cache.
+    const unsigned threadCount = 4;
+    std::vector<std::string> sources = generatePixelShaders(elements, searchPath, threadCount, nullptr);
+    mx::ShaderNodeImplCachePtr implCache = mx::ShaderNodeImplCache::create();
+    std::vector<std::string> sharedSources = generatePixelShaders(elements, searchPath, threadCount, implCache);
+
+    // Shared implementations generate identical shaders.
+    REQUIRE(implCache->size() > 0);
+    REQUIRE(implCache->getHitCount() > 0);
+    size_t shaderCount = 0;
+    for (size_t i = 0; i < elements.size(); i++)
+    {
+        REQUIRE(sharedSources[i] == sources[i]);
+        if (!sources[i].empty())
+        {
+            shaderCount++;
+        }
+    }
+    REQUIRE(shaderCount > 0);
+
+    // A serial context reuses the implementations of the shared cache.
+    const size_t sharedHitCount = implCache->getHitCount();
+    std::vector<std::string> serialSources = generatePixelShaders(elements, searchPath, 1, implCache);
+    REQUIRE(serialSources == sources);
+    REQUIRE(implCache->getHitCount() > sharedHitCount);
+}
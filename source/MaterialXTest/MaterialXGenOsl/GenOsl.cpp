@@ -215,3 +215,66 @@ TEST_CASE("GenShader: OSL Shader Generation", "[genosl]")
 {
     generateOslCode();
 }
+
+TEST_CASE("GenShader: OSL Conditional Branch Scopes", "[genosl]")
+{
+    mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr doc = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib" }, searchPath, doc);
+
+    // Create a switch between two texture lookups, driven by the shared
+    // texture coordinates.
+    mx::NodeGraphPtr graph = doc->addNodeGraph("graph");
+    mx::NodePtr texcoord = graph->addNode("texcoord", "texcoord1", "vector2");
+    mx::NodePtr separate = graph->addNode("separate2", "separate1", "multioutput");
+    separate->setConnectedNode("in", texcoord);
+    mx::NodePtr switchNode = graph->addNode("switch", "switch1", "color3");
+    for (int i = 0; i < 2; i++)
+    {
+        mx::NodePtr image = graph->addNode("image", "image" + std::to_string(i + 1), "color3");
+        image->setInputValue("file", "image" + std::to_string(i + 1) + ".png", mx::FILENAME_TYPE_STRING);
+        image->setConnectedNode("texcoord", texcoord);
+        switchNode->setConnectedNode("in" + std::to_string(i + 1), image);
+    }
+    switchNode->addInput("which", "float")->setConnectedNode(separate);
+    switchNode->getInput("which")->setOutputString("outx");
+    mx::OutputPtr output = graph->addOutput("out", "color3");
+    output->setConnectedNode(switchNode);
+    REQUIRE(doc->validate());
+
+    mx::GenContext context(mx::OslShaderGenerator::create());
+    context.registerSourceCodeSearchPath(searchPath);
+    context.getOptions().scopeConditionalBranches = true;
+    mx::ShaderPtr shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string source = shader->getSourceCode(mx::Stage::PIXEL);
+
+    // Each lookup is only evaluated inside the branch that selects it.
+    const size_t branch1 = source.find("if (float(separate1_outx) < float(1))");
+    const size_t branch2 = source.find("else if (float(separate1_outx) < float(2))");
+    REQUIRE(branch1 != std::string::npos);
+    REQUIRE(branch2 != std::string::npos);
+    REQUIRE(source.find("vector2 texcoord1_out") < branch1);
+    REQUIRE(source.find("mx_image_color3(image1_file") > branch1);
+    REQUIRE(source.find("mx_image_color3(image1_file") < branch2);
+    REQUIRE(source.find("mx_image_color3(image2_file") > branch2);
+    REQUIRE(source.find("switch1_out = image1_out;") < branch2);
+    REQUIRE(source.find("switch1_out = image2_out;") > branch2);
+
+    // Without branch scoping, every lookup is evaluated ahead of the
+    // conditional.
+    context.getOptions().scopeConditionalBranches = false;
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string unscopedSource = shader->getSourceCode(mx::Stage::PIXEL);
+    const size_t unscopedBranch1 = unscopedSource.find("if (float(separate1_outx) < float(1))");
+    REQUIRE(unscopedBranch1 != std::string::npos);
+    REQUIRE(unscopedSource.find("mx_image_color3(image1_file") < unscopedBranch1);
+    REQUIRE(unscopedSource.find("mx_image_color3(image2_file") < unscopedBranch1);
+
+    // Shaders without conditionals are unchanged by branch scoping.
+    output->setConnectedNode(graph->getNode("image1"));
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    const std::string plainSource = shader->getSourceCode(mx::Stage::PIXEL);
+    context.getOptions().scopeConditionalBranches = true;
+    shader = context.getShaderGenerator().generate("shader", output, context);
+    REQUIRE(shader->getSourceCode(mx::Stage::PIXEL) == plainSource);
+}
@@ -12,6 +12,8 @@
 #include <MaterialXFormat/Util.h>
 
 #include <MaterialXGenShader/HwShaderGenerator.h>
+#include <MaterialXGenShader/ShaderBatch.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/ShaderTranslator.h>
 #include <MaterialXGenShader/Util.h>
 
@@ -25,8 +27,14 @@
 #include <MaterialXGenMdl/MdlShaderGenerator.h>
 #endif
 
+#include <atomic>
+#include <chrono>
+#include <cstdio>
 #include <cstdlib>
+#include <exception>
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <vector>
 #include <set>
 
@@ -51,6 +59,12 @@ TEST_CASE("GenShader: Utilities", "[genshader]")
     mx::StringMap subst2 = { {mx::HW::T_ENV_RADIANCE, mx::HW::ENV_RADIANCE} };
     mx::tokenSubstitution(subst2, test2);
     REQUIRE(test2 == result2);
+
+    // Test unknown tokens and lone token prefixes
+    std::string test3 = "$monkey$threeheaded$ $unknown $";
+    std::string result3 = "piratemighty$ $unknown $";
+    mx::tokenSubstitution(subst1, test3);
+    REQUIRE(test3 == result3);
 }
 
 TEST_CASE("GenShader: Valid Libraries", "[genshader]")
@@ -330,3 +344,475 @@ TEST_CASE("GenShader: Deterministic Generation", "[genshader]")
     }
 #endif
 }
+
+void testShaderCache(mx::DocumentPtr libraries, mx::GenContext& context)
+{
+    const mx::FilePath testFile = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials/Examples/StandardSurface/standard_surface_marble_solid.mtlx");
+    const mx::string testElement = "SR_marble1";
+    const size_t numRuns = 10;
+
+    mx::ShaderCache cache;
+    mx::vector<mx::DocumentPtr> testDocs;
+    for (size_t i = 0; i < numRuns; ++i)
+    {
+        mx::DocumentPtr testDoc = mx::createDocument();
+        mx::readFromXmlFile(testDoc, testFile);
+        testDoc->importLibrary(libraries);
+        testDocs.push_back(testDoc);
+    }
+
+    // Generate the same content from separate documents, with and without
+    // the cache.
+    mx::StringVec sourceCode;
+    for (mx::DocumentPtr testDoc : testDocs)
+    {
+        mx::ShaderPtr shader = context.getShaderGenerator().generate(testElement, testDoc->getChild(testElement), context);
+        sourceCode.push_back(shader->getSourceCode());
+    }
+    mx::vector<mx::ShaderPtr> cachedShaders;
+    for (mx::DocumentPtr testDoc : testDocs)
+    {
+        cachedShaders.push_back(cache.generate(testElement, testDoc->getChild(testElement), context));
+    }
+
+    REQUIRE(cache.size() == 1);
+    REQUIRE(cache.getHitCount() == numRuns - 1);
+    for (size_t i = 0; i < numRuns; ++i)
+    {
+        REQUIRE(cachedShaders[i] == cachedShaders[0]);
+        REQUIRE(cachedShaders[i]->getSourceCode() == sourceCode[i]);
+    }
+
+    // Changes to the upstream graph, its definitions, or the generation
+    // options produce new cache entries.
+    mx::DocumentPtr testDoc = testDocs[0];
+    mx::ElementPtr element = testDoc->getChild(testElement);
+    const mx::string key = mx::ShaderCache::computeKey(testElement, element, context);
+    REQUIRE(mx::ShaderCache::computeKey(testElement, testDocs[1]->getChild(testElement), context) == key);
+    REQUIRE(mx::ShaderCache::computeKey("other_name", element, context) != key);
+    REQUIRE(key.find(testElement) != mx::string::npos);
+
+    mx::NodeGraphPtr graph = testDoc->getNodeGraph("NG_marble1");
+    REQUIRE(graph);
+    mx::NodePtr noiseNode = graph->getNode("obj_pos");
+    REQUIRE(noiseNode);
+    noiseNode->setInputValue("space", std::string("world"));
+    mx::string graphKey = mx::ShaderCache::computeKey(testElement, element, context);
+    REQUIRE(graphKey != key);
+
+    mx::DocumentPtr defDoc = testDocs[1];
+    mx::ElementPtr defElement = defDoc->getChild(testElement);
+    mx::NodeDefPtr nodeDef = defDoc->getNodeDef("ND_standard_surface_surfaceshader");
+    REQUIRE(nodeDef);
+    nodeDef->setDocString("Modified definition");
+    REQUIRE(mx::ShaderCache::computeKey(testElement, defElement, context) != key);
+
+    mx::GenContext optionsContext(context);
+    optionsContext.getOptions().hwMaxActiveLightSources = context.getOptions().hwMaxActiveLightSources + 1;
+    optionsContext.getOptions().fileTextureVerticalFlip = !context.getOptions().fileTextureVerticalFlip;
+    REQUIRE(mx::ShaderCache::computeKey(testElement, testDocs[2]->getChild(testElement), optionsContext) != key);
+
+    REQUIRE(cache.generate(testElement, element, context) != cachedShaders[0]);
+    REQUIRE(cache.size() == 2);
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(!cache.find(key));
+}
+
+TEST_CASE("GenShader: Shader Cache", "[genshader]")
+{
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+#ifdef MATERIALX_BUILD_GEN_GLSL
+    {
+        mx::GenContext context(mx::GlslShaderGenerator::create());
+        context.registerSourceCodeSearchPath(searchPath);
+        testShaderCache(libraries, context);
+    }
+#endif
+#ifdef MATERIALX_BUILD_GEN_OSL
+    {
+        mx::GenContext context(mx::OslShaderGenerator::create());
+        context.registerSourceCodeSearchPath(searchPath);
+        testShaderCache(libraries, context);
+    }
+#endif
+}
+
+void testConcurrentGeneration(mx::DocumentPtr libraries, mx::ShaderGeneratorPtr generator, const mx::FileSearchPath& searchPath)
+{
+    const mx::FilePath testPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials/Examples/StandardSurface");
+    const unsigned threadCount = 4;
+    const size_t numRuns = 2;
+
+    mx::vector<mx::DocumentPtr> docs;
+    mx::vector<mx::TypedElementPtr> elements;
+    for (const mx::FilePath& filename : testPath.getFilesInDirectory(mx::MTLX_EXTENSION))
+    {
+        mx::DocumentPtr doc = mx::createDocument();
+        mx::readFromXmlFile(doc, testPath / filename);
+        doc->importLibrary(libraries);
+        docs.push_back(doc);
+        mx::vector<mx::TypedElementPtr> docElements;
+        mx::findRenderableElements(doc, docElements);
+        for (mx::TypedElementPtr element : docElements)
+        {
+            mx::NodePtr materialNode = element->asA<mx::Node>();
+            if (materialNode && materialNode->getType() == mx::MATERIAL_TYPE_STRING)
+            {
+                for (mx::NodePtr shaderNode : mx::getShaderNodes(materialNode))
+                {
+                    elements.push_back(shaderNode);
+                }
+            }
+            else
+            {
+                elements.push_back(element);
+            }
+        }
+    }
+    REQUIRE(!elements.empty());
+
+    // Generate reference code serially for both settings of an option that
+    // changes token substitutions during generation.
+    mx::vector<mx::StringVec> references;
+    for (bool verticalFlip : { false, true })
+    {
+        mx::GenContext context(generator);
+        context.registerSourceCodeSearchPath(searchPath);
+        context.getOptions().fileTextureVerticalFlip = verticalFlip;
+        mx::StringVec sourceCode;
+        for (mx::TypedElementPtr element : elements)
+        {
+            mx::ShaderPtr shader = generator->generate(element->getName(), element, context);
+            sourceCode.push_back(shader ? shader->getSourceCode() : mx::EMPTY_STRING);
+        }
+        references.push_back(sourceCode);
+    }
+
+    // Generate all elements concurrently from the same generator instance,
+    // with a context per thread and alternating options between threads.
+    mx::vector<mx::StringVec> results(threadCount);
+    std::vector<std::exception_ptr> errors(threadCount);
+    auto worker = [&](unsigned threadIndex)
+    {
+        try
+        {
+            mx::GenContext context(generator);
+            context.registerSourceCodeSearchPath(searchPath);
+            context.getOptions().fileTextureVerticalFlip = (threadIndex % 2) != 0;
+            for (size_t run = 0; run < numRuns; run++)
+            {
+                results[threadIndex].clear();
+                for (mx::TypedElementPtr element : elements)
+                {
+                    mx::ShaderPtr shader = generator->generate(element->getName(), element, context);
+                    results[threadIndex].push_back(shader ? shader->getSourceCode() : mx::EMPTY_STRING);
+                }
+            }
+        }
+        catch (...)
+        {
+            errors[threadIndex] = std::current_exception();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned i = 1; i < threadCount; i++)
+    {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+    for (std::exception_ptr error : errors)
+    {
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+
+    for (unsigned i = 0; i < threadCount; i++)
+    {
+        REQUIRE(results[i] == references[i % 2]);
+    }
+}
+
+TEST_CASE("GenShader: Concurrent Generation", "[genshader]")
+{
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+#ifdef MATERIALX_BUILD_GEN_GLSL
+    testConcurrentGeneration(libraries, mx::GlslShaderGenerator::create(), searchPath);
+#endif
+#ifdef MATERIALX_BUILD_GEN_OSL
+    testConcurrentGeneration(libraries, mx::OslShaderGenerator::create(), searchPath);
+#endif
+#ifdef MATERIALX_BUILD_GEN_MDL
+    testConcurrentGeneration(libraries, mx::MdlShaderGenerator::create(), searchPath);
+#endif
+}
+
+void testBatchGeneration(mx::DocumentPtr libraries, mx::GenContext& context)
+{
+    // Gather the renderable elements of the example and test suite materials.
+    mx::FilePath materialsPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials");
+    mx::vector<mx::DocumentPtr> documents;
+    mx::StringVec documentPaths;
+    mx::loadDocuments(materialsPath, context.getSourceCodeSearchPath(), {}, {}, documents, documentPaths);
+    mx::vector<mx::TypedElementPtr> elements;
+    for (mx::DocumentPtr doc : documents)
+    {
+        doc->importLibrary(libraries);
+        mx::vector<mx::TypedElementPtr> docElements;
+        try
+        {
+            mx::findRenderableElements(doc, docElements);
+        }
+        catch (mx::Exception&)
+        {
+            continue;
+        }
+        elements.insert(elements.end(), docElements.begin(), docElements.end());
+    }
+
+    // Add an element whose generation fails.
+    mx::DocumentPtr invalidDoc = mx::createDocument();
+    invalidDoc->importLibrary(libraries);
+    mx::NodePtr invalidNode = invalidDoc->addNode("invalid_shader", "invalid_node", mx::SURFACE_SHADER_TYPE_STRING);
+    elements.push_back(invalidNode);
+    REQUIRE(elements.size() > 1);
+
+    // Generate serially, then on an increasing number of threads, checking
+    // that results match in input order.
+    mx::ShaderBatchResultVec reference;
+    const unsigned maxThreadCount = std::max(std::thread::hardware_concurrency(), 4u);
+    for (unsigned threadCount = 1; threadCount <= maxThreadCount; threadCount *= 2)
+    {
+        mx::ShaderBatchResultVec results = mx::generateShaders(elements, context, threadCount);
+        REQUIRE(results.size() == elements.size());
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            REQUIRE(results[i].element == elements[i]);
+            REQUIRE((results[i].shader != nullptr) == results[i].error.empty());
+        }
+        REQUIRE(!results.back().shader);
+        REQUIRE(!results.back().error.empty());
+
+        if (threadCount == 1)
+        {
+            reference = results;
+        }
+        else
+        {
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                REQUIRE(results[i].error == reference[i].error);
+                if (results[i].shader)
+                {
+                    REQUIRE(results[i].shader->getSourceCode(mx::Stage::PIXEL) == reference[i].shader->getSourceCode(mx::Stage::PIXEL));
+                }
+            }
+        }
+    }
+
+    // Generate all renderable elements of a document.
+    mx::DocumentPtr doc = documents[0];
+    mx::vector<mx::TypedElementPtr> docElements;
+    mx::findRenderableElements(doc, docElements);
+    mx::ShaderBatchResultVec docResults = mx::generateShaders(doc, context, 2);
+    REQUIRE(docResults.size() == docElements.size());
+    for (size_t i = 0; i < docResults.size(); i++)
+    {
+        REQUIRE(docResults[i].element == docElements[i]);
+    }
+
+    // Float formatting of the calling thread applies on every thread.
+    mx::ScopedFloatFormatting formatting(mx::Value::FloatFormatScientific, 3);
+    mx::ShaderBatchResultVec serialResults = mx::generateShaders(elements, context, 1);
+    mx::ShaderBatchResultVec parallelResults = mx::generateShaders(elements, context, maxThreadCount);
+    size_t formattedCount = 0;
+    for (size_t i = 0; i < serialResults.size(); i++)
+    {
+        REQUIRE(serialResults[i].error == parallelResults[i].error);
+        if (serialResults[i].shader)
+        {
+            const std::string& source = serialResults[i].shader->getSourceCode(mx::Stage::PIXEL);
+            REQUIRE(source == parallelResults[i].shader->getSourceCode(mx::Stage::PIXEL));
+            if (source != reference[i].shader->getSourceCode(mx::Stage::PIXEL))
+            {
+                formattedCount++;
+            }
+        }
+    }
+#ifdef MATERIALX_BUILD_GEN_OSL
+    if (context.getShaderGenerator().getTarget() == mx::OslShaderGenerator::TARGET)
+    {
+        REQUIRE(formattedCount > 0);
+    }
+#endif
+}
+
+TEST_CASE("GenShader: Batch Generation", "[genshader]")
+{
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+#ifdef MATERIALX_BUILD_GEN_GLSL
+    {
+        mx::GenContext context(mx::GlslShaderGenerator::create());
+        context.registerSourceCodeSearchPath(searchPath);
+        testBatchGeneration(libraries, context);
+    }
+#endif
+#ifdef MATERIALX_BUILD_GEN_OSL
+    {
+        mx::GenContext context(mx::OslShaderGenerator::create());
+        context.registerSourceCodeSearchPath(searchPath);
+        testBatchGeneration(libraries, context);
+    }
+#endif
+}
+
+TEST_CASE("GenShader: Source File Cache", "[genshader]")
+{
+    mx::SourceFileCache& cache = mx::SourceFileCache::getInstance();
+
+    // Files are read once, and reloaded when modified.
+    const mx::FilePath filename = mx::FilePath::getCurrentPath() / mx::FilePath("source_file_cache_test.glsl");
+    {
+        std::ofstream file(filename.asString());
+        file << "// First line\nvoid main() {}\n";
+    }
+    size_t missCount = cache.getMissCount();
+    size_t hitCount = cache.getHitCount();
+    mx::ConstSourceFilePtr source = cache.read(filename);
+    REQUIRE(source);
+    REQUIRE(source->lines == mx::StringVec({ "// First line", "void main() {}" }));
+    REQUIRE(cache.read(filename) == source);
+    REQUIRE(cache.getMissCount() == missCount + 1);
+    REQUIRE(cache.getHitCount() == hitCount + 1);
+
+    const uint64_t modificationTime = filename.getModificationTime();
+    REQUIRE(modificationTime == source->modificationTime);
+    for (int i = 0; i < 100 && filename.getModificationTime() == modificationTime; i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        std::ofstream file(filename.asString());
+        file << "// Second line\n";
+    }
+    REQUIRE(filename.getModificationTime() != modificationTime);
+    mx::ConstSourceFilePtr modified = cache.read(filename);
+    REQUIRE(modified);
+    REQUIRE(modified->lines == mx::StringVec({ "// Second line" }));
+    REQUIRE(cache.getMissCount() == missCount + 2);
+
+    std::remove(filename.asString().c_str());
+    REQUIRE(!cache.read(filename));
+
+    // Repeated generation reads each library source file once.
+#ifdef MATERIALX_BUILD_GEN_GLSL
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+    mx::DocumentPtr doc = mx::createDocument();
+    const mx::FilePath testPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials/Examples/StandardSurface");
+    mx::readFromXmlFile(doc, testPath / mx::FilePath("standard_surface_default.mtlx"));
+    doc->importLibrary(libraries);
+
+    mx::GenContext context(mx::GlslShaderGenerator::create());
+    context.registerSourceCodeSearchPath(searchPath);
+    mx::ShaderBatchResultVec first = mx::generateShaders(doc, context, 1);
+    REQUIRE(!first.empty());
+    REQUIRE(first[0].shader);
+
+    missCount = cache.getMissCount();
+    hitCount = cache.getHitCount();
+    mx::ShaderBatchResultVec second = mx::generateShaders(doc, context, 1);
+    REQUIRE(second[0].shader);
+    REQUIRE(second[0].shader->getSourceCode() == first[0].shader->getSourceCode());
+    REQUIRE(cache.getMissCount() == missCount);
+    REQUIRE(cache.getHitCount() > hitCount);
+#endif
+}
+
+TEST_CASE("GenShader: Function Definition Cache", "[genshader]")
+{
+    const mx::FileSearchPath searchPath(mx::FilePath::getCurrentPath() / mx::FilePath("libraries"));
+    mx::DocumentPtr libraries = mx::createDocument();
+    mx::loadLibraries({ "targets", "stdlib", "pbrlib", "bxdf" }, searchPath, libraries);
+
+    mx::DocumentPtr doc = mx::createDocument();
+    const mx::FilePath testPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials/Examples/StandardSurface");
+    mx::readFromXmlFile(doc, testPath / mx::FilePath("standard_surface_brick_procedural.mtlx"));
+    doc->importLibrary(libraries);
+    mx::NodePtr shaderNode = doc->getNode("N_StandardSurface");
+    REQUIRE(shaderNode);
+    mx::NodePtr mixNode = doc->getNodeGraph("NG_BrickPattern")->getNode("node_mix_8");
+    REQUIRE(mixNode);
+    mx::InputPtr fgInput = mixNode->getInput("fg");
+    REQUIRE(fgInput);
+
+    mx::vector<mx::ShaderGeneratorPtr> generators;
+#ifdef MATERIALX_BUILD_GEN_GLSL
+    generators.push_back(mx::GlslShaderGenerator::create());
+#endif
+#ifdef MATERIALX_BUILD_GEN_OSL
+    generators.push_back(mx::OslShaderGenerator::create());
+#endif
+    for (mx::ShaderGeneratorPtr generator : generators)
+    {
+        mx::GenContext context(generator);
+        context.registerSourceCodeSearchPath(searchPath);
+        mx::ShaderPtr shader = generator->generate("brick", shaderNode, context);
+
+        // Return the total hit count of the caches used by the nodes of
+        // all shaders generated so far.
+        std::set<mx::FunctionDefinitionCachePtr> caches;
+        auto getHitCount = [&caches](mx::ShaderPtr generated)
+        {
+            for (const mx::ShaderNode* node : generated->getGraph().getNodes())
+            {
+                mx::FunctionDefinitionCachePtr cache = node->getImplementation().getFunctionDefinitionCache();
+                if (cache)
+                {
+                    caches.insert(cache);
+                }
+            }
+            size_t hitCount = 0;
+            for (mx::FunctionDefinitionCachePtr cache : caches)
+            {
+                hitCount += cache->getHitCount();
+            }
+            return hitCount;
+        };
+
+        // Regenerate after editing a connection, adding cached definitions
+        // to the new shader, and compare with a shader generated from
+        // scratch.
+        const int numEdits = 10;
+        for (int i = 0; i < numEdits; i++)
+        {
+            const size_t previousHitCount = getHitCount(shader);
+            fgInput->setNodeName(i % 2 ? "node_multiply_5" : "node_multiply_9");
+            shader = generator->generate("brick", shaderNode, context);
+            REQUIRE(shader);
+            REQUIRE(getHitCount(shader) > previousHitCount);
+
+            mx::GenContext referenceContext(generator);
+            referenceContext.registerSourceCodeSearchPath(searchPath);
+            mx::ShaderPtr reference = generator->generate("brick", shaderNode, referenceContext);
+            REQUIRE(reference);
+            REQUIRE(shader->getSourceCode(mx::Stage::PIXEL) == reference->getSourceCode(mx::Stage::PIXEL));
+        }
+    }
+}
@@ -329,6 +329,70 @@ void testUniqueNames(mx::GenContext& context, const std::string& stage)
     REQUIRE(sgNode1->getOutput()->getVariable() == "unique_names_out");
 }
 
+size_t compareMaterialShaders(mx::DocumentPtr libraries, mx::GenContext& context, mx::GenContext& otherContext,
+                              const std::function<void(mx::ShaderPtr, mx::ShaderPtr)>& compare)
+{
+    mx::FilePath materialsPath = mx::FilePath::getCurrentPath() / mx::FilePath("resources/Materials");
+    std::vector<mx::DocumentPtr> documents;
+    mx::StringVec documentPaths;
+    mx::loadDocuments(materialsPath, context.getSourceCodeSearchPath(), {}, {}, documents, documentPaths);
+
+    size_t elementCount = 0;
+    for (mx::DocumentPtr doc : documents)
+    {
+        doc->importLibrary(libraries);
+
+        // Skip documents whose renderable elements depend on libraries
+        // other than the given ones.
+        std::vector<mx::TypedElementPtr> elements;
+        try
+        {
+            mx::findRenderableElements(doc, elements);
+        }
+        catch (mx::ExceptionShaderGenError&)
+        {
+            continue;
+        }
+        for (mx::TypedElementPtr element : elements)
+        {
+            // Generate materials from their surface shaders.
+            mx::NodePtr materialNode = element->asA<mx::Node>();
+            if (materialNode && materialNode->getType() == mx::MATERIAL_TYPE_STRING)
+            {
+                std::vector<mx::NodePtr> shaderNodes = mx::getShaderNodes(materialNode, mx::SURFACE_SHADER_TYPE_STRING);
+                if (shaderNodes.empty())
+                {
+                    continue;
+                }
+                element = shaderNodes[0];
+            }
+
+            // Skip elements that the generator does not support, while any
+            // failure that only occurs with the other context fails the test.
+            mx::ShaderPtr shader, otherShader;
+            try
+            {
+                shader = context.getShaderGenerator().generate(element->getName(), element, context);
+            }
+            catch (mx::ExceptionShaderGenError&)
+            {
+                continue;
+            }
+            try
+            {
+                otherShader = otherContext.getShaderGenerator().generate(element->getName(), element, otherContext);
+            }
+            catch (mx::Exception& e)
+            {
+                FAIL("Failed to generate " + element->getNamePath() + " in " + element->getActiveSourceUri() + ": " + e.what());
+            }
+            compare(shader, otherShader);
+            elementCount++;
+        }
+    }
+    return elementCount;
+}
+
 void ShaderGeneratorTester::getImplementationWhiteList(mx::StringSet& whiteList)
 {
     whiteList.insert(_colorManagementImplWhiteList.begin(), _colorManagementImplWhiteList.end());
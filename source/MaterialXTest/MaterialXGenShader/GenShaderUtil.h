@@ -22,6 +22,7 @@
 
 #include <cstdlib>
 #include <fstream>
+#include <functional>
 #include <iostream>
 
 namespace mx = MaterialX;
@@ -55,6 +56,14 @@ void checkImplementations(mx::GenContext& context,
 // Utility test to  check unique name generation on a shader generator
 void testUniqueNames(mx::GenContext& context, const std::string& stage);
 
+// Generate shaders for every renderable element of the example and test suite
+// materials with each of the two given contexts, passing each pair of shaders
+// to the given function.  Elements that fail to generate with the first
+// context are skipped, while failures with the second context fail the test.
+// Returns the number of elements compared.
+size_t compareMaterialShaders(mx::DocumentPtr libraries, mx::GenContext& context, mx::GenContext& otherContext,
+                              const std::function<void(mx::ShaderPtr, mx::ShaderPtr)>& compare);
+
 //
 // Render validation options. Reflects the _options.mtlx
 // file in the test suite area.
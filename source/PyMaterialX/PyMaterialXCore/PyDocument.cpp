@@ -19,6 +19,10 @@ void bindPyDocument(py::module& mod)
         .def("copy", &mx::Document::copy)
         .def("importLibrary", &mx::Document::importLibrary)
         .def("getReferencedSourceUris", &mx::Document::getReferencedSourceUris)
+        .def("addReferencedLibrary", &mx::Document::addReferencedLibrary)
+        .def("getReferencedLibraries", &mx::Document::getReferencedLibraries)
+        .def("clearReferencedLibraries", &mx::Document::clearReferencedLibraries)
+        .def("getReferencedLibraryChild", &mx::Document::getReferencedLibraryChild)
         .def("addNodeGraph", &mx::Document::addNodeGraph,
             py::arg("name") = mx::EMPTY_STRING)
         .def("getNodeGraph", &mx::Document::getNodeGraph)
@@ -88,6 +92,13 @@ void bindPyDocument(py::module& mod)
         .def("getUnitTypeDefs", &mx::Document::getUnitTypeDefs)
         .def("removeUnitTypeDef", &mx::Document::removeUnitTypeDef)
         .def("upgradeVersion", &mx::Document::upgradeVersion)
+        .def("validateParallel", [](mx::Document& doc, unsigned int threadCount)
+            {
+                std::string message;
+                bool res = doc.validateParallel(&message, threadCount);
+                return std::pair<bool, std::string>(res, message);
+            },
+            py::arg("threadCount") = 0)
         .def("setColorManagementSystem", &mx::Document::setColorManagementSystem)
         .def("hasColorManagementSystem", &mx::Document::hasColorManagementSystem)
         .def("getColorManagementSystem", &mx::Document::getColorManagementSystem)
@@ -81,5 +81,22 @@ void bindPyLook(py::module& mod)
         .def("getVisible", &mx::Visibility::getVisible)
         .def_readonly_static("CATEGORY", &mx::Visibility::CATEGORY);
 
+    py::class_<mx::GeomAssigns>(mod, "GeomAssigns")
+        .def_readonly("materialAssigns", &mx::GeomAssigns::materialAssigns)
+        .def_readonly("propertyAssigns", &mx::GeomAssigns::propertyAssigns)
+        .def_readonly("propertySetAssigns", &mx::GeomAssigns::propertySetAssigns)
+        .def_readonly("visibilities", &mx::GeomAssigns::visibilities);
+
+    py::class_<mx::GeomAssignIndex, mx::GeomAssignIndexPtr>(mod, "GeomAssignIndex")
+        .def_static("create", &mx::GeomAssignIndex::create)
+        .def("resolve", static_cast<mx::GeomAssigns (mx::GeomAssignIndex::*)(const std::string&) const>(&mx::GeomAssignIndex::resolve))
+        .def("resolve", static_cast<std::vector<mx::GeomAssigns> (mx::GeomAssignIndex::*)(const mx::StringVec&, unsigned int) const>(&mx::GeomAssignIndex::resolve),
+            py::arg("geoms"), py::arg("threadCount") = 1);
+
+    mod.def("resolveGeomAssigns", static_cast<std::vector<mx::GeomAssigns> (*)(mx::LookPtr, const mx::StringVec&, unsigned int)>(&mx::resolveGeomAssigns),
+        py::arg("look"), py::arg("geoms"), py::arg("threadCount") = 1);
+    mod.def("resolveGeomAssigns", static_cast<std::vector<mx::GeomAssigns> (*)(mx::LookGroupPtr, const mx::StringVec&, unsigned int)>(&mx::resolveGeomAssigns),
+        py::arg("lookGroup"), py::arg("geoms"), py::arg("threadCount") = 1);
+
     mod.def("getGeometryBindings", &mx::getGeometryBindings);
 }
@@ -0,0 +1,22 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <PyMaterialX/PyMaterialX.h>
+
+#include <MaterialXFormat/BinaryIo.h>
+#include <MaterialXCore/Document.h>
+
+namespace py = pybind11;
+namespace mx = MaterialX;
+
+void bindPyBinaryIo(py::module& mod)
+{
+    mod.def("writeToBinaryFile", &mx::writeToBinaryFile,
+        py::arg("doc"), py::arg("filename"), py::arg("dependencies") = mx::FilePathVec(), py::arg("key") = mx::EMPTY_STRING);
+    mod.def("readFromBinaryFile", &mx::readFromBinaryFile,
+        py::arg("doc"), py::arg("filename"), py::arg("dependencies") = mx::FilePathVec(), py::arg("key") = mx::EMPTY_STRING);
+
+    mod.attr("MTLX_SNAPSHOT_EXTENSION") = mx::MTLX_SNAPSHOT_EXTENSION;
+}
@@ -17,12 +17,15 @@ void bindPyXmlIo(py::module& mod)
         .def(py::init())
         .def_readwrite("readXIncludeFunction", &mx::XmlReadOptions::readXIncludeFunction)
         .def_readwrite("readComments", &mx::XmlReadOptions::readComments)
-        .def_readwrite("parentXIncludes", &mx::XmlReadOptions::parentXIncludes);
+        .def_readwrite("parentXIncludes", &mx::XmlReadOptions::parentXIncludes)
+        .def_readwrite("shareXIncludes", &mx::XmlReadOptions::shareXIncludes)
+        .def_readwrite("streaming", &mx::XmlReadOptions::streaming);
 
     py::class_<mx::XmlWriteOptions>(mod, "XmlWriteOptions")
         .def(py::init())
         .def_readwrite("writeXIncludeEnable", &mx::XmlWriteOptions::writeXIncludeEnable)
-        .def_readwrite("elementPredicate", &mx::XmlWriteOptions::elementPredicate);
+        .def_readwrite("elementPredicate", &mx::XmlWriteOptions::elementPredicate)
+        .def_readwrite("streaming", &mx::XmlWriteOptions::streaming);
 
     mod.def("readFromXmlFileBase", &mx::readFromXmlFile,
         py::arg("doc"), py::arg("filename"), py::arg("searchPath") = mx::FileSearchPath(), py::arg("readOptions") = (mx::XmlReadOptions*) nullptr);
@@ -32,6 +35,7 @@ void bindPyXmlIo(py::module& mod)
         py::arg("doc"), py::arg("filename"), py::arg("writeOptions") = (mx::XmlWriteOptions*) nullptr);
     mod.def("writeToXmlString", mx::writeToXmlString,
         py::arg("doc"), py::arg("writeOptions") = nullptr);
+    mod.def("clearXIncludeCache", mx::clearXIncludeCache);
     mod.def("prependXInclude", mx::prependXInclude);
 
     mod.def("getEnvironmentPath", &mx::getEnvironmentPath,
@@ -6,6 +6,7 @@
 #include <PyMaterialX/PyMaterialX.h>
 
 #include <MaterialXGenShader/GenContext.h>
+#include <MaterialXGenShader/ShaderCache.h>
 #include <MaterialXGenShader/HwShaderGenerator.h>
 
 namespace py = pybind11;
@@ -19,7 +20,10 @@ void bindPyGenContext(py::module& mod)
         .def("getOptions", static_cast<mx::GenOptions& (mx::GenContext::*)()>(&mx::GenContext::getOptions), py::return_value_policy::reference)
         .def("registerSourceCodeSearchPath", static_cast<void (mx::GenContext::*)(const mx::FilePath&)>(&mx::GenContext::registerSourceCodeSearchPath))
         .def("registerSourceCodeSearchPath", static_cast<void (mx::GenContext::*)(const mx::FileSearchPath&)>(&mx::GenContext::registerSourceCodeSearchPath))
-        .def("resolveSourceFile", &mx::GenContext::resolveSourceFile);
+        .def("resolveSourceFile", &mx::GenContext::resolveSourceFile)
+        .def("getSourceCodeSearchPath", &mx::GenContext::getSourceCodeSearchPath)
+        .def("setNodeImplementationCache", &mx::GenContext::setNodeImplementationCache)
+        .def("getNodeImplementationCache", &mx::GenContext::getNodeImplementationCache);
 }
 
 void bindPyGenUserData(py::module& mod)
@@ -10,6 +10,8 @@ namespace py = pybind11;
 void bindPyColorManagement(py::module& mod);
 void bindPyShaderPort(py::module& mod);
 void bindPyShader(py::module& mod);
+void bindPyShaderBatch(py::module& mod);
+void bindPyShaderCache(py::module& mod);
 void bindPyShaderGenerator(py::module& mod);
 void bindPyGenContext(py::module& mod);
 void bindPyHwShaderGenerator(py::module& mod);
@@ -29,6 +31,8 @@ PYBIND11_MODULE(PyMaterialXGenShader, mod)
     bindPyColorManagement(mod);
     bindPyShaderPort(mod);
     bindPyShader(mod);
+    bindPyShaderBatch(mod);
+    bindPyShaderCache(mod);
     bindPyShaderGenerator(mod);
     bindPyGenContext(mod);
     bindPyHwShaderGenerator(mod);
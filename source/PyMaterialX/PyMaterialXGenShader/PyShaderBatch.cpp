@@ -0,0 +1,24 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <PyMaterialX/PyMaterialX.h>
+
+#include <MaterialXGenShader/ShaderBatch.h>
+
+namespace py = pybind11;
+namespace mx = MaterialX;
+
+void bindPyShaderBatch(py::module& mod)
+{
+    py::class_<mx::ShaderBatchResult>(mod, "ShaderBatchResult")
+        .def_readonly("element", &mx::ShaderBatchResult::element)
+        .def_readonly("shader", &mx::ShaderBatchResult::shader)
+        .def_readonly("error", &mx::ShaderBatchResult::error);
+
+    mod.def("generateShaders", static_cast<mx::ShaderBatchResultVec (*)(const std::vector<mx::TypedElementPtr>&, const mx::GenContext&, unsigned int)>(&mx::generateShaders),
+        py::arg("elements"), py::arg("context"), py::arg("threadCount") = 0, py::call_guard<py::gil_scoped_release>());
+    mod.def("generateShaders", static_cast<mx::ShaderBatchResultVec (*)(mx::ConstDocumentPtr, const mx::GenContext&, unsigned int)>(&mx::generateShaders),
+        py::arg("doc"), py::arg("context"), py::arg("threadCount") = 0, py::call_guard<py::gil_scoped_release>());
+}
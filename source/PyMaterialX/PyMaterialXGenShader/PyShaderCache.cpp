@@ -0,0 +1,45 @@
+//
+// TM & (c) 2017 Lucasfilm Entertainment Company Ltd. and Lucasfilm Ltd.
+// All rights reserved.  See LICENSE.txt for license.
+//
+
+#include <PyMaterialX/PyMaterialX.h>
+
+#include <MaterialXGenShader/ShaderCache.h>
+
+namespace py = pybind11;
+namespace mx = MaterialX;
+
+void bindPyShaderCache(py::module& mod)
+{
+    py::class_<mx::ShaderCache, mx::ShaderCachePtr>(mod, "ShaderCache")
+        .def_static("create", &mx::ShaderCache::create)
+        .def("generate", &mx::ShaderCache::generate)
+        .def_static("computeKey", &mx::ShaderCache::computeKey)
+        .def("find", &mx::ShaderCache::find)
+        .def("add", &mx::ShaderCache::add)
+        .def("size", &mx::ShaderCache::size)
+        .def("getHitCount", &mx::ShaderCache::getHitCount)
+        .def("clear", &mx::ShaderCache::clear);
+
+    py::class_<mx::ShaderNodeImplCache, mx::ShaderNodeImplCachePtr>(mod, "ShaderNodeImplCache")
+        .def_static("create", &mx::ShaderNodeImplCache::create)
+        .def_static("isShareable", &mx::ShaderNodeImplCache::isShareable)
+        .def_static("computeKey", &mx::ShaderNodeImplCache::computeKey)
+        .def("size", &mx::ShaderNodeImplCache::size)
+        .def("getHitCount", &mx::ShaderNodeImplCache::getHitCount)
+        .def("clear", &mx::ShaderNodeImplCache::clear);
+
+    py::class_<mx::SourceFile, mx::ConstSourceFilePtr>(mod, "SourceFile")
+        .def_readonly("content", &mx::SourceFile::content)
+        .def_readonly("lines", &mx::SourceFile::lines)
+        .def_readonly("modificationTime", &mx::SourceFile::modificationTime);
+
+    py::class_<mx::SourceFileCache>(mod, "SourceFileCache")
+        .def_static("getInstance", &mx::SourceFileCache::getInstance, py::return_value_policy::reference)
+        .def("read", &mx::SourceFileCache::read)
+        .def("size", &mx::SourceFileCache::size)
+        .def("getHitCount", &mx::SourceFileCache::getHitCount)
+        .def("getMissCount", &mx::SourceFileCache::getMissCount)
+        .def("clear", &mx::SourceFileCache::clear);
+}